@@ -4,18 +4,41 @@
 
     This example shows how you can rotate a point around another
     point when you only know the x- and y-coordinates of the points.
+    To rotate many points at once, in 2D or 3D, see project.h.
 */
 
 #include <allegro.h>
+#include "../common/headless.h"
+#include "../common/gameloop.h"
+#include "../common/dirty.h"
+#include "project.h"
 
-void projection_test()
+// the four dots, and the angle they are rotated by
+typedef struct PROJECTION
 {
-    // initialize the coordinates of four dots
-    fixed dot_x[4] = {itofix(-50), itofix(-50), itofix(50), itofix(50)};
-    fixed dot_y[4] = {itofix(-50), itofix(50), itofix(50), itofix(-50)};
+    fixed dot_x[4], dot_y[4];
+    fixed angle, old_angle; // the angle now and after the previous update
+    fixed angle_stepsize;
+    // remembers where the dots were drawn, so that the next frame only
+    // has to erase those instead of clearing the screen
+    // (see ../common/dirty.h)
+    DIRTY *dirty;
+} PROJECTION;
+
+// update_projection is called 100 times per second by run_game_loop
+// (see ../common/gameloop.h)
+int update_projection (void *data)
+{
+    PROJECTION *p = data;
+    p->old_angle = p->angle;
+    p->angle += p->angle_stepsize;
+    return key[KEY_ESC];
+}
 
-    fixed angle = 0;
-    fixed angle_stepsize = itofix (1);
+void draw_projection (void *data, fixed alpha)
+{
+    PROJECTION *p = data;
+    fixed angle = lerp_angle (p->old_angle, p->angle, alpha);
 
     // proj_x and proj_y will contain the projection of the dots
     fixed proj_x[4];
@@ -23,53 +46,68 @@ void projection_test()
 
     int i;
 
-    // repeat this loop until Esc is pressed
-    while (!key[KEY_ESC])
+    restore_dirty (p->dirty, screen);
+
+    // project all the dots to their new positions after rotation:
+    // proj_x[i] = fmul (p->dot_x[i], fcos (angle)) -
+    //     fmul (p->dot_y[i], fsin (angle));
+    // proj_y[i] = fmul (p->dot_x[i], fsin (angle)) +
+    //     fmul (p->dot_y[i], fcos (angle));
+    // rotate_points() does this for all of them at once, and moves them
+    // to the middle of the screen (see project.h)
+    rotate_points (p->dot_x, p->dot_y, proj_x, proj_y, 4, angle,
+        itofix (SCREEN_W / 2), itofix (SCREEN_H / 2));
+
+    // draw the four dots
+    for (i = 0; i < 4; i++)
     {
-        // project all the dots to their new positions after rotation
-        for (i = 0; i < 4; i++)
-        {
-            proj_x[i] = fmul (dot_x[i], fcos (angle)) -
-                fmul (dot_y[i], fsin (angle));
-            proj_y[i] = fmul (dot_x[i], fsin (angle)) +
-                fmul (dot_y[i], fcos (angle));
-        }
-
-        // draw the four dots
-        for (i = 0; i < 4; i++)
-        {
-            putpixel (screen,
-                fixtoi (proj_x[i]) + SCREEN_W / 2,
-                fixtoi (proj_y[i]) + SCREEN_H / 2,
-                makecol (255 ,255, 255));
-        }
-
-        rest (10);
-        clear (screen);
-
-        angle += angle_stepsize;
+        dirty_putpixel (p->dirty, screen,
+            fixtoi (proj_x[i]), fixtoi (proj_y[i]),
+            makecol (255 ,255, 255));
     }
 }
 
-int main ()
+void projection_test()
+{
+    // initialize the coordinates of four dots
+    PROJECTION p = {
+        {itofix(-50), itofix(-50), itofix(50), itofix(50)},
+        {itofix(-50), itofix(50), itofix(50), itofix(-50)},
+        0, 0, itofix (1), NULL
+    };
+    // the empty screen
+    BITMAP *background = create_bitmap (SCREEN_W, SCREEN_H);
+    clear_bitmap (background);
+    p.dirty = create_dirty (background);
+
+    // repeat this loop until Esc is pressed
+    run_game_loop (100, 5, TRUE, update_projection, draw_projection, &p, NULL);
+
+    destroy_dirty (p.dirty);
+    destroy_bitmap (background);
+}
+
+int main (int argc, char *argv[])
 {
     // initialize Allegro
-    if (allegro_init () < 0)
+    // (see headless.h for the command line options)
+    if (headless_init (argc, argv) < 0)
     {
         allegro_message ("Error: Could not initialize Allegro");
         return -1;
     }
     // initialize gfx mode
-    if (set_gfx_mode (GFX_AUTODETECT, 320, 200, 0, 0) < 0)
+    if (headless_set_gfx_mode (GFX_AUTODETECT, 320, 200, 0, 0) < 0)
     {
         allegro_message ("Error: Could not set graphics mode");
         return -1;
     }
     // initialize keyboard
-    install_keyboard ();
+    headless_install_keyboard ();
     clear_keybuf ();
 
-    install_timer ();
+    // initialize timer for run_game_loop()
+    headless_install_timer ();
 
     // call the example function
     projection_test ();
@@ -12,9 +12,13 @@
     Q / W : change the x scale
     E / R : change the y scale
     Z / X : change the camera height
+    B     : measure the time per frame, with and without the line table
 */
 
 #include <allegro.h>
+#include "span.h"
+#include <time.h>
+#include "../common/headless.h"
 
 /* MODE_7_PARAMS is a struct containing all the different parameters
 that are relevant for Mode 7, so you can pass them to the functions
@@ -78,6 +82,125 @@ void mode_7 (BITMAP *bmp, BITMAP *tile, fixed angle, fixed cx, fixed cy, MODE_7_
     }
 }
 
+/* MODE_7_TABLE holds everything mode_7 calculates for each line that only
+depends on the MODE_7_PARAMS and the height of the bitmap. As long as
+those don't change, the table can be reused for every frame. */
+typedef struct MODE_7_TABLE
+{
+    // the parameters the table was calculated for
+    fixed space_z, scale_x, scale_y;
+    int horizon;
+    int h;
+    // the distance and horizontal scale of each line
+    fixed *distance;
+    fixed *horizontal_scale;
+} MODE_7_TABLE;
+
+MODE_7_TABLE *create_mode_7_table ()
+{
+    MODE_7_TABLE *table = malloc (sizeof (MODE_7_TABLE));
+    table->h = 0;
+    table->distance = NULL;
+    table->horizontal_scale = NULL;
+    return table;
+}
+
+void destroy_mode_7_table (MODE_7_TABLE *table)
+{
+    free (table->distance);
+    free (table->horizontal_scale);
+    free (table);
+}
+
+/* update_mode_7_table fills the table for a bitmap of height h,
+but only if the parameters are different from last time */
+void update_mode_7_table (MODE_7_TABLE *table, int h, MODE_7_PARAMS params)
+{
+    int screen_y;
+
+    if (table->h == h &&
+        table->space_z == params.space_z &&
+        table->scale_x == params.scale_x &&
+        table->scale_y == params.scale_y &&
+        table->horizon == params.horizon)
+        return;
+
+    if (table->h != h)
+    {
+        table->distance = realloc (table->distance, h * sizeof (fixed));
+        table->horizontal_scale =
+            realloc (table->horizontal_scale, h * sizeof (fixed));
+    }
+    table->h = h;
+    table->space_z = params.space_z;
+    table->scale_x = params.scale_x;
+    table->scale_y = params.scale_y;
+    table->horizon = params.horizon;
+
+    // these are exactly the same calculations as in mode_7
+    for (screen_y = 0; screen_y < h; screen_y++)
+    {
+        table->distance[screen_y] = fmul (params.space_z, params.scale_y) /
+            (screen_y + params.horizon);
+        table->horizontal_scale[screen_y] =
+            fdiv (table->distance[screen_y], params.scale_x);
+    }
+}
+
+/* mode_7_cached draws the same thing as mode_7, but it looks up the
+distance and horizontal scale of each line in the table, and uses
+affine_span (see span.c) to draw each line. */
+void mode_7_cached (BITMAP *bmp, BITMAP *tile, fixed angle, fixed cx, fixed cy,
+    MODE_7_PARAMS params, MODE_7_TABLE *table)
+{
+    int screen_y;
+    fixed line_dx, line_dy;
+    fixed space_x, space_y;
+
+    // the angle is the same for all lines, so we need sin and cos only once
+    fixed sin_angle = fsin (angle);
+    fixed cos_angle = fcos (angle);
+
+    update_mode_7_table (table, bmp->h, params);
+
+    for (screen_y = 0; screen_y < bmp->h; screen_y++)
+    {
+        fixed distance = table->distance[screen_y];
+        fixed horizontal_scale = table->horizontal_scale[screen_y];
+
+        line_dx = fmul (-sin_angle, horizontal_scale);
+        line_dy = fmul (cos_angle, horizontal_scale);
+
+        space_x = cx + fmul (distance, cos_angle) - bmp->w/2 * line_dx;
+        space_y = cy + fmul (distance, sin_angle) - bmp->w/2 * line_dy;
+
+        // draw the whole line at once
+        affine_span (bmp, 0, screen_y, bmp->w, tile,
+            space_x, space_y, line_dx, line_dy);
+    }
+}
+
+/* benchmark_mode_7 draws the same frames with mode_7 and with mode_7_cached
+and returns the average time per frame of each in milliseconds */
+void benchmark_mode_7 (BITMAP *bmp, BITMAP *tile, fixed cx, fixed cy,
+    MODE_7_PARAMS params, MODE_7_TABLE *table,
+    double *uncached_ms, double *cached_ms)
+{
+    const int frames = 100;
+    clock_t start;
+    int i;
+
+    start = clock ();
+    for (i = 0; i < frames; i++)
+        mode_7 (bmp, tile, itofix (i), cx, cy, params);
+    *uncached_ms = (clock () - start) * 1000.0 / CLOCKS_PER_SEC / frames;
+
+    start = clock ();
+    for (i = 0; i < frames; i++)
+        mode_7_cached (bmp, tile, itofix (i), cx, cy, params, table);
+    *cached_ms = (clock () - start) * 1000.0 / CLOCKS_PER_SEC / frames;
+}
+
 void test_mode_7 ()
 {
     MODE_7_PARAMS params;
@@ -89,6 +212,9 @@ void test_mode_7 ()
     fixed dx = 0, dy = 0;
     fixed speed = 0;
     int i, j, r2;
+    MODE_7_TABLE *table = create_mode_7_table ();
+    // results of the last benchmark, in milliseconds per frame
+    double uncached_ms = 0, cached_ms = 0;
 
     params.space_z = itofix (50);
     params.scale_x = ftofix (200.0);
@@ -152,6 +278,9 @@ void test_mode_7 ()
             params.horizon++;
         if (key[KEY_J])
             params.horizon--;
+        if (key[KEY_B])
+            benchmark_mode_7 (buffer, tile, x, y, params, table,
+                &uncached_ms, &cached_ms);
 
         dx = fmul (speed, fcos (angle));
         dy = fmul (speed, fsin (angle));
@@ -159,31 +288,37 @@ void test_mode_7 ()
         x += dx;
         y += dy;
 
-        mode_7 (buffer, tile, angle, x, y, params);
-        vsync ();
+        mode_7_cached (buffer, tile, angle, x, y, params, table);
+        if (cached_ms > 0)
+            textprintf (buffer, font, 0, 0, 63,
+                "uncached: %.2f ms  cached: %.2f ms", uncached_ms, cached_ms);
+        headless_vsync ();
         blit (buffer, screen, 0, 0, 0, 0, SCREEN_W, SCREEN_H);
+        headless_frame ();
 
     }
+    destroy_mode_7_table (table);
     destroy_bitmap (tile);
     destroy_bitmap (buffer);
 }
 
-int main ()
+int main (int argc, char *argv[])
 {
     // initialize Allegro
-    if (allegro_init () < 0)
+    // (see headless.h for the command line options)
+    if (headless_init (argc, argv) < 0)
     {
         allegro_message ("Error: Could not initialize Allegro");
         return -1;
     }
     // initialize gfx mode
-    if (set_gfx_mode (GFX_AUTODETECT, 320, 200, 0, 0) < 0)
+    if (headless_set_gfx_mode (GFX_AUTODETECT, 320, 200, 0, 0) < 0)
     {
         allegro_message ("Error: Could not set graphics mode");
         return -1;
     }
     // initialize keyboard
-    install_keyboard ();
+    headless_install_keyboard ();
     clear_keybuf ();
 
     // call the example function
@@ -15,9 +15,17 @@
     Q / W : change the x scale
     E / R : change the y scale
     Z / X : change the camera height
+    B     : measure the time per frame, with and without the line table
+    1 - 8 : draw with this many threads
+    T     : measure how the time per frame scales with the number of threads
 */
 
 #include <allegro.h>
+#include <time.h>
+#include "span.h"
+#include "../common/workers.h"
+#include "../common/walltime.h"
+#include "../common/headless.h"
 
 /* MODE_7_PARAMS is a struct containing all the different parameters
 that are relevant for Mode 7, so you can pass them to the functions
@@ -116,6 +124,220 @@ void mode_7 (BITMAP *bmp, BITMAP *tile, fixed angle, fixed cx, fixed cy, MODE_7_
     }
 }
 
+/* MODE_7_TABLE holds everything mode_7 calculates for each line that only
+depends on the MODE_7_PARAMS and the height of the bitmap. As long as
+those don't change, the table can be reused for every frame. */
+typedef struct MODE_7_TABLE
+{
+    // the parameters the table was calculated for
+    fixed space_z, scale_x, scale_y;
+    int horizon;
+    int h;
+    // the distance and horizontal scale of each line
+    fixed *distance;
+    fixed *horizontal_scale;
+} MODE_7_TABLE;
+
+MODE_7_TABLE *create_mode_7_table ()
+{
+    MODE_7_TABLE *table = malloc (sizeof (MODE_7_TABLE));
+    table->h = 0;
+    table->distance = NULL;
+    table->horizontal_scale = NULL;
+    return table;
+}
+
+void destroy_mode_7_table (MODE_7_TABLE *table)
+{
+    free (table->distance);
+    free (table->horizontal_scale);
+    free (table);
+}
+
+/* update_mode_7_table fills the table for a bitmap of height h,
+but only if the parameters are different from last time */
+void update_mode_7_table (MODE_7_TABLE *table, int h, MODE_7_PARAMS params)
+{
+    int screen_y;
+
+    if (table->h == h &&
+        table->space_z == params.space_z &&
+        table->scale_x == params.scale_x &&
+        table->scale_y == params.scale_y &&
+        table->horizon == params.horizon)
+        return;
+
+    if (table->h != h)
+    {
+        table->distance = realloc (table->distance, h * sizeof (fixed));
+        table->horizontal_scale =
+            realloc (table->horizontal_scale, h * sizeof (fixed));
+    }
+    table->h = h;
+    table->space_z = params.space_z;
+    table->scale_x = params.scale_x;
+    table->scale_y = params.scale_y;
+    table->horizon = params.horizon;
+
+    // these are exactly the same calculations as in mode_7
+    for (screen_y = 0; screen_y < h; screen_y++)
+    {
+        table->distance[screen_y] = fdiv (fmul (params.space_z, params.scale_y),
+            itofix (screen_y + params.horizon));
+        table->horizontal_scale[screen_y] =
+            fdiv (table->distance[screen_y], params.scale_x);
+    }
+}
+
+/* mode_7_lines draws the lines y1 up to y2 of a Mode 7 frame, using the
+distances and horizontal scales from the table. The table must already be
+up to date. Each line is drawn by affine_span (see span.c).
+The lines don't depend on each other, so several threads can
+draw different lines of the same bitmap at the same time. */
+void mode_7_lines (BITMAP *bmp, BITMAP *tile, fixed angle, fixed cx, fixed cy,
+    MODE_7_TABLE *table, int y1, int y2)
+{
+    int screen_y;
+    fixed line_dx, line_dy;
+    fixed space_x, space_y;
+
+    // the angle is the same for all lines, so we need sin and cos only once
+    fixed sin_angle = fsin (angle);
+    fixed cos_angle = fcos (angle);
+
+    for (screen_y = y1; screen_y < y2; screen_y++)
+    {
+        fixed distance = table->distance[screen_y];
+        fixed horizontal_scale = table->horizontal_scale[screen_y];
+
+        line_dx = fmul (-sin_angle, horizontal_scale);
+        line_dy = fmul (cos_angle, horizontal_scale);
+
+        space_x = cx + fmul (distance, cos_angle) - bmp->w/2 * line_dx;
+        space_y = cy + fmul (distance, sin_angle) - bmp->w/2 * line_dy;
+
+        // draw the whole line at once
+        affine_span (bmp, 0, screen_y, bmp->w, tile,
+            space_x, space_y, line_dx, line_dy);
+    }
+}
+
+/* mode_7_cached draws the same thing as mode_7, but it looks up the
+distance and horizontal scale of each line in the table. */
+void mode_7_cached (BITMAP *bmp, BITMAP *tile, fixed angle, fixed cx, fixed cy,
+    MODE_7_PARAMS params, MODE_7_TABLE *table)
+{
+    update_mode_7_table (table, bmp->h, params);
+    mode_7_lines (bmp, tile, angle, cx, cy, table, 0, bmp->h);
+}
+
+/* MODE_7_BANDS holds everything the worker threads need to know
+to draw their part of the frame */
+typedef struct MODE_7_BANDS
+{
+    BITMAP *bmp, *tile;
+    fixed angle, cx, cy;
+    MODE_7_TABLE *table;
+    int num_bands;
+} MODE_7_BANDS;
+
+// draw_mode_7_band is called by the worker pool for each band
+void draw_mode_7_band (void *data, int band)
+{
+    MODE_7_BANDS *bands = data;
+    int h = bands->bmp->h;
+    mode_7_lines (bands->bmp, bands->tile, bands->angle, bands->cx, bands->cy,
+        bands->table, band * h / bands->num_bands,
+        (band + 1) * h / bands->num_bands);
+}
+
+/* mode_7_threaded draws the same thing as mode_7_cached, but divides the
+bitmap into horizontal bands that are drawn by the threads of the pool.
+There are a few more bands than threads, so that a thread that finishes
+early can pick up another band. */
+void mode_7_threaded (BITMAP *bmp, BITMAP *tile, fixed angle, fixed cx, fixed cy,
+    MODE_7_PARAMS params, MODE_7_TABLE *table, WORKER_POOL *pool)
+{
+    MODE_7_BANDS bands;
+
+    // the table is shared by all threads, so we update it beforehand
+    update_mode_7_table (table, bmp->h, params);
+
+    bands.bmp = bmp;
+    bands.tile = tile;
+    bands.angle = angle;
+    bands.cx = cx;
+    bands.cy = cy;
+    bands.table = table;
+    bands.num_bands = worker_pool_size (pool) * 4;
+    if (bands.num_bands > bmp->h) bands.num_bands = bmp->h;
+
+    run_workers (pool, draw_mode_7_band, &bands, bands.num_bands);
+}
+
+/* benchmark_mode_7 draws the same frames with mode_7 and with mode_7_cached
+and returns the average time per frame of each in milliseconds */
+void benchmark_mode_7 (BITMAP *bmp, BITMAP *tile, fixed cx, fixed cy,
+    MODE_7_PARAMS params, MODE_7_TABLE *table,
+    double *uncached_ms, double *cached_ms)
+{
+    const int frames = 100;
+    clock_t start;
+    int i;
+
+    start = clock ();
+    for (i = 0; i < frames; i++)
+        mode_7 (bmp, tile, itofix (i), cx, cy, params);
+    *uncached_ms = (clock () - start) * 1000.0 / CLOCKS_PER_SEC / frames;
+
+    start = clock ();
+    for (i = 0; i < frames; i++)
+        mode_7_cached (bmp, tile, itofix (i), cx, cy, params, table);
+    *cached_ms = (clock () - start) * 1000.0 / CLOCKS_PER_SEC / frames;
+}
+
+/* benchmark_mode_7_threads measures how well mode_7_threaded scales
+with the number of threads, for a couple of different resolutions.
+results[i][j] is set to the time per frame in milliseconds for
+resolution i and bench_threads[j] threads. */
+#define NUM_BENCH_SIZES 3
+#define NUM_BENCH_THREADS 4
+const int bench_w[NUM_BENCH_SIZES] = {320, 640, 1920};
+const int bench_h[NUM_BENCH_SIZES] = {200, 480, 1080};
+const int bench_threads[NUM_BENCH_THREADS] = {1, 2, 4, 8};
+
+void benchmark_mode_7_threads (BITMAP *tile, fixed cx, fixed cy,
+    MODE_7_PARAMS params, double results[NUM_BENCH_SIZES][NUM_BENCH_THREADS])
+{
+    const int frames = 20;
+    MODE_7_TABLE *table = create_mode_7_table ();
+    WORKER_POOL *pool;
+    BITMAP *bmp;
+    double start;
+    int i, j, k;
+
+    for (i = 0; i < NUM_BENCH_SIZES; i++)
+    {
+        bmp = create_bitmap (bench_w[i], bench_h[i]);
+        for (j = 0; j < NUM_BENCH_THREADS; j++)
+        {
+            pool = create_worker_pool (bench_threads[j]);
+            start = wall_time ();
+            for (k = 0; k < frames; k++)
+                mode_7_threaded (bmp, tile, itofix (k), cx, cy,
+                    params, table, pool);
+            results[i][j] = (wall_time () - start) * 1000.0 / frames;
+            destroy_worker_pool (pool);
+        }
+        destroy_bitmap (bmp);
+    }
+    destroy_mode_7_table (table);
+}
+
+/* circbench.c includes this file with KERNELS_ONLY defined,
+because it only needs the Mode 7 functions */
+#ifndef KERNELS_ONLY
+
 void test_mode_7 ()
 {
     MODE_7_PARAMS params;
@@ -127,6 +349,13 @@ void test_mode_7 ()
     fixed dx = 0, dy = 0;
     fixed speed = 0;
     int i, j, r2;
+    MODE_7_TABLE *table = create_mode_7_table ();
+    // results of the last benchmark, in milliseconds per frame
+    double uncached_ms = 0, cached_ms = 0;
+    // the threads we draw with, and the results of the thread benchmark
+    WORKER_POOL *pool = create_worker_pool (1);
+    double thread_ms[NUM_BENCH_SIZES][NUM_BENCH_THREADS];
+    int thread_results = FALSE;
 
     params.space_z = itofix (50);
     params.scale_x = ftofix (200.0);
@@ -220,6 +449,22 @@ void test_mode_7 ()
             params.horizon++;
         if (key[KEY_J])
             params.horizon--;
+        if (key[KEY_B])
+            benchmark_mode_7 (buffer, tile, x, y, params, table,
+                &uncached_ms, &cached_ms);
+        for (i = 1; i <= 8; i++)
+        {
+            if (key[KEY_1 + i - 1] && worker_pool_size (pool) != i)
+            {
+                destroy_worker_pool (pool);
+                pool = create_worker_pool (i);
+            }
+        }
+        if (key[KEY_T])
+        {
+            benchmark_mode_7_threads (tile, x, y, params, thread_ms);
+            thread_results = TRUE;
+        }
 
         dx = fmul (speed, fcos (angle));
         dy = fmul (speed, fsin (angle));
@@ -227,33 +472,53 @@ void test_mode_7 ()
         x += dx;
         y += dy;
 
-        mode_7 (buffer, tile, angle, x, y, params);
+        mode_7_threaded (buffer, tile, angle, x, y, params, table, pool);
         draw_object (buffer, sprite, angle, x, y, params);
-        vsync();
+        textprintf (buffer, font, 0, 0, 63, "threads: %d",
+            worker_pool_size (pool));
+        if (cached_ms > 0)
+            textprintf (buffer, font, 0, 10, 63,
+                "uncached: %.2f ms  cached: %.2f ms", uncached_ms, cached_ms);
+        if (thread_results)
+        {
+            textprintf (buffer, font, 0, 20, 63, "ms/frame  %5d %5d %5d %5d",
+                bench_threads[0], bench_threads[1],
+                bench_threads[2], bench_threads[3]);
+            for (i = 0; i < NUM_BENCH_SIZES; i++)
+                textprintf (buffer, font, 0, 30 + 10 * i, 63,
+                    "%4dx%-4d %5.1f %5.1f %5.1f %5.1f",
+                    bench_w[i], bench_h[i], thread_ms[i][0], thread_ms[i][1],
+                    thread_ms[i][2], thread_ms[i][3]);
+        }
+        headless_vsync ();
         blit (buffer, screen, 0, 0, 0, 0, SCREEN_W, SCREEN_H);
+        headless_frame ();
 
     }
+    destroy_worker_pool (pool);
+    destroy_mode_7_table (table);
     destroy_bitmap (tile);
     destroy_bitmap (sprite);
     destroy_bitmap (buffer);
 }
 
-int main ()
+int main (int argc, char *argv[])
 {
     // initialize Allegro
-    if (allegro_init () < 0)
+    // (see headless.h for the command line options)
+    if (headless_init (argc, argv) < 0)
     {
         allegro_message ("Error: Could not initialize Allegro");
         return -1;
     }
     // initialize gfx mode
-    if (set_gfx_mode (GFX_AUTODETECT, 320, 200, 0, 0) < 0)
+    if (headless_set_gfx_mode (GFX_AUTODETECT, 320, 200, 0, 0) < 0)
     {
         allegro_message ("Error: Could not set graphics mode");
         return -1;
     }
     // initialize keyboard
-    install_keyboard ();
+    headless_install_keyboard ();
     clear_keybuf ();
 
     // call the example function
@@ -265,3 +530,5 @@ int main ()
     return 0;
 
 } END_OF_MAIN ();
+
+#endif
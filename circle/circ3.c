@@ -9,6 +9,7 @@
 */
 
 #include <allegro.h>
+#include "../common/headless.h"
 
 void draw_sine ()
 {
@@ -32,27 +33,31 @@ void draw_sine ()
     }
 }
 
-int main ()
+int main (int argc, char *argv[])
 {
     // initialize Allegro
-    if (allegro_init () < 0)
+    // (see headless.h for the command line options)
+    if (headless_init (argc, argv) < 0)
     {
         allegro_message ("Error: Could not initialize Allegro");
         return -1;
     }
     // initialize gfx mode
-    if (set_gfx_mode (GFX_AUTODETECT, 320, 200, 0, 0) < 0)
+    if (headless_set_gfx_mode (GFX_AUTODETECT, 320, 200, 0, 0) < 0)
     {
         allegro_message ("Error: Could not set graphics mode");
         return -1;
     }
     // initialize keyboard
-    install_keyboard ();
+    headless_install_keyboard ();
     clear_keybuf ();
 
     // call the example function
     draw_sine ();
 
+    // the picture is done (this saves it in headless mode)
+    headless_still ();
+
     // wait for a user key-press
     readkey ();
 
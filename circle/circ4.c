@@ -8,77 +8,135 @@
 */
 
 #include <allegro.h>
+#include "../common/headless.h"
+#include "../common/gameloop.h"
+#include "../common/dirty.h"
 
-void racing_car ()
+// everything racing_car needs to remember from one frame to the next
+typedef struct RACING_CAR
 {
     // length and angle of the racing car's velocity vector
-    fixed angle = itofix (0);
-    fixed length = itofix (0);
+    fixed angle;
+    fixed length;
+    // x- and y-position of the racing car
+    fixed x, y;
+    // position and angle after the previous update
+    fixed old_x, old_y, old_angle;
+    // remembers where the car was drawn,
+    // so that it can be erased again (see ../common/dirty.h)
+    DIRTY *dirty;
+} RACING_CAR;
+
+// update_car is called 100 times per second by run_game_loop
+// (see ../common/gameloop.h)
+int update_car (void *data)
+{
+    RACING_CAR *car = data;
     // x- and y-coordinates of the velocity vector
     fixed vel_x, vel_y;
 
-    // x- and y-position of the racing car
-    fixed x = itofix (SCREEN_W / 2);
-    fixed y = itofix (SCREEN_H / 2);
+    car->old_x = car->x;
+    car->old_y = car->y;
+    car->old_angle = car->angle;
+
+    // check the keys and move the car
+    if (key[KEY_UP] && car->length < itofix (2))
+        car->length += ftofix (0.005);
+    if (key[KEY_DOWN] && car->length > itofix (0))
+        car->length -= ftofix (0.005);
+    if (key[KEY_LEFT])
+        car->angle = (car->angle - itofix (1)) & 0xFFFFFF;
+    if (key[KEY_RIGHT])
+        car->angle = (car->angle + itofix (1)) & 0xFFFFFF;
+
+    // calculate the x- and y-coordinates of the velocity vector
+    vel_x = fmul (car->length, fcos (car->angle));
+    vel_y = fmul (car->length, fsin (car->angle));
+
+    // move the car, and make sure it stays within the screen
+    car->x += vel_x;
+    if (car->x >= itofix (SCREEN_W)) car->x -= itofix(SCREEN_W);
+    if (car->x < itofix (0)) car->x += itofix(SCREEN_W);
+    car->y += vel_y;
+    if (car->y >= itofix (SCREEN_H)) car->y -= itofix(SCREEN_H);
+    if (car->y < itofix (0)) car->y += itofix(SCREEN_H);
+
+    return key[KEY_ESC];
+}
 
-    while (!key[KEY_ESC])
+// draw_car draws the car alpha of the way from the previous update
+// to the last one
+void draw_car (void *data, fixed alpha)
+{
+    RACING_CAR *car = data;
+    fixed x = lerp_fixed (car->old_x, car->x, alpha);
+    fixed y = lerp_fixed (car->old_y, car->y, alpha);
+    fixed angle = lerp_angle (car->old_angle, car->angle, alpha);
+
+    // if the car went off one side of the screen and came back on the
+    // other, just draw it where it is now
+    if (abs (car->x - car->old_x) > itofix (SCREEN_W / 2) ||
+        abs (car->y - car->old_y) > itofix (SCREEN_H / 2))
     {
-        // erase the old image
-        circlefill (screen, fixtoi(x), fixtoi(y), 10, makecol (0, 0, 0));
-
-        // check the keys and move the car
-        if (key[KEY_UP] && length < itofix (2))
-            length += ftofix (0.005);
-        if (key[KEY_DOWN] && length > itofix (0))
-            length -= ftofix (0.005);
-        if (key[KEY_LEFT])
-            angle = (angle - itofix (1)) & 0xFFFFFF;
-        if (key[KEY_RIGHT])
-            angle = (angle + itofix (1)) & 0xFFFFFF;
-
-        // calculate the x- and y-coordinates of the velocity vector
-        vel_x = fmul (length, fcos (angle));
-        vel_y = fmul (length, fsin (angle));
-
-        // move the car, and make sure it stays within the screen
-        x += vel_x;
-        if (x >= itofix (SCREEN_W)) x -= itofix(SCREEN_W);
-        if (x < itofix (0)) x += itofix(SCREEN_W);
-        y += vel_y;
-        if (y >= itofix (SCREEN_H)) y -= itofix(SCREEN_H);
-        if (y < itofix (0)) y += itofix(SCREEN_H);
-
-        // draw the racing car
-        circle (screen, fixtoi(x), fixtoi(y), 10, makecol (0, 0, 255));
-        line (screen, fixtoi(x), fixtoi(y),
-            fixtoi (x + 9 * fcos (angle)),
-            fixtoi (y + 9 * fsin (angle)),
-            makecol (255, 0, 0));
-
-        // wait for 10 milliseconds, or else we'd go too fast
-        rest (10);
+        x = car->x;
+        y = car->y;
     }
+
+    // erase the old image
+    restore_dirty (car->dirty, screen);
+
+    // draw the racing car
+    dirty_circle (car->dirty, screen, fixtoi(x), fixtoi(y), 10,
+        makecol (0, 0, 255));
+    dirty_line (car->dirty, screen, fixtoi(x), fixtoi(y),
+        fixtoi (x + 9 * fcos (angle)),
+        fixtoi (y + 9 * fsin (angle)),
+        makecol (255, 0, 0));
+}
+
+void racing_car ()
+{
+    RACING_CAR car;
+    // the screen without the car on it
+    BITMAP *background = create_bitmap (SCREEN_W, SCREEN_H);
+    clear_bitmap (background);
+
+    car.angle = itofix (0);
+    car.length = itofix (0);
+    car.x = itofix (SCREEN_W / 2);
+    car.y = itofix (SCREEN_H / 2);
+    car.old_x = car.x;
+    car.old_y = car.y;
+    car.old_angle = car.angle;
+    car.dirty = create_dirty (background);
+
+    run_game_loop (100, 5, TRUE, update_car, draw_car, &car, NULL);
+
+    destroy_dirty (car.dirty);
+    destroy_bitmap (background);
 }
 
-int main ()
+int main (int argc, char *argv[])
 {
     // initialize Allegro
-    if (allegro_init () < 0)
+    // (see headless.h for the command line options)
+    if (headless_init (argc, argv) < 0)
     {
         allegro_message ("Error: Could not initialize Allegro");
         return -1;
     }
     // initialize gfx mode
-    if (set_gfx_mode (GFX_AUTODETECT, 320, 200, 0, 0) < 0)
+    if (headless_set_gfx_mode (GFX_AUTODETECT, 320, 200, 0, 0) < 0)
     {
         allegro_message ("Error: Could not set graphics mode");
         return -1;
     }
     // initialize keyboard
-    install_keyboard ();
+    headless_install_keyboard ();
     clear_keybuf ();
 
-    install_timer ();
+    // initialize timer for run_game_loop()
+    headless_install_timer ();
 
     // call the example function
     racing_car ();
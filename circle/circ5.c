@@ -8,67 +8,105 @@
 */
 
 #include <allegro.h>
+#include "../common/headless.h"
+#include "../common/gameloop.h"
+#include "../common/dirty.h"
 
-void orbit ()
+// everything orbit needs to remember from one frame to the next
+typedef struct ORBIT
 {
-    int x = 0, y = 0;
-
-    fixed angle = itofix (0);
-    fixed angle_stepsize = itofix (1);
+    fixed angle, old_angle; // the angle now and after the previous update
+    fixed angle_stepsize;
 
     // These determine the radius of the orbit.
     // See what happens if you change length_x to 100 :)
-    int length_x = 50;
-    int length_y = 50;
+    int length_x, length_y;
 
-    // repeat this until a key is pressed
-    while (!keypressed())
-    {
-        // erase the point from the old position
-        putpixel (screen,
-            fixtoi(x) + SCREEN_W / 2, fixtoi(y) + SCREEN_H / 2,
-            makecol (0, 0, 0));
+    // remembers where the point was drawn,
+    // so that it can be erased again (see ../common/dirty.h)
+    DIRTY *dirty;
+} ORBIT;
 
-        // calculate the new position
-        x = length_x * fcos (angle);
-        y = length_y * fsin (angle);
+// update_orbit is called 100 times per second by run_game_loop
+// (see ../common/gameloop.h)
+int update_orbit (void *data)
+{
+    ORBIT *orbit = data;
 
-        // draw the point in the new position
-        putpixel (screen,
-            fixtoi(x) + SCREEN_W / 2, fixtoi(y) + SCREEN_H / 2,
-            makecol (255, 255, 255));
+    // increment the angle so that the point moves around in circles
+    orbit->old_angle = orbit->angle;
+    orbit->angle += orbit->angle_stepsize;
 
-        // increment the angle so that the point moves around in circles
-        angle += angle_stepsize;
+    // make sure angle is in range
+    orbit->angle &= 0xFFFFFF;
 
-        // make sure angle is in range
-        angle &= 0xFFFFFF;
+    // stop when a key is pressed
+    return keypressed ();
+}
 
-        // wait 10 milliseconds, or else it'd go too fast
-        rest (10);
-    }
+// draw_orbit draws the point alpha of the way from the previous
+// update to the last one
+void draw_orbit (void *data, fixed alpha)
+{
+    ORBIT *orbit = data;
+    fixed angle = lerp_angle (orbit->old_angle, orbit->angle, alpha);
+    fixed x, y;
+
+    // erase the point from the old position
+    restore_dirty (orbit->dirty, screen);
+
+    // calculate the new position
+    x = orbit->length_x * fcos (angle);
+    y = orbit->length_y * fsin (angle);
+
+    // draw the point in the new position
+    dirty_putpixel (orbit->dirty, screen,
+        fixtoi(x) + SCREEN_W / 2, fixtoi(y) + SCREEN_H / 2,
+        makecol (255, 255, 255));
+}
+
+void orbit ()
+{
+    ORBIT orbit;
+    // the screen without the point on it
+    BITMAP *background = create_bitmap (SCREEN_W, SCREEN_H);
+    clear_bitmap (background);
+
+    orbit.angle = itofix (0);
+    orbit.old_angle = orbit.angle;
+    orbit.angle_stepsize = itofix (1);
+    orbit.length_x = 50;
+    orbit.length_y = 50;
+    orbit.dirty = create_dirty (background);
+
+    // repeat this until a key is pressed
+    run_game_loop (100, 5, TRUE, update_orbit, draw_orbit, &orbit, NULL);
+
+    destroy_dirty (orbit.dirty);
+    destroy_bitmap (background);
 }
 
-int main ()
+int main (int argc, char *argv[])
 {
     // initialize Allegro
-    if (allegro_init () < 0)
+    // (see headless.h for the command line options)
+    if (headless_init (argc, argv) < 0)
     {
         allegro_message ("Error: Could not initialize Allegro");
         return -1;
     }
     // initialize gfx mode
-    if (set_gfx_mode (GFX_AUTODETECT, 320, 200, 0, 0) < 0)
+    if (headless_set_gfx_mode (GFX_AUTODETECT, 320, 200, 0, 0) < 0)
     {
         allegro_message ("Error: Could not set graphics mode");
         return -1;
     }
     // initialize keyboard
-    install_keyboard ();
+    headless_install_keyboard ();
     clear_keybuf ();
 
-    // initialize timer for the rest() function
-    install_timer ();
+    // initialize timer for run_game_loop()
+    headless_install_timer ();
 
     // call the example function
     orbit ();
@@ -10,91 +10,145 @@
 */
 
 #include <allegro.h>
+#include "../common/headless.h"
+#include "../common/gameloop.h"
+#include "../common/dirty.h"
 
-void dot_product_home_in ()
+// everything dot_product_home_in needs to remember from one frame to the next
+typedef struct MISSILE
 {
-    // the position of the homing missile
-    fixed x = itofix(SCREEN_W / 2);
-    fixed y = itofix(SCREEN_H / 2);
+    // the x, y position of the homing missile
+    fixed x, y;
     // the angle and length of the missile's velocity vector
-    fixed angle = 0;
-    int length = 1;
-    fixed angle_stepsize = itofix (3);
+    fixed angle;
+    int length;
+    fixed angle_stepsize;
+    // position and angle after the previous update
+    fixed old_x, old_y, old_angle;
     // determines whether the missile has reached
     // the target and a new one should be chosen
-    int new_target = TRUE;
+    int new_target;
     // position of the target
     fixed target_x, target_y;
+    // remembers what was drawn, so that the next frame only has to
+    // erase that instead of clearing the screen (see ../common/dirty.h)
+    DIRTY *dirty;
+} MISSILE;
+
+// update_missile is called 100 times per second by run_game_loop
+// (see ../common/gameloop.h)
+int update_missile (void *data)
+{
+    MISSILE *m = data;
     // vector of missile movement
     fixed dx, dy;
 
-    while (!keypressed())
+    // choose new target randomly when needed
+    if (m->new_target)
     {
-        clear (screen);
-        // choose new target randomly when needed
-        if (new_target)
-        {
-            target_x = itofix((SCREEN_W + rand() % (2 * SCREEN_W)) / 4);
-            target_y = itofix((SCREEN_H + rand() % (2 * SCREEN_H)) / 4);
-            new_target = FALSE;
-        }
-
-        // Move the missile
-        // We store dx and dy in variables so that
-        // we can use them later on in the dot product.
-        dx = length * fcos (angle);
-        dy = length * fsin (angle);
-        x += dx;
-        y += dy;
-
-        // if we are very close to the target, set a new target
-        if (abs (x - target_x) + abs (y - target_y) < itofix(10))
-            new_target = TRUE;
-
-        // draw a pixel where the target is
-        putpixel (screen, fixtoi(target_x), fixtoi(target_y),
-            makecol (255, 255, 255));
-
-        // draw the missile
-        // (actually a circle with a line representing the angle)
-        circle (screen, fixtoi(x), fixtoi(y), 10, makecol (0, 0, 255));
-        line (screen, fixtoi(x), fixtoi(y),
-            fixtoi(x) + fixtoi (9 * fcos (angle)),
-            fixtoi(y) + fixtoi (9 * fsin (angle)),
-            makecol (255, 0, 0));
-
-        // Determine whether we should turn left or right
-        // using the dot product.
-        // We use & 0xFFFFFF as a trick to get an angle
-        // between 0 and 256.
-        if (fmul(dy,(target_x - x)) + fmul(-dx,(target_y - y)) > 0)
-            angle = (angle - angle_stepsize) & 0xFFFFFF;
-        else
-            angle = (angle + angle_stepsize) & 0xFFFFFF;
-
-        rest (10);
+        m->target_x = itofix((SCREEN_W + rand() % (2 * SCREEN_W)) / 4);
+        m->target_y = itofix((SCREEN_H + rand() % (2 * SCREEN_H)) / 4);
+        m->new_target = FALSE;
     }
+
+    m->old_x = m->x;
+    m->old_y = m->y;
+    m->old_angle = m->angle;
+
+    // Move the missile
+    // We store dx and dy in variables so that
+    // we can use them later on in the dot product.
+    dx = m->length * fcos (m->angle);
+    dy = m->length * fsin (m->angle);
+    m->x += dx;
+    m->y += dy;
+
+    // if we are very close to the target, set a new target
+    if (abs (m->x - m->target_x) + abs (m->y - m->target_y) < itofix(10))
+        m->new_target = TRUE;
+
+    // Determine whether we should turn left or right
+    // using the dot product.
+    // We use & 0xFFFFFF as a trick to get an angle
+    // between 0 and 256.
+    if (fmul(dy,(m->target_x - m->x)) + fmul(-dx,(m->target_y - m->y)) > 0)
+        m->angle = (m->angle - m->angle_stepsize) & 0xFFFFFF;
+    else
+        m->angle = (m->angle + m->angle_stepsize) & 0xFFFFFF;
+
+    return keypressed ();
+}
+
+// draw_missile draws the missile alpha of the way from the previous
+// update to the last one
+void draw_missile (void *data, fixed alpha)
+{
+    MISSILE *m = data;
+    fixed x = lerp_fixed (m->old_x, m->x, alpha);
+    fixed y = lerp_fixed (m->old_y, m->y, alpha);
+    fixed angle = lerp_angle (m->old_angle, m->angle, alpha);
+
+    restore_dirty (m->dirty, screen);
+
+    // draw a pixel where the target is
+    dirty_putpixel (m->dirty, screen,
+        fixtoi(m->target_x), fixtoi(m->target_y), makecol (255, 255, 255));
+
+    // draw the missile
+    // (actually a circle with a line representing the angle)
+    dirty_circle (m->dirty, screen, fixtoi(x), fixtoi(y), 10,
+        makecol (0, 0, 255));
+    dirty_line (m->dirty, screen, fixtoi(x), fixtoi(y),
+        fixtoi(x) + fixtoi (9 * fcos (angle)),
+        fixtoi(y) + fixtoi (9 * fsin (angle)),
+        makecol (255, 0, 0));
+}
+
+void dot_product_home_in ()
+{
+    MISSILE m;
+    // the empty screen
+    BITMAP *background = create_bitmap (SCREEN_W, SCREEN_H);
+    clear_bitmap (background);
+
+    m.x = itofix(SCREEN_W / 2);
+    m.y = itofix(SCREEN_H / 2);
+    m.angle = 0;
+    m.length = 1;
+    m.angle_stepsize = itofix (3);
+    m.old_x = m.x;
+    m.old_y = m.y;
+    m.old_angle = m.angle;
+    m.new_target = TRUE;
+    m.dirty = create_dirty (background);
+
+    run_game_loop (100, 5, TRUE, update_missile, draw_missile, &m, NULL);
+
+    destroy_dirty (m.dirty);
+    destroy_bitmap (background);
 }
 
-int main ()
+int main (int argc, char *argv[])
 {
     // initialize Allegro
-    if (allegro_init () < 0)
+    // (see headless.h for the command line options)
+    if (headless_init (argc, argv) < 0)
     {
         allegro_message ("Error: Could not initialize Allegro");
         return -1;
     }
     // initialize gfx mode
-    if (set_gfx_mode (GFX_AUTODETECT, 320, 200, 0, 0) < 0)
+    if (headless_set_gfx_mode (GFX_AUTODETECT, 320, 200, 0, 0) < 0)
     {
         allegro_message ("Error: Could not set graphics mode");
         return -1;
     }
     // initialize keyboard
-    install_keyboard ();
+    headless_install_keyboard ();
     clear_keybuf ();
 
-    install_timer ();
+    // initialize timer for run_game_loop()
+    headless_install_timer ();
 
     // call the example function
     dot_product_home_in ();
@@ -3,10 +3,14 @@
     Written by Amarillion (amarillion@yahoo.com)
 
     This program demonstrates how a sprite rotation function
-    works.
+    works. It also shows how the same function can be made
+    a lot faster by writing directly to the bitmap memory.
 */
 
 #include <allegro.h>
+#include "span.h"
+#include "../common/headless.h"
+#include "../common/gameloop.h"
 
 // my_rotate_sprite will draw src_bmp on to dest_bmp
 // rotated by angle degrees and scaled by the scale factor.
@@ -67,19 +71,86 @@ void my_rotate_sprite (BITMAP *dest_bmp, BITMAP *src_bmp,
     }
 }
 
+// my_rotate_sprite_fast does exactly the same as my_rotate_sprite,
+// and the result is identical down to the last pixel.
+// But instead of going through putpixel and getpixel for every
+// single pixel, it lets affine_span (see span.c) draw each line.
+// affine_span reads and writes the lines of the bitmaps directly
+// through bmp->line[], and can use SIMD instructions to copy several
+// pixels at once.
+void my_rotate_sprite_fast (BITMAP *dest_bmp, BITMAP *src_bmp,
+    fixed angle, fixed scale)
+{
+    int dest_y;
+    fixed dx, dy;
+
+    dx = fmul (fcos (angle), scale);
+    dy = fmul (fsin (angle), scale);
+
+    for (dest_y = 0; dest_y < dest_bmp->h; dest_y++)
+    {
+        // start_x and start_y of my_rotate_sprite for this line
+        // are -dest_y * dy and dest_y * dx
+        affine_span (dest_bmp, 0, dest_y, dest_bmp->w, src_bmp,
+            -dest_y * dy, dest_y * dx, dx, dy);
+    }
+}
+
+// circbench.c includes this file with KERNELS_ONLY defined,
+// because it only needs the rotate functions
+#ifndef KERNELS_ONLY
+
+// everything test_rotate_sprite needs to remember from one frame
+// to the next
+typedef struct ROTATE_DEMO
+{
+    BITMAP *bmp, *buffer;
+    fixed angle, old_angle; // the angle now and after the previous update
+    fixed angle_stepsize;
+    GAME_LOOP_STATS stats;
+} ROTATE_DEMO;
+
+// update_rotate is called 100 times per second by run_game_loop
+// (see ../common/gameloop.h)
+int update_rotate (void *data)
+{
+    ROTATE_DEMO *demo = data;
+    demo->old_angle = demo->angle;
+    demo->angle += demo->angle_stepsize;
+    return key[KEY_ESC];
+}
+
+void draw_rotate (void *data, fixed alpha)
+{
+    ROTATE_DEMO *demo = data;
+    fixed angle = lerp_angle (demo->old_angle, demo->angle, alpha);
+    fixed scale = fsin(angle) + ftofix (1.5);
+    my_rotate_sprite_fast (demo->buffer, demo->bmp, angle, scale);
+
+    // hold S to see how long the last frame took
+    if (key[KEY_S])
+        textprintf_ex (demo->buffer, font, 0, 0, 63, -1,
+            "update %.2f ms, draw %.2f ms, %d updates",
+            demo->stats.update_ms, demo->stats.render_ms,
+            demo->stats.frame_updates);
+    blit (demo->buffer, screen, 0, 0, 0, 0, SCREEN_W, SCREEN_H);
+}
+
 // This function is just a small demo of my_rotate_sprite
 void test_rotate_sprite ()
 {
+    ROTATE_DEMO demo;
     BITMAP *bmp;
     PALETTE pal;
-    fixed angle = 0;
-    fixed scale = 0;
-    fixed angle_stepsize = itofix (1);
 
     int i, j;
 
+    // my_rotate_sprite_fast is fastest on memory bitmaps,
+    // so we draw on a buffer first and then copy it to the screen
+    demo.buffer = create_bitmap (SCREEN_W, SCREEN_H);
+
     // create a bitmap of size 64x64 and fill it with something
-    bmp = create_bitmap (64, 64);
+    bmp = demo.bmp = create_bitmap (64, 64);
     for (i = 0; i < 32; i++)
     {
         for (j = i; j < 32; j++)
@@ -104,35 +175,37 @@ void test_rotate_sprite ()
     }
     set_palette (pal);
 
-    while (!key[KEY_ESC])
-    {
-        angle += angle_stepsize;
-        scale = fsin(angle) + ftofix (1.5);
-        my_rotate_sprite (screen, bmp, angle, scale);
-        rest (10);
-    }
-    destroy_bitmap (bmp);
+    demo.angle = 0;
+    demo.old_angle = 0;
+    demo.angle_stepsize = itofix (1);
+    run_game_loop (100, 5, TRUE, update_rotate, draw_rotate, &demo,
+        &demo.stats);
+
+    destroy_bitmap (demo.bmp);
+    destroy_bitmap (demo.buffer);
 }
 
-int main ()
+int main (int argc, char *argv[])
 {
     // initialize Allegro
-    if (allegro_init () < 0)
+    // (see headless.h for the command line options)
+    if (headless_init (argc, argv) < 0)
     {
         allegro_message ("Error: Could not initialize Allegro");
         return -1;
     }
     // initialize gfx mode
-    if (set_gfx_mode (GFX_AUTODETECT, 320, 200, 0, 0) < 0)
+    if (headless_set_gfx_mode (GFX_AUTODETECT, 320, 200, 0, 0) < 0)
     {
         allegro_message ("Error: Could not set graphics mode");
         return -1;
     }
     // initialize keyboard
-    install_keyboard ();
+    headless_install_keyboard ();
     clear_keybuf ();
 
-    install_timer ();
+    // initialize timer for run_game_loop()
+    headless_install_timer ();
 
     // call the example function
     test_rotate_sprite ();
@@ -143,3 +216,5 @@ int main ()
     return 0;
 
 } END_OF_MAIN ();
+
+#endif
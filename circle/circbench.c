@@ -0,0 +1,118 @@
+/*
+    CIRCLE BENCHMARK
+    Written by Amarillion (amarillion@yahoo.com)
+
+    This program measures the drawing functions of the circle examples
+    one by one, on memory bitmaps. It doesn't need a screen, the results
+    are printed as CSV. See ../common/bench.h for the command line options.
+*/
+
+#include <stdio.h>
+#include <allegro.h>
+#include "../common/bench.h"
+
+// we only want the drawing functions of these examples, not their main()
+#define KERNELS_ONLY
+#include "circ6.c"
+#include "circ9.c"
+#include "circ12.c"
+
+// everything the Mode 7 kernels need besides the bitmap
+typedef struct MODE_7_BENCH
+{
+    BITMAP *tile;
+    MODE_7_PARAMS params;
+    MODE_7_TABLE *table;
+    WORKER_POOL *pool;
+} MODE_7_BENCH;
+
+// concentric circles that fill the whole bitmap
+void bench_my_draw_circle (BITMAP *bmp, int frame, void *data)
+{
+    int r, max_r = (bmp->w < bmp->h ? bmp->w : bmp->h) / 2 - 1;
+    for (r = 1; r <= max_r; r++)
+        my_draw_circle (bmp, bmp->w / 2, bmp->h / 2, r,
+            makecol (255, 255, 255));
+}
+
+void bench_my_rotate_sprite (BITMAP *bmp, int frame, void *data)
+{
+    my_rotate_sprite (bmp, data, itofix (frame), ftofix (0.7));
+}
+
+void bench_my_rotate_sprite_fast (BITMAP *bmp, int frame, void *data)
+{
+    my_rotate_sprite_fast (bmp, data, itofix (frame), ftofix (0.7));
+}
+
+void bench_mode_7 (BITMAP *bmp, int frame, void *data)
+{
+    MODE_7_BENCH *m = data;
+    mode_7 (bmp, m->tile, itofix (frame), 0, 0, m->params);
+}
+
+void bench_mode_7_cached (BITMAP *bmp, int frame, void *data)
+{
+    MODE_7_BENCH *m = data;
+    mode_7_cached (bmp, m->tile, itofix (frame), 0, 0, m->params, m->table);
+}
+
+void bench_mode_7_threaded (BITMAP *bmp, int frame, void *data)
+{
+    MODE_7_BENCH *m = data;
+    mode_7_threaded (bmp, m->tile, itofix (frame), 0, 0, m->params,
+        m->table, m->pool);
+}
+
+int main (int argc, char *argv[])
+{
+    BITMAP *tile;
+    MODE_7_BENCH m;
+    int x, y;
+
+    if (bench_init (argc, argv) != 0)
+    {
+        allegro_message ("Error: Could not initialize the benchmark");
+        return -1;
+    }
+
+    // the same kind of tile as spanbench.c uses
+    tile = create_bitmap (256, 256);
+    for (y = 0; y < tile->h; y++)
+        for (x = 0; x < tile->w; x++)
+            putpixel (tile, x, y, makecol (x, y, x ^ y));
+
+    m.tile = tile;
+    m.params.space_z = itofix (50);
+    m.params.scale_x = ftofix (200.0);
+    m.params.scale_y = ftofix (200.0);
+    m.params.obj_scale_x = ftofix (50.0);
+    m.params.obj_scale_y = ftofix (50.0);
+    m.params.horizon = 20;
+    m.table = create_mode_7_table ();
+    m.pool = create_worker_pool (4);
+
+    bench_kernel ("my_draw_circle", bench_my_draw_circle, NULL);
+    bench_kernel ("my_rotate_sprite", bench_my_rotate_sprite, tile);
+    bench_kernel ("my_rotate_sprite_fast", bench_my_rotate_sprite_fast, tile);
+    bench_kernel ("mode_7", bench_mode_7, &m);
+    bench_kernel ("mode_7_cached", bench_mode_7_cached, &m);
+    bench_kernel ("mode_7_threaded", bench_mode_7_threaded, &m);
+
+    // the fast version must draw exactly the same (make check)
+    bench_check ("my_rotate_sprite_fast", bench_my_rotate_sprite_fast,
+        "my_rotate_sprite", bench_my_rotate_sprite, tile, 0);
+
+    // the table holds the same distances mode_7 calculates, and the
+    // threads draw the same lines, so these must be exactly the same too
+    bench_check ("mode_7_cached", bench_mode_7_cached,
+        "mode_7", bench_mode_7, &m, 0);
+    bench_check ("mode_7_threaded", bench_mode_7_threaded,
+        "mode_7", bench_mode_7, &m, 0);
+
+    destroy_worker_pool (m.pool);
+    destroy_mode_7_table (m.table);
+    destroy_bitmap (tile);
+    return bench_exit ();
+
+} END_OF_MAIN ();
@@ -0,0 +1,109 @@
+/*
+    CIRCREAL.C
+    Written by Amarillion (amarillion@yahoo.com)
+
+    draw_circle (CIRCLE 2), my_rotate_sprite (CIRCLE 9) and mode_7
+    (CIRCLE 12) written with the macros of real.h, so they can be
+    compiled for fixed, float or double numbers. Each time this file
+    is included it adds one version of each function, for example
+    with REAL_FLOAT defined: draw_circle_float, my_rotate_sprite_float
+    and mode_7_float. The fixed versions draw exactly the same as the
+    originals.
+
+    This file can't be compiled on its own: mode_7 needs MODE_7_PARAMS,
+    so circ12.c has to be included before it. So unlike spherereal.c
+    there is no object file for each version: realbench.c includes
+    circ12.c once and this file three times, with REAL_FLOAT,
+    REAL_DOUBLE and neither defined.
+*/
+
+#include "../common/real.h"
+
+// draw_circle_fixed() in CIRCLE 2, on bmp and at (cx, cy)
+// instead of in the middle of the screen
+void REAL_NAME (draw_circle) (BITMAP *bmp, int cx, int cy, int length,
+    fixed angle_stepsize, int color)
+{
+    REAL x, y;
+    REAL angle = 0;
+    REAL step = ftor (angle_stepsize);
+
+    // go through all angles from 0 to 255
+    while (rtoi (angle) < 256)
+    {
+        // calculate x, y from a vector with known length and angle
+        x = rmuli (rcos (angle), length);
+        y = rmuli (rsin (angle), length);
+
+        putpixel (bmp, rtoi (x) + cx, rtoi (y) + cy, color);
+        angle += step;
+    }
+}
+
+void REAL_NAME (my_rotate_sprite) (BITMAP *dest_bmp, BITMAP *src_bmp,
+    fixed angle, fixed scale)
+{
+    REAL src_x, src_y, dx, dy;
+    REAL start_x = 0, start_y = 0;
+    int dest_x, dest_y;
+    int x_mask = src_bmp->w - 1;
+    int y_mask = src_bmp->h - 1;
+
+    // see circ9.c for the explanation
+    dx = rmul (rcos (ftor (angle)), ftor (scale));
+    dy = rmul (rsin (ftor (angle)), ftor (scale));
+
+    for (dest_y = 0; dest_y < dest_bmp->h; dest_y++)
+    {
+        src_x = start_x;
+        src_y = start_y;
+        for (dest_x = 0; dest_x < dest_bmp->w; dest_x++)
+        {
+            putpixel (dest_bmp, dest_x, dest_y,
+                getpixel (src_bmp,
+                    rtoi (src_x) & x_mask,
+                    rtoi (src_y) & y_mask));
+            src_x += dx;
+            src_y += dy;
+        }
+        start_x -= dy;
+        start_y += dx;
+    }
+}
+
+void REAL_NAME (mode_7) (BITMAP *bmp, BITMAP *tile, fixed angle,
+    fixed cx, fixed cy, MODE_7_PARAMS params)
+{
+    int screen_x, screen_y;
+    REAL distance, horizontal_scale;
+    int mask_x = (tile->w - 1);
+    int mask_y = (tile->h - 1);
+    REAL line_dx, line_dy;
+    REAL space_x, space_y;
+    REAL sin_angle = rsin (ftor (angle));
+    REAL cos_angle = rcos (ftor (angle));
+
+    // see circ12.c for the explanation
+    for (screen_y = 0; screen_y < bmp->h; screen_y++)
+    {
+        distance = rdiv (rmul (ftor (params.space_z), ftor (params.scale_y)),
+            itor (screen_y + params.horizon));
+        horizontal_scale = rdiv (distance, ftor (params.scale_x));
+
+        line_dx = rmul (-sin_angle, horizontal_scale);
+        line_dy = rmul (cos_angle, horizontal_scale);
+
+        space_x = ftor (cx) + rmul (distance, cos_angle) - rmuli (line_dx, bmp->w/2);
+        space_y = ftor (cy) + rmul (distance, sin_angle) - rmuli (line_dy, bmp->w/2);
+
+        for (screen_x = 0; screen_x < bmp->w; screen_x++)
+        {
+            putpixel (bmp, screen_x, screen_y,
+                getpixel (tile,
+                    rtoi (space_x) & mask_x,
+                    rtoi (space_y) & mask_y));
+            space_x += line_dx;
+            space_y += line_dy;
+        }
+    }
+}
@@ -0,0 +1,170 @@
+/*
+    DIRTY RECTANGLE BENCHMARK
+    Written by Amarillion (amarillion@yahoo.com)
+
+    This program draws 10, 100 and 1000 missiles like those of CIRCLE 7
+    on a 1920x1080 bitmap, and compares clearing the whole bitmap each
+    frame with erasing only what was drawn (see ../common/dirty.h).
+    It does the same for copying a buffer to the screen: the whole
+    buffer, or only the parts that changed. It doesn't need a screen,
+    the results are printed as text:
+
+    method,missiles,bytes_per_frame,ms_per_frame
+
+    bytes_per_frame counts the bytes that are read or written to clear,
+    erase or copy, not those of the drawing itself, which is the same
+    for all methods.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <allegro.h>
+#include "../common/dirty.h"
+#include "../common/walltime.h"
+
+#define WIDTH 1920
+#define HEIGHT 1080
+#define DEPTH 32
+#define FRAMES 50
+
+enum { CLEAR, DIRTY_RESTORE, BLIT, DIRTY_FLUSH };
+
+const char *method_names[] = { "clear", "dirty", "blit", "dirty_flush" };
+
+typedef struct MISSILE
+{
+    int x, y, dx, dy;
+    int target_x, target_y;
+} MISSILE;
+
+// draw the missiles as CIRCLE 7 does, through dirty if it is not NULL
+void draw_missiles (BITMAP *bmp, DIRTY *dirty, MISSILE *m, int count)
+{
+    int blue = makecol (0, 0, 255), red = makecol (255, 0, 0);
+    int white = makecol (255, 255, 255);
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        if (dirty)
+        {
+            dirty_putpixel (dirty, bmp, m[i].target_x, m[i].target_y, white);
+            dirty_circle (dirty, bmp, m[i].x, m[i].y, 10, blue);
+            dirty_line (dirty, bmp, m[i].x, m[i].y,
+                m[i].x + m[i].dx * 3, m[i].y + m[i].dy * 3, red);
+        }
+        else
+        {
+            putpixel (bmp, m[i].target_x, m[i].target_y, white);
+            circle (bmp, m[i].x, m[i].y, 10, blue);
+            line (bmp, m[i].x, m[i].y,
+                m[i].x + m[i].dx * 3, m[i].y + m[i].dy * 3, red);
+        }
+    }
+}
+
+// move the missiles, bouncing off the sides
+void move_missiles (MISSILE *m, int count)
+{
+    int i;
+    for (i = 0; i < count; i++)
+    {
+        m[i].x += m[i].dx;
+        m[i].y += m[i].dy;
+        if (m[i].x < 0 || m[i].x >= WIDTH) m[i].dx = -m[i].dx;
+        if (m[i].y < 0 || m[i].y >= HEIGHT) m[i].dy = -m[i].dy;
+    }
+}
+
+void benchmark (int method, int count)
+{
+    BITMAP *background = create_bitmap (WIDTH, HEIGHT);
+    BITMAP *buffer = create_bitmap (WIDTH, HEIGHT);
+    BITMAP *target = create_bitmap (WIDTH, HEIGHT);
+    DIRTY *dirty = create_dirty (background);
+    MISSILE *m = malloc (count * sizeof (MISSILE));
+    int bytes_per_pixel = (bitmap_color_depth (buffer) + 7) / 8;
+    double start, seconds, bytes = 0;
+    int i, frame;
+
+    srand (1);
+    for (i = 0; i < count; i++)
+    {
+        m[i].x = rand () % WIDTH;
+        m[i].y = rand () % HEIGHT;
+        m[i].dx = rand () % 7 - 3;
+        m[i].dy = rand () % 7 - 3;
+        m[i].target_x = rand () % WIDTH;
+        m[i].target_y = rand () % HEIGHT;
+    }
+    clear_bitmap (background);
+    clear_bitmap (buffer);
+
+    start = wall_time ();
+    for (frame = 0; frame < FRAMES; frame++)
+    {
+        switch (method)
+        {
+            case CLEAR:
+                // write every pixel
+                clear_bitmap (buffer);
+                bytes += (double)WIDTH * HEIGHT * bytes_per_pixel;
+                draw_missiles (buffer, NULL, m, count);
+                break;
+            case DIRTY_RESTORE:
+                // read and write the pixels that were drawn on
+                restore_dirty (dirty, buffer);
+                bytes += 2.0 * dirty->restored_pixels * bytes_per_pixel;
+                draw_missiles (buffer, dirty, m, count);
+                break;
+            case BLIT:
+                restore_dirty (dirty, buffer);
+                bytes += 2.0 * dirty->restored_pixels * bytes_per_pixel;
+                draw_missiles (buffer, dirty, m, count);
+                blit (buffer, target, 0, 0, 0, 0, WIDTH, HEIGHT);
+                bytes += 2.0 * WIDTH * HEIGHT * bytes_per_pixel;
+                break;
+            case DIRTY_FLUSH:
+                restore_dirty (dirty, buffer);
+                bytes += 2.0 * dirty->restored_pixels * bytes_per_pixel;
+                draw_missiles (buffer, dirty, m, count);
+                flush_dirty (dirty, buffer, target);
+                bytes += 2.0 * dirty->flushed_pixels * bytes_per_pixel;
+                break;
+        }
+        move_missiles (m, count);
+    }
+    seconds = wall_time () - start;
+
+    printf ("%s,%d,%.0f,%.3f\n", method_names[method], count,
+        bytes / FRAMES, seconds * 1000.0 / FRAMES);
+
+    free (m);
+    destroy_dirty (dirty);
+    destroy_bitmap (target);
+    destroy_bitmap (buffer);
+    destroy_bitmap (background);
+}
+
+int main ()
+{
+    int counts[] = {10, 100, 1000};
+    int i, method;
+
+    // we only use memory bitmaps, so we don't need a graphics mode
+    if (allegro_init () < 0)
+    {
+        allegro_message ("Error: Could not initialize Allegro");
+        return -1;
+    }
+    set_color_depth (DEPTH);
+
+    printf ("method,missiles,bytes_per_frame,ms_per_frame\n");
+    for (i = 0; i < 3; i++)
+        for (method = CLEAR; method <= DIRTY_FLUSH; method++)
+            benchmark (method, counts[i]);
+
+    allegro_exit ();
+    return 0;
+
+} END_OF_MAIN ();
@@ -0,0 +1,164 @@
+/*
+   ENTITIES.C
+   written by Martijn van Iersel (Amarillion)
+
+   See entities.h
+*/
+
+#include <stdlib.h>
+#include <allegro.h>
+#include "entities.h"
+#include "steer.h"
+
+ENTITIES *create_entities (int max)
+{
+    ENTITIES *entities = calloc (1, sizeof (ENTITIES));
+    if (!entities) return NULL;
+
+    entities->max = max;
+    entities->x = malloc (max * sizeof (fixed));
+    entities->y = malloc (max * sizeof (fixed));
+    entities->angle = malloc (max * sizeof (fixed));
+    entities->length = malloc (max * sizeof (fixed));
+    entities->target_x = malloc (max * sizeof (fixed));
+    entities->target_y = malloc (max * sizeof (fixed));
+    entities->arrived = malloc (max);
+    if (!entities->x || !entities->y || !entities->angle ||
+        !entities->length || !entities->target_x || !entities->target_y ||
+        !entities->arrived)
+    {
+        destroy_entities (entities);
+        return NULL;
+    }
+    return entities;
+}
+
+void destroy_entities (ENTITIES *entities)
+{
+    free (entities->x);
+    free (entities->y);
+    free (entities->angle);
+    free (entities->length);
+    free (entities->target_x);
+    free (entities->target_y);
+    free (entities->arrived);
+    free (entities);
+}
+
+int add_entity (ENTITIES *entities, fixed x, fixed y,
+    fixed angle, fixed length)
+{
+    int i = entities->count;
+    if (i >= entities->max) return -1;
+
+    entities->x[i] = x;
+    entities->y[i] = y;
+    entities->angle[i] = angle;
+    entities->length[i] = length;
+    entities->target_x[i] = x;
+    entities->target_y[i] = y;
+    entities->arrived[i] = FALSE;
+    entities->count++;
+    return i;
+}
+
+typedef struct ENTITY_JOB
+{
+    ENTITIES *entities;
+    int model;
+    fixed angle_stepsize;
+    fixed w, h;
+} ENTITY_JOB;
+
+// the racing car of CIRCLE 4, without the keys
+static void move_wrap (ENTITIES *e, int start, int end, fixed w, fixed h)
+{
+    int i;
+    for (i = start; i < end; i++)
+    {
+        fixed x = e->x[i] + fmul (e->length[i], fcos (e->angle[i]));
+        fixed y = e->y[i] + fmul (e->length[i], fsin (e->angle[i]));
+        if (x >= w) x -= w;
+        if (x < 0) x += w;
+        if (y >= h) y -= h;
+        if (y < 0) y += h;
+        e->x[i] = x;
+        e->y[i] = y;
+    }
+}
+
+// the first half of the loop of CIRCLE 7 and 8: move the missiles, and
+// see if they have reached their targets
+static void move_missiles (ENTITIES *e, int start, int end)
+{
+    int i;
+    for (i = start; i < end; i++)
+    {
+        e->x[i] += fmul (e->length[i], fcos (e->angle[i]));
+        e->y[i] += fmul (e->length[i], fsin (e->angle[i]));
+        if (abs (e->x[i] - e->target_x[i]) +
+            abs (e->y[i] - e->target_y[i]) < itofix (10))
+            e->arrived[i] = TRUE;
+    }
+}
+
+// the second half of the loop of CIRCLE 8: turn towards the target
+static void steer_dot_product (ENTITIES *e, int start, int end,
+    fixed angle_stepsize)
+{
+    int i;
+    for (i = start; i < end; i++)
+    {
+        // the vector of the missile movement, as in CIRCLE 8
+        fixed dx = fmul (e->length[i], fcos (e->angle[i]));
+        fixed dy = fmul (e->length[i], fsin (e->angle[i]));
+        if (fmul (dy, e->target_x[i] - e->x[i]) +
+            fmul (-dx, e->target_y[i] - e->y[i]) > 0)
+            e->angle[i] = (e->angle[i] - angle_stepsize) & 0xFFFFFF;
+        else
+            e->angle[i] = (e->angle[i] + angle_stepsize) & 0xFFFFFF;
+    }
+}
+
+static void update_chunk (void *data, int index)
+{
+    ENTITY_JOB *job = data;
+    ENTITIES *e = job->entities;
+    int start = index * ENTITY_CHUNK;
+    int end = MIN (start + ENTITY_CHUNK, e->count);
+
+    switch (job->model)
+    {
+        case MOVE_WRAP:
+            move_wrap (e, start, end, job->w, job->h);
+            break;
+        case MOVE_ATAN2:
+            move_missiles (e, start, end);
+            steer_missiles (e->x + start, e->y + start,
+                e->target_x + start, e->target_y + start,
+                e->angle + start, job->angle_stepsize, end - start);
+            break;
+        case MOVE_DOT_PRODUCT:
+            move_missiles (e, start, end);
+            steer_dot_product (e, start, end, job->angle_stepsize);
+            break;
+    }
+}
+
+void update_entities (ENTITIES *entities, int model, fixed angle_stepsize,
+    int w, int h, WORKER_POOL *pool)
+{
+    ENTITY_JOB job;
+    int i, chunks = (entities->count + ENTITY_CHUNK - 1) / ENTITY_CHUNK;
+
+    job.entities = entities;
+    job.model = model;
+    job.angle_stepsize = angle_stepsize;
+    job.w = itofix (w);
+    job.h = itofix (h);
+    if (pool)
+        run_workers (pool, update_chunk, &job, chunks);
+    else
+        for (i = 0; i < chunks; i++)
+            update_chunk (&job, i);
+}
@@ -0,0 +1,61 @@
+/*
+   ENTITIES.H
+   written by Martijn van Iersel (Amarillion)
+
+   CIRCLE 4, 7 and 8 each move a single racing car or missile, kept in
+   a small struct. To move a hundred thousand of them,
+   ENTITIES keeps the same variables in arrays, one array for each
+   variable. update_entities() moves all of them in one go, with the
+   threads of a worker pool (see ../common/workers.h).
+
+   The entities are divided into chunks of ENTITY_CHUNK, and each chunk
+   is a separate job. Nothing is shared between chunks, so the results
+   don't depend on the number of threads.
+*/
+
+#ifndef ENTITIES_H
+#define ENTITIES_H
+
+#include <allegro.h>
+#include "../common/workers.h"
+
+#define ENTITY_CHUNK 4096
+
+// the ways update_entities() can move the entities
+#define MOVE_WRAP 0 // straight on, wrapping around the screen (CIRCLE 4)
+#define MOVE_ATAN2 1 // homing in with atan2 (CIRCLE 7)
+#define MOVE_DOT_PRODUCT 2 // homing in with the dot product (CIRCLE 8)
+
+typedef struct ENTITIES
+{
+    int count; // number of entities
+    int max; // room in the arrays
+    fixed *x, *y; // position
+    fixed *angle, *length; // angle and length of the velocity vector
+    fixed *target_x, *target_y; // the target of a missile
+    // set to TRUE by update_entities() when a missile is within 10
+    // pixels of its target, so that a new target can be chosen
+    char *arrived;
+} ENTITIES;
+
+/* create_entities() makes room for max entities.
+   returns NULL if there is not enough memory. */
+ENTITIES *create_entities (int max);
+void destroy_entities (ENTITIES *entities);
+
+/* add_entity() adds an entity with the given position and velocity,
+   and with its target at its own position.
+   returns its index, or -1 if there is no more room. */
+int add_entity (ENTITIES *entities, fixed x, fixed y,
+    fixed angle, fixed length);
+
+/* update_entities() moves all entities one step, as the loop of CIRCLE 4,
+   7 or 8 does, depending on model. MOVE_WRAP wraps the position to
+   0 .. w and 0 .. h. The missiles turn angle_stepsize each step.
+   MOVE_ATAN2 steers with steer_missiles() (see steer.h), so it can
+   turn differently from CIRCLE 7 when a target is straight ahead.
+   pool may be NULL, then all the work is done by the calling thread. */
+void update_entities (ENTITIES *entities, int model, fixed angle_stepsize,
+    int w, int h, WORKER_POOL *pool);
+
+#endif
@@ -0,0 +1,107 @@
+/*
+    ENTITY BENCHMARK
+    Written by Amarillion (amarillion@yahoo.com)
+
+    This program measures how many entities per second update_entities()
+    (see entities.h) can move, for each movement model, for 100000 and
+    1000000 entities, with 1, 2, 4 and 8 threads. It doesn't need a
+    screen, the results are printed as text:
+
+    model,entities,threads,mupdates_per_sec,speedup
+
+    speedup is compared with a single thread. Only update_entities()
+    is timed, choosing new targets for the missiles that arrived is not.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <allegro.h>
+#include "entities.h"
+#include "../common/workers.h"
+#include "../common/walltime.h"
+
+// about this many entities are updated for each measurement
+#define UPDATES 20000000
+
+#define SCREEN_WIDTH 1920
+#define SCREEN_HEIGHT 1080
+
+const char *model_names[] = { "wrap", "atan2", "dot_product" };
+
+// a new target, as in CIRCLE 7 and 8
+void new_target (ENTITIES *entities, int i)
+{
+    entities->target_x[i] =
+        itofix ((SCREEN_WIDTH + rand () % (2 * SCREEN_WIDTH)) / 4);
+    entities->target_y[i] =
+        itofix ((SCREEN_HEIGHT + rand () % (2 * SCREEN_HEIGHT)) / 4);
+    entities->arrived[i] = FALSE;
+}
+
+// returns millions of updates per second
+double benchmark (int model, int count, WORKER_POOL *pool)
+{
+    ENTITIES *entities = create_entities (count);
+    int frames = UPDATES / count;
+    double start, seconds = 0;
+    int i, frame;
+
+    srand (1);
+    for (i = 0; i < count; i++)
+    {
+        add_entity (entities, itofix (rand () % SCREEN_WIDTH),
+            itofix (rand () % SCREEN_HEIGHT), itofix (rand () % 256),
+            model == MOVE_WRAP ? ftofix (2.0) : itofix (1));
+        new_target (entities, i);
+    }
+
+    for (frame = 0; frame < frames; frame++)
+    {
+        start = wall_time ();
+        update_entities (entities, model, itofix (3),
+            SCREEN_WIDTH, SCREEN_HEIGHT, pool);
+        seconds += wall_time () - start;
+        if (model != MOVE_WRAP)
+            for (i = 0; i < count; i++)
+                if (entities->arrived[i]) new_target (entities, i);
+    }
+
+    destroy_entities (entities);
+    return (double)frames * count / seconds / 1e6;
+}
+
+int main ()
+{
+    int counts[] = {100000, 1000000};
+    int thread_counts[] = {1, 2, 4, 8};
+    int model, i, t;
+
+    // we don't draw anything, so we don't need a graphics mode
+    if (allegro_init () < 0)
+    {
+        allegro_message ("Error: Could not initialize Allegro");
+        return -1;
+    }
+
+    printf ("model,entities,threads,mupdates_per_sec,speedup\n");
+    for (model = MOVE_WRAP; model <= MOVE_DOT_PRODUCT; model++)
+    {
+        for (i = 0; i < 2; i++)
+        {
+            double single = 0;
+            for (t = 0; t < 4; t++)
+            {
+                WORKER_POOL *pool = create_worker_pool (thread_counts[t]);
+                double speed = benchmark (model, counts[i], pool);
+                if (t == 0) single = speed;
+                printf ("%s,%d,%d,%.1f,%.2f\n", model_names[model],
+                    counts[i], thread_counts[t], speed, speed / single);
+                destroy_worker_pool (pool);
+            }
+        }
+    }
+
+    allegro_exit ();
+    return 0;
+
+} END_OF_MAIN ();
@@ -0,0 +1,268 @@
+/*
+   FASTCIRC.C
+   written by Martijn van Iersel (Amarillion)
+
+   See fastcirc.h
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <allegro.h>
+#include "fastcirc.h"
+
+// the rectangle a circle is clipped to, all four edges inclusive
+typedef struct CLIP_BOX
+{
+    int x1, y1, x2, y2;
+} CLIP_BOX;
+
+// circle_outline_8, circle_fill_8 and so on
+#define CIRCLE_DEPTH 8
+#include "fastcircdepth.c"
+#undef CIRCLE_DEPTH
+#define CIRCLE_DEPTH 16
+#include "fastcircdepth.c"
+#undef CIRCLE_DEPTH
+#define CIRCLE_DEPTH 24
+#include "fastcircdepth.c"
+#undef CIRCLE_DEPTH
+#define CIRCLE_DEPTH 32
+#include "fastcircdepth.c"
+#undef CIRCLE_DEPTH
+#define CIRCLE_DEPTH 0
+#include "fastcircdepth.c"
+#undef CIRCLE_DEPTH
+
+/*
+   The clipping rectangle of bmp. Without clipping Allegro lets you
+   draw outside the bitmap, but we write straight into memory, so we
+   always stay inside.
+*/
+static void get_clip_box (BITMAP *bmp, CLIP_BOX *clip)
+{
+    clip->x1 = 0;
+    clip->y1 = 0;
+    clip->x2 = bmp->w - 1;
+    clip->y2 = bmp->h - 1;
+    if (bmp->clip)
+    {
+        clip->x1 = MAX (clip->x1, bmp->cl);
+        clip->y1 = MAX (clip->y1, bmp->ct);
+        clip->x2 = MIN (clip->x2, bmp->cr - 1);
+        clip->y2 = MIN (clip->y2, bmp->cb - 1);
+    }
+}
+
+static void draw_clipped (BITMAP *bmp, int cx, int cy, int r, int color,
+    int filled, const CLIP_BOX *clip)
+{
+    // nothing to do if the circle is completely outside
+    if (r < 0 || cx + r < clip->x1 || cx - r > clip->x2 ||
+        cy + r < clip->y1 || cy - r > clip->y2)
+        return;
+
+    switch (is_memory_bitmap (bmp) ? bitmap_color_depth (bmp) : 0)
+    {
+        case 8:
+            if (filled) circle_fill_8 (bmp, cx, cy, r, color, clip);
+            else circle_outline_8 (bmp, cx, cy, r, color, clip);
+            break;
+        case 15:
+        case 16:
+            if (filled) circle_fill_16 (bmp, cx, cy, r, color, clip);
+            else circle_outline_16 (bmp, cx, cy, r, color, clip);
+            break;
+        case 24:
+            if (filled) circle_fill_24 (bmp, cx, cy, r, color, clip);
+            else circle_outline_24 (bmp, cx, cy, r, color, clip);
+            break;
+        case 32:
+            if (filled) circle_fill_32 (bmp, cx, cy, r, color, clip);
+            else circle_outline_32 (bmp, cx, cy, r, color, clip);
+            break;
+        default:
+            if (filled) circle_fill_0 (bmp, cx, cy, r, color, clip);
+            else circle_outline_0 (bmp, cx, cy, r, color, clip);
+            break;
+    }
+}
+
+void fast_circle (BITMAP *bmp, int cx, int cy, int r, int color)
+{
+    CLIP_BOX clip;
+    get_clip_box (bmp, &clip);
+    draw_clipped (bmp, cx, cy, r, color, FALSE, &clip);
+}
+
+void fast_circlefill (BITMAP *bmp, int cx, int cy, int r, int color)
+{
+    CLIP_BOX clip;
+    get_clip_box (bmp, &clip);
+    draw_clipped (bmp, cx, cy, r, color, TRUE, &clip);
+}
+
+/* CIRCLE_TILES holds everything the worker threads need to know.
+   The circles that touch tile t are
+   circles[index[start[t]]] .. circles[index[start[t + 1] - 1]] */
+typedef struct CIRCLE_TILES
+{
+    BITMAP *bmp;
+    const FAST_CIRCLE *circles;
+    int filled;
+    CLIP_BOX clip; // of the whole bitmap
+    int tiles_x, tiles_y;
+    int *start;
+    int *index;
+} CIRCLE_TILES;
+
+static void get_tile_box (const CIRCLE_TILES *tiles, int tx, int ty,
+    CLIP_BOX *box)
+{
+    box->x1 = tiles->clip.x1 + tx * CIRCLE_TILE_SIZE;
+    box->y1 = tiles->clip.y1 + ty * CIRCLE_TILE_SIZE;
+    box->x2 = MIN (box->x1 + CIRCLE_TILE_SIZE - 1, tiles->clip.x2);
+    box->y2 = MIN (box->y1 + CIRCLE_TILE_SIZE - 1, tiles->clip.y2);
+}
+
+/*
+   An outline never comes closer to the center than r - 1, so a tile
+   that lies completely within that distance can be skipped. Only the
+   corner of the tile that is furthest away has to be checked.
+*/
+static int tile_inside_outline (const FAST_CIRCLE *c, const CLIP_BOX *box)
+{
+    long long dx = MAX (abs (box->x1 - c->x), abs (box->x2 - c->x));
+    long long dy = MAX (abs (box->y1 - c->y), abs (box->y2 - c->y));
+    long long inner = c->r - 1;
+    return c->r > 1 && dx * dx + dy * dy < inner * inner;
+}
+
+/*
+   Goes through the tiles that each circle touches. This is done
+   twice: first to count the circles of each tile, then with fill_in
+   TRUE to fill in the lists.
+*/
+static void bin_circles (CIRCLE_TILES *tiles, int count, int fill_in)
+{
+    const CLIP_BOX *clip = &tiles->clip;
+    int n, tx, ty;
+
+    for (n = 0; n < count; n++)
+    {
+        const FAST_CIRCLE *c = &tiles->circles[n];
+        int tx1, ty1, tx2, ty2;
+
+        if (c->r < 0 || c->x + c->r < clip->x1 || c->x - c->r > clip->x2 ||
+            c->y + c->r < clip->y1 || c->y - c->r > clip->y2)
+            continue;
+
+        tx1 = (MAX (c->x - c->r, clip->x1) - clip->x1) / CIRCLE_TILE_SIZE;
+        ty1 = (MAX (c->y - c->r, clip->y1) - clip->y1) / CIRCLE_TILE_SIZE;
+        tx2 = (MIN (c->x + c->r, clip->x2) - clip->x1) / CIRCLE_TILE_SIZE;
+        ty2 = (MIN (c->y + c->r, clip->y2) - clip->y1) / CIRCLE_TILE_SIZE;
+
+        for (ty = ty1; ty <= ty2; ty++)
+        {
+            for (tx = tx1; tx <= tx2; tx++)
+            {
+                int t = ty * tiles->tiles_x + tx;
+                if (!tiles->filled)
+                {
+                    CLIP_BOX box;
+                    get_tile_box (tiles, tx, ty, &box);
+                    if (tile_inside_outline (c, &box)) continue;
+                }
+                // the first time start[t + 1] counts the circles,
+                // the second time start[t] is where the next one goes
+                if (fill_in)
+                    tiles->index[tiles->start[t]++] = n;
+                else
+                    tiles->start[t + 1]++;
+            }
+        }
+    }
+}
+
+// draw_circle_tile is called by the worker pool for each tile
+static void draw_circle_tile (void *data, int t)
+{
+    CIRCLE_TILES *tiles = data;
+    CLIP_BOX box;
+    int i;
+
+    get_tile_box (tiles, t % tiles->tiles_x, t / tiles->tiles_x, &box);
+    for (i = tiles->start[t]; i < tiles->start[t + 1]; i++)
+    {
+        const FAST_CIRCLE *c = &tiles->circles[tiles->index[i]];
+        draw_clipped (tiles->bmp, c->x, c->y, c->r, c->color,
+            tiles->filled, &box);
+    }
+}
+
+static void draw_one_by_one (BITMAP *bmp, const FAST_CIRCLE *circles,
+    int count, int filled, const CLIP_BOX *clip)
+{
+    int i;
+    for (i = 0; i < count; i++)
+        draw_clipped (bmp, circles[i].x, circles[i].y, circles[i].r,
+            circles[i].color, filled, clip);
+}
+
+void draw_circles (BITMAP *bmp, const FAST_CIRCLE *circles, int count,
+    int filled, WORKER_POOL *pool)
+{
+    CIRCLE_TILES tiles;
+    int num_tiles, t, total;
+
+    tiles.bmp = bmp;
+    tiles.circles = circles;
+    tiles.filled = filled;
+    get_clip_box (bmp, &tiles.clip);
+    if (tiles.clip.x1 > tiles.clip.x2 || tiles.clip.y1 > tiles.clip.y2)
+        return;
+
+    // one thread doesn't need tiles. putpixel () on the screen from
+    // several threads at once isn't safe, so neither does that.
+    if (!pool || worker_pool_size (pool) < 2 || !is_memory_bitmap (bmp))
+    {
+        draw_one_by_one (bmp, circles, count, filled, &tiles.clip);
+        return;
+    }
+
+    tiles.tiles_x = (tiles.clip.x2 - tiles.clip.x1) / CIRCLE_TILE_SIZE + 1;
+    tiles.tiles_y = (tiles.clip.y2 - tiles.clip.y1) / CIRCLE_TILE_SIZE + 1;
+    num_tiles = tiles.tiles_x * tiles.tiles_y;
+
+    // count the circles of each tile
+    tiles.start = calloc (num_tiles + 1, sizeof (int));
+    tiles.index = NULL;
+    if (tiles.start)
+    {
+        bin_circles (&tiles, count, FALSE);
+        for (t = 0; t < num_tiles; t++)
+            tiles.start[t + 1] += tiles.start[t];
+        total = tiles.start[num_tiles];
+        tiles.index = malloc (MAX (total, 1) * sizeof (int));
+    }
+    if (!tiles.index)
+    {
+        // out of memory, draw them on this thread after all
+        free (tiles.start);
+        draw_one_by_one (bmp, circles, count, filled, &tiles.clip);
+        return;
+    }
+
+    // fill in the lists. This moves each start[t] to the end of the
+    // list of tile t, which is where the list of tile t + 1 starts,
+    // so afterwards everything is shifted up by one.
+    bin_circles (&tiles, count, TRUE);
+    for (t = num_tiles; t > 0; t--)
+        tiles.start[t] = tiles.start[t - 1];
+    tiles.start[0] = 0;
+
+    run_workers (pool, draw_circle_tile, &tiles, num_tiles);
+
+    free (tiles.index);
+    free (tiles.start);
+}
@@ -0,0 +1,57 @@
+/*
+   FASTCIRC.H
+   written by Martijn van Iersel (Amarillion)
+
+   my_draw_circle() in CIRCLE 6 draws a circle without sin or cos, but
+   it still does six multiplications per step, and each of the 8
+   pixels goes through putpixel(). fast_circle() draws exactly the same
+   pixels, but it keeps x * x + y * y - r * r up to date with additions
+   only, and writes straight into the lines of the bitmap.
+
+   The decision of my_draw_circle is whether
+   abs (x*x + y*y - r*r) > abs (x*x + (y-1)*(y-1) - r*r). With
+   e = x*x + y*y - r*r that is the same as e >= y, and when x goes up by
+   one, e goes up by 2x - 1 (with the new x). When y goes down by one,
+   e goes down by 2y - 1 (with the old y).
+
+   draw_circles() draws thousands of circles at once. It divides the
+   bitmap into tiles, makes a list of the circles that touch each tile,
+   and lets the threads of a worker pool (see ../common/workers.h) draw
+   the tiles. Each circle is clipped to the tile it is drawn in, so two
+   threads never write to the same pixel, and the circles in a tile are
+   drawn in the same order as in the array. The result is the same as
+   drawing them one by one.
+*/
+
+#ifndef FASTCIRC_H
+#define FASTCIRC_H
+
+#include <allegro.h>
+#include "../common/workers.h"
+
+/* fast_circle() draws the same pixels as my_draw_circle() in
+   CIRCLE 6. It respects the clipping rectangle of bmp. */
+void fast_circle (BITMAP *bmp, int cx, int cy, int r, int color);
+
+/* fast_circlefill() draws a filled circle, one horizontal span per
+   line. It covers exactly the pixels on and inside fast_circle(). */
+void fast_circlefill (BITMAP *bmp, int cx, int cy, int r, int color);
+
+// one circle for draw_circles()
+typedef struct FAST_CIRCLE
+{
+    int x, y, r;
+    int color;
+} FAST_CIRCLE;
+
+// the width and height of the tiles of draw_circles()
+#define CIRCLE_TILE_SIZE 128
+
+/* draw_circles() draws count circles, filled when filled is TRUE,
+   with fast_circle() or fast_circlefill(). pool can be NULL to draw
+   them all on the calling thread. On a bitmap that is not a memory
+   bitmap the circles are always drawn on the calling thread. */
+void draw_circles (BITMAP *bmp, const FAST_CIRCLE *circles, int count,
+    int filled, WORKER_POOL *pool);
+
+#endif
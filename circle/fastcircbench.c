@@ -0,0 +1,146 @@
+/*
+    FAST CIRCLE BENCHMARK
+    Written by Amarillion (amarillion@yahoo.com)
+
+    This program draws 5000 circles per frame on a 1920x1080 memory
+    bitmap: with my_draw_circle (CIRCLE 6), Allegro's circle and
+    circlefill, fast_circle and fast_circlefill, and with draw_circles
+    on 1 to 8 threads (see fastcirc.h). Some of the circles stick out
+    of the bitmap, so clipping is measured too. It doesn't need a
+    screen, the results are printed as text:
+
+    shape,method,circles,threads,ms_per_frame,differing_pixels
+
+    differing_pixels is the number of pixels that differ from what
+    fast_circle or fast_circlefill drew. Like the red and white circles
+    in CIRCLE 6, Allegro's routines draw slightly different circles.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <allegro.h>
+#include "fastcirc.h"
+#include "../common/workers.h"
+#include "../common/walltime.h"
+
+// we only want my_draw_circle, not the main() of CIRCLE 6
+#define KERNELS_ONLY
+#include "circ6.c"
+
+#define CIRCLES 5000
+#define FRAMES 10
+
+// the ways to draw a frame
+#define MY_DRAW_CIRCLE 0
+#define ALLEGRO 1
+#define FAST 2
+#define DRAW_CIRCLES 3
+
+FAST_CIRCLE circles[CIRCLES];
+
+void draw_frame (BITMAP *bmp, int method, int filled, WORKER_POOL *pool)
+{
+    int i;
+    for (i = 0; i < CIRCLES && method != DRAW_CIRCLES; i++)
+    {
+        const FAST_CIRCLE *c = &circles[i];
+        if (method == MY_DRAW_CIRCLE)
+            my_draw_circle (bmp, c->x, c->y, c->r, c->color);
+        else if (method == ALLEGRO && filled)
+            circlefill (bmp, c->x, c->y, c->r, c->color);
+        else if (method == ALLEGRO)
+            circle (bmp, c->x, c->y, c->r, c->color);
+        else if (filled)
+            fast_circlefill (bmp, c->x, c->y, c->r, c->color);
+        else
+            fast_circle (bmp, c->x, c->y, c->r, c->color);
+    }
+    if (method == DRAW_CIRCLES)
+        draw_circles (bmp, circles, CIRCLES, filled, pool);
+}
+
+int count_differences (BITMAP *a, BITMAP *b)
+{
+    int x, y, n = 0;
+    for (y = 0; y < a->h; y++)
+        for (x = 0; x < a->w; x++)
+            if (((uint32_t *)a->line[y])[x] != ((uint32_t *)b->line[y])[x])
+                n++;
+    return n;
+}
+
+void benchmark (BITMAP *bmp, BITMAP *reference, const char *name,
+    int method, int filled, WORKER_POOL *pool)
+{
+    double start, seconds = 0;
+    int frame;
+
+    // only the drawing is timed, not the clearing
+    for (frame = 0; frame < FRAMES; frame++)
+    {
+        clear_bitmap (bmp);
+        start = wall_time ();
+        draw_frame (bmp, method, filled, pool);
+        seconds += wall_time () - start;
+    }
+
+    printf ("%s,%s,%d,%d,%.3f,%d\n", filled ? "filled" : "outline", name,
+        CIRCLES, pool ? worker_pool_size (pool) : 1,
+        seconds * 1000.0 / FRAMES, count_differences (bmp, reference));
+}
+
+int main ()
+{
+    const int thread_counts[] = { 1, 2, 4, 8 };
+    BITMAP *bmp, *reference;
+    int i, t, filled;
+
+    // we don't draw on the screen, so we don't need a graphics mode
+    if (allegro_init () < 0)
+    {
+        allegro_message ("Error: Could not initialize Allegro");
+        return -1;
+    }
+
+    bmp = create_bitmap_ex (32, 1920, 1080);
+    reference = create_bitmap_ex (32, 1920, 1080);
+
+    // mostly small circles, a few big ones, some partly outside
+    srand (1);
+    for (i = 0; i < CIRCLES; i++)
+    {
+        circles[i].x = rand () % 2000 - 40;
+        circles[i].y = rand () % 1160 - 40;
+        circles[i].r = (i % 50 == 0) ? 100 + rand () % 300 : 2 + rand () % 40;
+        circles[i].color = makecol32 (rand () & 255, rand () & 255,
+            rand () & 255);
+    }
+
+    printf ("shape,method,circles,threads,ms_per_frame,differing_pixels\n");
+    for (filled = 0; filled < 2; filled++)
+    {
+        clear_bitmap (reference);
+        draw_frame (reference, FAST, filled, NULL);
+
+        if (!filled)
+            benchmark (bmp, reference, "my_draw_circle", MY_DRAW_CIRCLE,
+                filled, NULL);
+        benchmark (bmp, reference, filled ? "circlefill" : "circle",
+            ALLEGRO, filled, NULL);
+        benchmark (bmp, reference, filled ? "fast_circlefill" : "fast_circle",
+            FAST, filled, NULL);
+        for (t = 0; t < 4; t++)
+        {
+            WORKER_POOL *pool = create_worker_pool (thread_counts[t]);
+            benchmark (bmp, reference, "draw_circles", DRAW_CIRCLES,
+                filled, pool);
+            destroy_worker_pool (pool);
+        }
+    }
+
+    destroy_bitmap (reference);
+    destroy_bitmap (bmp);
+    allegro_exit ();
+    return 0;
+
+} END_OF_MAIN ();
@@ -0,0 +1,181 @@
+/*
+    FASTCIRCDEPTH.C
+    Written by Amarillion (amarillion@yahoo.com)
+
+    The drawing loops of fast_circle() and fast_circlefill() (see
+    fastcirc.h) for one color depth. fastcirc.c includes this file once
+    for each depth, with CIRCLE_DEPTH defined as 8, 16, 24 or 32. Each
+    time it adds circle_outline_8, circle_fill_8 and so on, so that the
+    inner loops don't have to check the color depth for every pixel.
+    With CIRCLE_DEPTH 0 the pixels go through putpixel() and hline(),
+    for bitmaps that are not memory bitmaps.
+
+    clip is a CLIP_BOX, the pixels outside it are not drawn.
+*/
+
+#define DEPTH_NAME3(name, depth) name##_##depth
+#define DEPTH_NAME2(name, depth) DEPTH_NAME3 (name, depth)
+#define DEPTH_NAME(name) DEPTH_NAME2 (name, CIRCLE_DEPTH)
+
+#if CIRCLE_DEPTH == 8
+
+#define PUT(bmp, x, y, c) ((bmp)->line[y][x] = (c))
+#define SPAN(bmp, x1, x2, y, c) memset ((bmp)->line[y] + (x1), (c), (x2) - (x1) + 1)
+
+#elif CIRCLE_DEPTH == 16
+
+#define PUT(bmp, x, y, c) (((uint16_t *)(bmp)->line[y])[x] = (c))
+#define SPAN(bmp, x1, x2, y, c) \
+    { \
+        uint16_t *d = (uint16_t *)(bmp)->line[y]; \
+        int i; \
+        for (i = (x1); i <= (x2); i++) d[i] = (c); \
+    }
+
+#elif CIRCLE_DEPTH == 24
+
+// 24 bit pixels are 3 bytes, there is no type for that
+#define PUT(bmp, x, y, c) \
+    { \
+        unsigned char *d = (bmp)->line[y] + (x) * 3; \
+        d[0] = (c); \
+        d[1] = (c) >> 8; \
+        d[2] = (c) >> 16; \
+    }
+#define SPAN(bmp, x1, x2, y, c) \
+    { \
+        unsigned char *d = (bmp)->line[y] + (x1) * 3; \
+        int i; \
+        for (i = (x1); i <= (x2); i++, d += 3) \
+        { \
+            d[0] = (c); \
+            d[1] = (c) >> 8; \
+            d[2] = (c) >> 16; \
+        } \
+    }
+
+#elif CIRCLE_DEPTH == 32
+
+#define PUT(bmp, x, y, c) (((uint32_t *)(bmp)->line[y])[x] = (c))
+#define SPAN(bmp, x1, x2, y, c) \
+    { \
+        uint32_t *d = (uint32_t *)(bmp)->line[y]; \
+        int i; \
+        for (i = (x1); i <= (x2); i++) d[i] = (c); \
+    }
+
+#else
+
+#define PUT(bmp, x, y, c) putpixel (bmp, x, y, c)
+#define SPAN(bmp, x1, x2, y, c) hline (bmp, x1, y, x2, c)
+
+#endif
+
+#define PUT_CLIPPED(bmp, x, y, c) \
+    if ((x) >= clip->x1 && (x) <= clip->x2 && \
+        (y) >= clip->y1 && (y) <= clip->y2) \
+        PUT (bmp, x, y, c)
+
+// a horizontal line, cut off at the edges of clip
+#define SPAN_CLIPPED(bmp, from, to, y, c) \
+    if ((y) >= clip->y1 && (y) <= clip->y2) \
+    { \
+        int left = MAX (from, clip->x1), right = MIN (to, clip->x2); \
+        if (left <= right) SPAN (bmp, left, right, y, c); \
+    }
+
+static void DEPTH_NAME (circle_outline) (BITMAP *bmp, int cx, int cy, int r,
+    int color, const CLIP_BOX *clip)
+{
+    int x = 0, y = r;
+    int e = 0; // x*x + y*y - r*r
+
+    if (cx - r >= clip->x1 && cx + r <= clip->x2 &&
+        cy - r >= clip->y1 && cy + r <= clip->y2)
+    {
+        // the whole circle is inside, no need to check each pixel
+        while (x <= y)
+        {
+            PUT (bmp, cx + x, cy + y, color);
+            PUT (bmp, cx - x, cy + y, color);
+            PUT (bmp, cx + x, cy - y, color);
+            PUT (bmp, cx - x, cy - y, color);
+            PUT (bmp, cx + y, cy + x, color);
+            PUT (bmp, cx - y, cy + x, color);
+            PUT (bmp, cx + y, cy - x, color);
+            PUT (bmp, cx - y, cy - x, color);
+
+            // see fastcirc.h
+            x++;
+            e += x + x - 1;
+            if (e >= y)
+            {
+                e -= y + y - 1;
+                y--;
+            }
+        }
+    }
+    else
+    {
+        while (x <= y)
+        {
+            PUT_CLIPPED (bmp, cx + x, cy + y, color);
+            PUT_CLIPPED (bmp, cx - x, cy + y, color);
+            PUT_CLIPPED (bmp, cx + x, cy - y, color);
+            PUT_CLIPPED (bmp, cx - x, cy - y, color);
+            PUT_CLIPPED (bmp, cx + y, cy + x, color);
+            PUT_CLIPPED (bmp, cx - y, cy + x, color);
+            PUT_CLIPPED (bmp, cx + y, cy - x, color);
+            PUT_CLIPPED (bmp, cx - y, cy - x, color);
+
+            x++;
+            e += x + x - 1;
+            if (e >= y)
+            {
+                e -= y + y - 1;
+                y--;
+            }
+        }
+    }
+}
+
+/*
+    The same steps as circle_outline, but instead of 8 pixels we draw
+    the lines between them. The lines cy + x and cy - x reach out to y.
+    The lines cy + y and cy - y are done when y goes down, they reach
+    out to the last x, unless they were already drawn as one of the
+    lines cy + x.
+*/
+static void DEPTH_NAME (circle_fill) (BITMAP *bmp, int cx, int cy, int r,
+    int color, const CLIP_BOX *clip)
+{
+    int x = 0, y = r;
+    int e = 0; // x*x + y*y - r*r
+
+    while (x <= y)
+    {
+        SPAN_CLIPPED (bmp, cx - y, cx + y, cy + x, color);
+        if (x > 0) SPAN_CLIPPED (bmp, cx - y, cx + y, cy - x, color);
+
+        x++;
+        e += x + x - 1;
+        if (e >= y)
+        {
+            if (y >= x)
+            {
+                SPAN_CLIPPED (bmp, cx - x + 1, cx + x - 1, cy + y, color);
+                SPAN_CLIPPED (bmp, cx - x + 1, cx + x - 1, cy - y, color);
+            }
+            e -= y + y - 1;
+            y--;
+        }
+    }
+}
+
+#undef DEPTH_NAME3
+#undef DEPTH_NAME2
+#undef DEPTH_NAME
+#undef PUT
+#undef SPAN
+#undef PUT_CLIPPED
+#undef SPAN_CLIPPED
@@ -0,0 +1,325 @@
+/*
+   PROJECT.C
+   written by Martijn van Iersel (Amarillion)
+
+   See project.h
+*/
+
+#include <math.h>
+#include <allegro.h>
+#include "project.h"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define PROJECT_X86
+#include <immintrin.h>
+#endif
+
+// FALSE if set_project_simd (FALSE) was called
+static int use_simd = TRUE;
+
+/*
+   The sine and cosine of a fixed angle as floats. Not fixtof (fsin ()),
+   that would be only as accurate as the fixed version.
+*/
+static void float_sincos (fixed angle, float *s, float *c)
+{
+    float a = fixtof (angle) * (float)(AL_PI / 128.0);
+    *s = sinf (a);
+    *c = cosf (a);
+}
+
+#ifdef PROJECT_X86
+
+/*
+   fmul() on 8 pairs at once: the 64 bit product, shifted right by 16.
+   _mm256_mul_epi32 only multiplies the even lanes, so the odd lanes
+   are shifted down first. The lower 32 bits of the result are the same
+   with a logical shift as with an arithmetic one.
+*/
+__attribute__((target("avx2")))
+static __m256i fmul_avx2 (__m256i a, __m256i b)
+{
+    __m256i even = _mm256_srli_epi64 (_mm256_mul_epi32 (a, b), 16);
+    __m256i odd = _mm256_slli_epi64 (_mm256_mul_epi32 (
+        _mm256_srli_epi64 (a, 32), _mm256_srli_epi64 (b, 32)), 16);
+    return _mm256_blend_epi32 (even, odd, 0xAA);
+}
+
+// returns how many points it did, the rest is left for the C version
+__attribute__((target("avx2")))
+static int rotate_avx2 (const fixed *x, const fixed *y,
+    fixed *proj_x, fixed *proj_y, int count,
+    fixed s, fixed c, fixed cx, fixed cy)
+{
+    __m256i vs = _mm256_set1_epi32 (s);
+    __m256i vc = _mm256_set1_epi32 (c);
+    __m256i vcx = _mm256_set1_epi32 (cx);
+    __m256i vcy = _mm256_set1_epi32 (cy);
+    int i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        __m256i vx = _mm256_loadu_si256 ((const __m256i *)(x + i));
+        __m256i vy = _mm256_loadu_si256 ((const __m256i *)(y + i));
+        _mm256_storeu_si256 ((__m256i *)(proj_x + i), _mm256_add_epi32 (
+            _mm256_sub_epi32 (fmul_avx2 (vx, vc), fmul_avx2 (vy, vs)), vcx));
+        _mm256_storeu_si256 ((__m256i *)(proj_y + i), _mm256_add_epi32 (
+            _mm256_add_epi32 (fmul_avx2 (vx, vs), fmul_avx2 (vy, vc)), vcy));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static int rotate_float_avx2 (const float *x, const float *y,
+    float *proj_x, float *proj_y, int count,
+    float s, float c, float cx, float cy)
+{
+    __m256 vs = _mm256_set1_ps (s);
+    __m256 vc = _mm256_set1_ps (c);
+    __m256 vcx = _mm256_set1_ps (cx);
+    __m256 vcy = _mm256_set1_ps (cy);
+    int i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        __m256 vx = _mm256_loadu_ps (x + i);
+        __m256 vy = _mm256_loadu_ps (y + i);
+        _mm256_storeu_ps (proj_x + i, _mm256_add_ps (_mm256_sub_ps (
+            _mm256_mul_ps (vx, vc), _mm256_mul_ps (vy, vs)), vcx));
+        _mm256_storeu_ps (proj_y + i, _mm256_add_ps (_mm256_add_ps (
+            _mm256_mul_ps (vx, vs), _mm256_mul_ps (vy, vc)), vcy));
+    }
+    return i;
+}
+
+/*
+   a / b for 8 pairs of floats. With -ffast-math gcc turns a float
+   division into an approximate one, but only for vectors, so the C
+   version would differ. A division in double rounded to float is the
+   same as an exact float division (see also steer.c).
+*/
+__attribute__((target("avx2")))
+static __m256 div_avx2 (__m256 a, __m256 b)
+{
+    return _mm256_setr_m128 (
+        _mm256_cvtpd_ps (_mm256_div_pd (
+            _mm256_cvtps_pd (_mm256_castps256_ps128 (a)),
+            _mm256_cvtps_pd (_mm256_castps256_ps128 (b)))),
+        _mm256_cvtpd_ps (_mm256_div_pd (
+            _mm256_cvtps_pd (_mm256_extractf128_ps (a, 1)),
+            _mm256_cvtps_pd (_mm256_extractf128_ps (b, 1)))));
+}
+
+/*
+   The scale of 8 points at depth d, like ftofix (fixtof (focal) /
+   fixtof (d)), which is what fixdiv (focal, d) does. d must be at least
+   PROJECT_NEAR, so the result is positive and rounding is adding 0.5.
+*/
+__attribute__((target("avx2")))
+static __m256i scale_avx2 (__m256d focal, __m256i d)
+{
+    __m256d half = _mm256_set1_pd (0.5);
+    __m128i lo = _mm256_cvttpd_epi32 (_mm256_add_pd (_mm256_div_pd (focal,
+        _mm256_cvtepi32_pd (_mm256_castsi256_si128 (d))), half));
+    __m128i hi = _mm256_cvttpd_epi32 (_mm256_add_pd (_mm256_div_pd (focal,
+        _mm256_cvtepi32_pd (_mm256_extracti128_si256 (d, 1))), half));
+    return _mm256_setr_m128i (lo, hi);
+}
+
+__attribute__((target("avx2")))
+static int project_avx2 (const fixed *x, const fixed *y, const fixed *z,
+    fixed *proj_x, fixed *proj_y, fixed *depth, int count,
+    PROJECT_PARAMS params, fixed sh, fixed ch, fixed sp, fixed cp)
+{
+    __m256i vsh = _mm256_set1_epi32 (sh), vch = _mm256_set1_epi32 (ch);
+    __m256i vsp = _mm256_set1_epi32 (sp), vcp = _mm256_set1_epi32 (cp);
+    __m256i distance = _mm256_set1_epi32 (params.distance);
+    __m256i vnear = _mm256_set1_epi32 (PROJECT_NEAR);
+    __m256i cx = _mm256_set1_epi32 (params.cx);
+    __m256i cy = _mm256_set1_epi32 (params.cy);
+    __m256d focal = _mm256_set1_pd (params.focal * 65536.0);
+    int i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        __m256i vx = _mm256_loadu_si256 ((const __m256i *)(x + i));
+        __m256i vy = _mm256_loadu_si256 ((const __m256i *)(y + i));
+        __m256i vz = _mm256_loadu_si256 ((const __m256i *)(z + i));
+        __m256i x1 = _mm256_add_epi32 (fmul_avx2 (vx, vch), fmul_avx2 (vz, vsh));
+        __m256i z1 = _mm256_sub_epi32 (fmul_avx2 (vz, vch), fmul_avx2 (vx, vsh));
+        __m256i y2 = _mm256_sub_epi32 (fmul_avx2 (vy, vcp), fmul_avx2 (z1, vsp));
+        __m256i d = _mm256_add_epi32 (_mm256_add_epi32 (fmul_avx2 (vy, vsp),
+            fmul_avx2 (z1, vcp)), distance);
+        __m256i visible = _mm256_cmpgt_epi32 (d,
+            _mm256_sub_epi32 (vnear, _mm256_set1_epi32 (1)));
+        // the points that are too close get a harmless depth instead
+        __m256i scale = scale_avx2 (focal, _mm256_max_epi32 (d, vnear));
+        _mm256_storeu_si256 ((__m256i *)(proj_x + i), _mm256_and_si256 (visible,
+            _mm256_add_epi32 (fmul_avx2 (x1, scale), cx)));
+        _mm256_storeu_si256 ((__m256i *)(proj_y + i), _mm256_and_si256 (visible,
+            _mm256_add_epi32 (fmul_avx2 (y2, scale), cy)));
+        _mm256_storeu_si256 ((__m256i *)(depth + i), d);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static int project_float_avx2 (const float *x, const float *y, const float *z,
+    float *proj_x, float *proj_y, float *depth, int count,
+    float distance, float focal, float cx, float cy,
+    float sh, float ch, float sp, float cp)
+{
+    __m256 vsh = _mm256_set1_ps (sh), vch = _mm256_set1_ps (ch);
+    __m256 vsp = _mm256_set1_ps (sp), vcp = _mm256_set1_ps (cp);
+    __m256 vdistance = _mm256_set1_ps (distance);
+    __m256 vnear = _mm256_set1_ps (fixtof (PROJECT_NEAR));
+    __m256 vfocal = _mm256_set1_ps (focal);
+    __m256 vcx = _mm256_set1_ps (cx);
+    __m256 vcy = _mm256_set1_ps (cy);
+    int i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        __m256 vx = _mm256_loadu_ps (x + i);
+        __m256 vy = _mm256_loadu_ps (y + i);
+        __m256 vz = _mm256_loadu_ps (z + i);
+        __m256 x1 = _mm256_add_ps (_mm256_mul_ps (vx, vch), _mm256_mul_ps (vz, vsh));
+        __m256 z1 = _mm256_sub_ps (_mm256_mul_ps (vz, vch), _mm256_mul_ps (vx, vsh));
+        __m256 y2 = _mm256_sub_ps (_mm256_mul_ps (vy, vcp), _mm256_mul_ps (z1, vsp));
+        __m256 d = _mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (vy, vsp),
+            _mm256_mul_ps (z1, vcp)), vdistance);
+        __m256 visible = _mm256_cmp_ps (d, vnear, _CMP_GE_OQ);
+        __m256 scale = div_avx2 (vfocal, _mm256_max_ps (d, vnear));
+        _mm256_storeu_ps (proj_x + i, _mm256_and_ps (visible,
+            _mm256_add_ps (_mm256_mul_ps (x1, scale), vcx)));
+        _mm256_storeu_ps (proj_y + i, _mm256_and_ps (visible,
+            _mm256_add_ps (_mm256_mul_ps (y2, scale), vcy)));
+        _mm256_storeu_ps (depth + i, d);
+    }
+    return i;
+}
+
+#endif
+
+void rotate_points (const fixed *x, const fixed *y,
+    fixed *proj_x, fixed *proj_y, int count,
+    fixed angle, fixed cx, fixed cy)
+{
+    fixed s = fsin (angle), c = fcos (angle);
+    int i = 0;
+#ifdef PROJECT_X86
+    if (use_simd && project_simd_supported ())
+        i = rotate_avx2 (x, y, proj_x, proj_y, count, s, c, cx, cy);
+#endif
+    for (; i < count; i++)
+    {
+        // see circ10.c
+        proj_x[i] = fmul (x[i], c) - fmul (y[i], s) + cx;
+        proj_y[i] = fmul (x[i], s) + fmul (y[i], c) + cy;
+    }
+}
+
+void rotate_points_float (const float *x, const float *y,
+    float *proj_x, float *proj_y, int count,
+    fixed angle, fixed cx, fixed cy)
+{
+    float s, c, fcx = fixtof (cx), fcy = fixtof (cy);
+    int i = 0;
+
+    float_sincos (angle, &s, &c);
+#ifdef PROJECT_X86
+    if (use_simd && project_simd_supported ())
+        i = rotate_float_avx2 (x, y, proj_x, proj_y, count, s, c, fcx, fcy);
+#endif
+    for (; i < count; i++)
+    {
+        proj_x[i] = (x[i] * c - y[i] * s) + fcx;
+        proj_y[i] = (x[i] * s + y[i] * c) + fcy;
+    }
+}
+
+void project_points (const fixed *x, const fixed *y, const fixed *z,
+    fixed *proj_x, fixed *proj_y, fixed *depth, int count,
+    PROJECT_PARAMS params)
+{
+    fixed sh = fsin (params.heading), ch = fcos (params.heading);
+    fixed sp = fsin (params.pitch), cp = fcos (params.pitch);
+    int i = 0;
+#ifdef PROJECT_X86
+    if (use_simd && project_simd_supported ())
+        i = project_avx2 (x, y, z, proj_x, proj_y, depth, count, params,
+            sh, ch, sp, cp);
+#endif
+    for (; i < count; i++)
+    {
+        fixed x1, z1, y2, scale;
+
+        // turn around the y axis, then around the x axis
+        x1 = fmul (x[i], ch) + fmul (z[i], sh);
+        z1 = fmul (z[i], ch) - fmul (x[i], sh);
+        y2 = fmul (y[i], cp) - fmul (z1, sp);
+        depth[i] = fmul (y[i], sp) + fmul (z1, cp) + params.distance;
+
+        if (depth[i] < PROJECT_NEAR)
+        {
+            proj_x[i] = proj_y[i] = 0;
+            continue;
+        }
+        // the further away, the closer to the middle of the screen.
+        // This is fixdiv (params.focal, depth[i]), written out so that
+        // it is the same as in the AVX2 version
+        scale = (fixed)((params.focal * 65536.0) / depth[i] + 0.5);
+        proj_x[i] = fmul (x1, scale) + params.cx;
+        proj_y[i] = fmul (y2, scale) + params.cy;
+    }
+}
+
+void project_points_float (const float *x, const float *y, const float *z,
+    float *proj_x, float *proj_y, float *depth, int count,
+    PROJECT_PARAMS params)
+{
+    float sh, ch, sp, cp;
+    float distance = fixtof (params.distance), focal = fixtof (params.focal);
+    float cx = fixtof (params.cx), cy = fixtof (params.cy);
+    int i = 0;
+
+    float_sincos (params.heading, &sh, &ch);
+    float_sincos (params.pitch, &sp, &cp);
+#ifdef PROJECT_X86
+    if (use_simd && project_simd_supported ())
+        i = project_float_avx2 (x, y, z, proj_x, proj_y, depth, count,
+            distance, focal, cx, cy, sh, ch, sp, cp);
+#endif
+    for (; i < count; i++)
+    {
+        float x1, z1, y2, scale;
+
+        x1 = x[i] * ch + z[i] * sh;
+        z1 = z[i] * ch - x[i] * sh;
+        y2 = y[i] * cp - z1 * sp;
+        depth[i] = (y[i] * sp + z1 * cp) + distance;
+
+        if (depth[i] < fixtof (PROJECT_NEAR))
+        {
+            proj_x[i] = proj_y[i] = 0;
+            continue;
+        }
+        scale = focal / depth[i];
+        proj_x[i] = x1 * scale + cx;
+        proj_y[i] = y2 * scale + cy;
+    }
+}
+
+int project_simd_supported ()
+{
+#ifdef PROJECT_X86
+    return __builtin_cpu_supports ("avx2");
+#else
+    return FALSE;
+#endif
+}
+
+void set_project_simd (int enable)
+{
+    use_simd = enable;
+}
@@ -0,0 +1,69 @@
+/*
+   PROJECT.H
+   written by Martijn van Iersel (Amarillion)
+
+   CIRCLE 10 rotates four dots, and calls fsin() and fcos() again for
+   each of them. A star field or a particle system rotates thousands
+   of points by the same angle. rotate_points() and project_points()
+   do a whole array of points at once: the sine and cosine are looked
+   up only once, and with AVX2 8 points are done at a time. The x, y
+   and z coordinates are kept in separate arrays (not in an array of
+   structs), so that they can be loaded 8 at a time.
+
+   Each function has a fixed and a float version. Like in real.h, the
+   parameters stay fixed in both. The AVX2 versions give exactly the
+   same results as the C versions.
+*/
+
+#ifndef PROJECT_H
+#define PROJECT_H
+
+#include <allegro.h>
+
+/* rotate_points() rotates count points around (0, 0) by angle and
+   then moves them to (cx, cy), the same way as CIRCLE 10:
+
+   proj_x[i] = fmul (x[i], fcos (angle)) - fmul (y[i], fsin (angle)) + cx;
+   proj_y[i] = fmul (x[i], fsin (angle)) + fmul (y[i], fcos (angle)) + cy; */
+void rotate_points (const fixed *x, const fixed *y,
+    fixed *proj_x, fixed *proj_y, int count,
+    fixed angle, fixed cx, fixed cy);
+void rotate_points_float (const float *x, const float *y,
+    float *proj_x, float *proj_y, int count,
+    fixed angle, fixed cx, fixed cy);
+
+/* The view for project_points(). The points are first turned around
+   the y axis by heading, then around the x axis by pitch. Then they
+   are moved distance away from the viewer and projected onto the
+   screen, with (cx, cy) in the middle. Something at depth focal has
+   the same size on the screen as in space, twice as far away it is
+   half as big. */
+typedef struct PROJECT_PARAMS
+{
+    fixed heading, pitch;
+    fixed distance;
+    fixed focal;
+    fixed cx, cy;
+} PROJECT_PARAMS;
+
+// points with a smaller depth are behind the viewer, or too close
+#define PROJECT_NEAR itofix (1)
+
+/* project_points() rotates and projects count points in 3D, as
+   described above. depth[i] is the distance from the viewer, which
+   can be used to sort the points or to make far stars darker. Points
+   with depth[i] < PROJECT_NEAR should not be drawn, their proj_x[i]
+   and proj_y[i] are 0. */
+void project_points (const fixed *x, const fixed *y, const fixed *z,
+    fixed *proj_x, fixed *proj_y, fixed *depth, int count,
+    PROJECT_PARAMS params);
+void project_points_float (const float *x, const float *y, const float *z,
+    float *proj_x, float *proj_y, float *depth, int count,
+    PROJECT_PARAMS params);
+
+/* Returns TRUE if AVX2 can be used on this processor.
+   set_project_simd (FALSE) turns it off, to compare both. */
+int project_simd_supported ();
+void set_project_simd (int enable);
+
+#endif
@@ -0,0 +1,193 @@
+/*
+    PROJECTION BENCHMARK
+    Written by Amarillion (amarillion@yahoo.com)
+
+    This program rotates a million points per frame, the way CIRCLE 10
+    rotates its four dots, and with rotate_points() and
+    project_points() (see project.h), in C and with AVX2, with fixed
+    and with float numbers. It doesn't need a screen, the results are
+    printed as text:
+
+    operation,method,points,mpoints_per_sec,ms_per_frame,differences
+
+    differences is the number of points that came out different from
+    the C version of the same kind, which should be 0.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <allegro.h>
+#include "project.h"
+#include "../common/walltime.h"
+
+#define POINTS 1000000
+#define FRAMES 20
+
+fixed x[POINTS], y[POINTS], z[POINTS];
+float xf[POINTS], yf[POINTS], zf[POINTS];
+fixed proj_x[POINTS], proj_y[POINTS], depth[POINTS];
+fixed ref_x[POINTS], ref_y[POINTS], ref_depth[POINTS];
+float proj_xf[POINTS], proj_yf[POINTS], depthf[POINTS];
+float ref_xf[POINTS], ref_yf[POINTS], ref_depthf[POINTS];
+
+// the loop of CIRCLE 10, with fsin and fcos for every point
+void rotate_per_point (fixed angle, fixed cx, fixed cy)
+{
+    int i;
+    for (i = 0; i < POINTS; i++)
+    {
+        proj_x[i] = fmul (x[i], fcos (angle)) -
+            fmul (y[i], fsin (angle)) + cx;
+        proj_y[i] = fmul (x[i], fsin (angle)) +
+            fmul (y[i], fcos (angle)) + cy;
+    }
+}
+
+PROJECT_PARAMS view (int frame)
+{
+    PROJECT_PARAMS params = { 0, 0, itofix (300), itofix (200),
+        itofix (960), itofix (540) };
+    params.heading = itofix (frame * 3);
+    params.pitch = itofix (frame);
+    return params;
+}
+
+void print_result (const char *operation, const char *method,
+    double seconds, int differences)
+{
+    printf ("%s,%s,%d,%.1f,%.3f,%d\n", operation, method, POINTS,
+        POINTS * (double)FRAMES / seconds / 1e6, seconds * 1000.0 / FRAMES,
+        differences);
+}
+
+int count_differences (const void *a, const void *b, size_t size)
+{
+    const char *p = a, *q = b;
+    int i, n = 0;
+    for (i = 0; i < POINTS; i++)
+        if (memcmp (p + i * size, q + i * size, size) != 0) n++;
+    return n;
+}
+
+int main ()
+{
+    double start;
+    int i, frame, differences;
+    int simd = project_simd_supported ();
+
+    // we don't draw anything, so we don't need a graphics mode
+    if (allegro_init () < 0)
+    {
+        allegro_message ("Error: Could not initialize Allegro");
+        return -1;
+    }
+
+    // a cloud of stars around (0, 0, 0)
+    srand (1);
+    for (i = 0; i < POINTS; i++)
+    {
+        x[i] = itofix (rand () % 400 - 200) + (rand () & 0xFFFF);
+        y[i] = itofix (rand () % 400 - 200) + (rand () & 0xFFFF);
+        z[i] = itofix (rand () % 400 - 200) + (rand () & 0xFFFF);
+        xf[i] = fixtof (x[i]);
+        yf[i] = fixtof (y[i]);
+        zf[i] = fixtof (z[i]);
+    }
+
+    printf ("operation,method,points,mpoints_per_sec,ms_per_frame,differences\n");
+
+    // the result of the last frame is compared with the C version
+    start = wall_time ();
+    for (frame = 0; frame < FRAMES; frame++)
+        rotate_per_point (itofix (frame), itofix (960), itofix (540));
+    print_result ("rotate_2d", "fsin_per_point", wall_time () - start, 0);
+    memcpy (ref_x, proj_x, sizeof (proj_x));
+    memcpy (ref_y, proj_y, sizeof (proj_y));
+
+    set_project_simd (FALSE);
+    start = wall_time ();
+    for (frame = 0; frame < FRAMES; frame++)
+        rotate_points (x, y, proj_x, proj_y, POINTS, itofix (frame),
+            itofix (960), itofix (540));
+    print_result ("rotate_2d", "fixed_c", wall_time () - start,
+        count_differences (proj_x, ref_x, sizeof (fixed)) +
+        count_differences (proj_y, ref_y, sizeof (fixed)));
+
+    if (simd)
+    {
+        set_project_simd (TRUE);
+        start = wall_time ();
+        for (frame = 0; frame < FRAMES; frame++)
+            rotate_points (x, y, proj_x, proj_y, POINTS, itofix (frame),
+                itofix (960), itofix (540));
+        print_result ("rotate_2d", "fixed_avx2", wall_time () - start,
+            count_differences (proj_x, ref_x, sizeof (fixed)) +
+            count_differences (proj_y, ref_y, sizeof (fixed)));
+    }
+
+    set_project_simd (FALSE);
+    start = wall_time ();
+    for (frame = 0; frame < FRAMES; frame++)
+        rotate_points_float (xf, yf, ref_xf, ref_yf, POINTS, itofix (frame),
+            itofix (960), itofix (540));
+    print_result ("rotate_2d", "float_c", wall_time () - start, 0);
+
+    if (simd)
+    {
+        set_project_simd (TRUE);
+        start = wall_time ();
+        for (frame = 0; frame < FRAMES; frame++)
+            rotate_points_float (xf, yf, proj_xf, proj_yf, POINTS,
+                itofix (frame), itofix (960), itofix (540));
+        print_result ("rotate_2d", "float_avx2", wall_time () - start,
+            count_differences (proj_xf, ref_xf, sizeof (float)) +
+            count_differences (proj_yf, ref_yf, sizeof (float)));
+    }
+
+    set_project_simd (FALSE);
+    start = wall_time ();
+    for (frame = 0; frame < FRAMES; frame++)
+        project_points (x, y, z, ref_x, ref_y, ref_depth, POINTS,
+            view (frame));
+    print_result ("project_3d", "fixed_c", wall_time () - start, 0);
+
+    if (simd)
+    {
+        set_project_simd (TRUE);
+        start = wall_time ();
+        for (frame = 0; frame < FRAMES; frame++)
+            project_points (x, y, z, proj_x, proj_y, depth, POINTS,
+                view (frame));
+        differences = count_differences (proj_x, ref_x, sizeof (fixed)) +
+            count_differences (proj_y, ref_y, sizeof (fixed)) +
+            count_differences (depth, ref_depth, sizeof (fixed));
+        print_result ("project_3d", "fixed_avx2", wall_time () - start,
+            differences);
+    }
+
+    set_project_simd (FALSE);
+    start = wall_time ();
+    for (frame = 0; frame < FRAMES; frame++)
+        project_points_float (xf, yf, zf, ref_xf, ref_yf, ref_depthf, POINTS,
+            view (frame));
+    print_result ("project_3d", "float_c", wall_time () - start, 0);
+
+    if (simd)
+    {
+        set_project_simd (TRUE);
+        start = wall_time ();
+        for (frame = 0; frame < FRAMES; frame++)
+            project_points_float (xf, yf, zf, proj_xf, proj_yf, depthf,
+                POINTS, view (frame));
+        differences = count_differences (proj_xf, ref_xf, sizeof (float)) +
+            count_differences (proj_yf, ref_yf, sizeof (float)) +
+            count_differences (depthf, ref_depthf, sizeof (float));
+        print_result ("project_3d", "float_avx2", wall_time () - start,
+            differences);
+    }
+
+    allegro_exit ();
+    return 0;
+
+} END_OF_MAIN ();
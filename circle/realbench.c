@@ -0,0 +1,108 @@
+/*
+    FIXED, FLOAT OR DOUBLE BENCHMARK
+    Written by Amarillion (amarillion@yahoo.com)
+
+    This program measures the fixed, float and double versions of
+    draw_circle, my_rotate_sprite and mode_7 (see circreal.c) like
+    circbench does. Then it compares the pictures they draw with those
+    of the double versions, to show how much accuracy fixed and float
+    numbers lose. See ../common/bench.h for the command line options.
+*/
+
+#include <stdio.h>
+#include <allegro.h>
+#include "../common/bench.h"
+
+// we only need MODE_7_PARAMS from circ12.c
+#define KERNELS_ONLY
+#include "circ12.c"
+
+// one version of circreal.c for each kind of number
+#include "circreal.c"
+#define REAL_FLOAT
+#include "circreal.c"
+#undef REAL_FLOAT
+#define REAL_DOUBLE
+#include "circreal.c"
+#undef REAL_DOUBLE
+
+MODE_7_PARAMS mode_7_params;
+
+/*
+   BENCH_REAL_KERNELS() writes the bench kernels for one kind of number.
+   Circles of every radius, in steps small enough for the largest one
+   to be closed.
+*/
+#define BENCH_REAL_KERNELS(kind) \
+void bench_draw_circle_##kind (BITMAP *bmp, int frame, void *data) \
+{ \
+    int r, max_r = (bmp->w < bmp->h ? bmp->w : bmp->h) / 2 - 1; \
+    for (r = 1; r <= max_r; r++) \
+        draw_circle_##kind (bmp, bmp->w / 2, bmp->h / 2, r, \
+            itofix (32) / max_r, makecol (255, 255, 255)); \
+} \
+void bench_my_rotate_sprite_##kind (BITMAP *bmp, int frame, void *data) \
+{ \
+    my_rotate_sprite_##kind (bmp, data, itofix (frame + 10), ftofix (0.7)); \
+} \
+void bench_mode_7_##kind (BITMAP *bmp, int frame, void *data) \
+{ \
+    mode_7_##kind (bmp, data, itofix (frame + 10), itofix (100), \
+        itofix (100), mode_7_params); \
+}
+
+BENCH_REAL_KERNELS (fixed)
+BENCH_REAL_KERNELS (float)
+BENCH_REAL_KERNELS (double)
+
+int main (int argc, char *argv[])
+{
+    BITMAP *tile;
+    int x, y;
+
+    if (bench_init (argc, argv) != 0)
+    {
+        allegro_message ("Error: Could not initialize the benchmark");
+        return -1;
+    }
+
+    // the same tile and parameters as in circbench
+    tile = create_bitmap (256, 256);
+    for (y = 0; y < tile->h; y++)
+        for (x = 0; x < tile->w; x++)
+            putpixel (tile, x, y, makecol (x, y, x ^ y));
+    mode_7_params.space_z = itofix (50);
+    mode_7_params.scale_x = ftofix (200.0);
+    mode_7_params.scale_y = ftofix (200.0);
+    mode_7_params.obj_scale_x = ftofix (50.0);
+    mode_7_params.obj_scale_y = ftofix (50.0);
+    mode_7_params.horizon = 20;
+
+    bench_kernel ("draw_circle_fixed", bench_draw_circle_fixed, NULL);
+    bench_kernel ("draw_circle_float", bench_draw_circle_float, NULL);
+    bench_kernel ("draw_circle_double", bench_draw_circle_double, NULL);
+    bench_kernel ("my_rotate_sprite_fixed", bench_my_rotate_sprite_fixed, tile);
+    bench_kernel ("my_rotate_sprite_float", bench_my_rotate_sprite_float, tile);
+    bench_kernel ("my_rotate_sprite_double", bench_my_rotate_sprite_double, tile);
+    bench_kernel ("mode_7_fixed", bench_mode_7_fixed, tile);
+    bench_kernel ("mode_7_float", bench_mode_7_float, tile);
+    bench_kernel ("mode_7_double", bench_mode_7_double, tile);
+
+    bench_accuracy ("draw_circle_fixed", bench_draw_circle_fixed,
+        "draw_circle_double", bench_draw_circle_double, NULL);
+    bench_accuracy ("draw_circle_float", bench_draw_circle_float,
+        "draw_circle_double", bench_draw_circle_double, NULL);
+    bench_accuracy ("my_rotate_sprite_fixed", bench_my_rotate_sprite_fixed,
+        "my_rotate_sprite_double", bench_my_rotate_sprite_double, tile);
+    bench_accuracy ("my_rotate_sprite_float", bench_my_rotate_sprite_float,
+        "my_rotate_sprite_double", bench_my_rotate_sprite_double, tile);
+    bench_accuracy ("mode_7_fixed", bench_mode_7_fixed,
+        "mode_7_double", bench_mode_7_double, tile);
+    bench_accuracy ("mode_7_float", bench_mode_7_float,
+        "mode_7_double", bench_mode_7_double, tile);
+
+    destroy_bitmap (tile);
+    bench_exit ();
+    return 0;
+
+} END_OF_MAIN ();
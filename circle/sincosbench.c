@@ -0,0 +1,157 @@
+/*
+    SINCOS BENCHMARK
+    Written by Amarillion (amarillion@yahoo.com)
+
+    This program compares fsincos (see ../common/sincos.h) with fsin
+    and fcos and with the sinf and cosf of the C library. For each
+    table size, with and without interpolation, it measures how many
+    angles per second it can do and how far the results are off. It
+    doesn't need a screen, the results are printed as text:
+
+    method,table_size,interpolate,mangles_per_sec,max_error
+
+    max_error is the largest difference with the exact sine or cosine
+    over all angles in a circle, in units of 1/65536 (one step of a
+    fixed).
+*/
+
+#include <stdio.h>
+#include <math.h>
+#include <allegro.h>
+#include "../common/sincos.h"
+#include "../common/walltime.h"
+
+#define NUM_ANGLES (1 << 20)
+#define RUNS 20
+
+// all angles in a circle, 1 << 24 in fixed
+#define FULL_CIRCLE (1 << 24)
+
+enum { FSIN_FCOS, SINF_COSF, FSINCOS, FSINCOS_BATCH_C, FSINCOS_BATCH_AVX2 };
+
+const char *method_names[] = { "fsin_fcos", "sinf_cosf", "fsincos",
+    "fsincos_batch_c", "fsincos_batch_avx2" };
+
+fixed angles[NUM_ANGLES], s[NUM_ANGLES], c[NUM_ANGLES];
+
+// sine and cosine of angles[0 .. count-1] with one of the methods
+void run_method (int method, const fixed *a, int count)
+{
+    int i;
+    switch (method)
+    {
+        case FSIN_FCOS:
+            for (i = 0; i < count; i++)
+            {
+                s[i] = fsin (a[i]);
+                c[i] = fcos (a[i]);
+            }
+            break;
+        case SINF_COSF:
+            for (i = 0; i < count; i++)
+            {
+                float rad = a[i] * (float)(AL_PI / (128 << 16));
+                s[i] = (fixed)(sinf (rad) * 65536.0f);
+                c[i] = (fixed)(cosf (rad) * 65536.0f);
+            }
+            break;
+        case FSINCOS:
+            for (i = 0; i < count; i++)
+                fsincos (a[i], &s[i], &c[i]);
+            break;
+        case FSINCOS_BATCH_C:
+        case FSINCOS_BATCH_AVX2:
+            set_sincos_simd (method == FSINCOS_BATCH_AVX2);
+            fsincos_batch (a, s, c, count);
+            set_sincos_simd (TRUE);
+            break;
+    }
+}
+
+// returns millions of angles per second
+double measure_speed (int method)
+{
+    double start, seconds;
+    int i;
+
+    run_method (method, angles, NUM_ANGLES); // warm up
+    start = wall_time ();
+    for (i = 0; i < RUNS; i++)
+        run_method (method, angles, NUM_ANGLES);
+    seconds = wall_time () - start;
+    return (double)RUNS * NUM_ANGLES / seconds / 1e6;
+}
+
+// returns the largest error over all angles in a circle
+double measure_error (int method)
+{
+    fixed chunk[4096];
+    double max_error = 0;
+    int start, i;
+
+    for (start = 0; start < FULL_CIRCLE; start += 4096)
+    {
+        for (i = 0; i < 4096; i++) chunk[i] = start + i;
+        run_method (method, chunk, 4096);
+        for (i = 0; i < 4096; i++)
+        {
+            double rad = (start + i) * (AL_PI / (128 << 16));
+            double es = fabs (s[i] - sin (rad) * 65536.0);
+            double ec = fabs (c[i] - cos (rad) * 65536.0);
+            if (es > max_error) max_error = es;
+            if (ec > max_error) max_error = ec;
+        }
+    }
+    return max_error;
+}
+
+void print_result (int method, const char *table_size, int interpolate)
+{
+    printf ("%s,%s,%d,%.1f,%.2f\n", method_names[method], table_size,
+        interpolate, measure_speed (method), measure_error (method));
+}
+
+int main ()
+{
+    int sizes[] = {256, 1024, 4096, 65536};
+    int i, interpolate, method;
+    char size_name[16];
+    unsigned int angle = 12345;
+
+    // we don't draw anything, so we don't need a graphics mode
+    if (allegro_init () < 0)
+    {
+        allegro_message ("Error: Could not initialize Allegro");
+        return -1;
+    }
+
+    // angles all over the circle, in no particular order, the way a
+    // game with lots of objects would ask for them
+    for (i = 0; i < NUM_ANGLES; i++)
+    {
+        angle = angle * 1103515245 + 12345;
+        angles[i] = (fixed)(angle >> 8);
+    }
+
+    printf ("method,table_size,interpolate,mangles_per_sec,max_error\n");
+    print_result (FSIN_FCOS, "-", 0);
+    print_result (SINF_COSF, "-", 0);
+    for (i = 0; i < 4; i++)
+    {
+        for (interpolate = 0; interpolate <= 1; interpolate++)
+        {
+            set_sincos_table (sizes[i], interpolate);
+            sprintf (size_name, "%d", sizes[i]);
+            for (method = FSINCOS; method <= FSINCOS_BATCH_AVX2; method++)
+            {
+                if (method == FSINCOS_BATCH_AVX2 && !sincos_simd_supported ())
+                    continue;
+                print_result (method, size_name, interpolate);
+            }
+        }
+    }
+
+    allegro_exit ();
+    return 0;
+
+} END_OF_MAIN ();
@@ -0,0 +1,409 @@
+/*
+   SPAN.C
+   written by Martijn van Iersel (Amarillion)
+
+   See span.h
+*/
+
+#include <string.h>
+#include <allegro.h>
+#include "span.h"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define SPAN_X86
+#include <immintrin.h>
+#endif
+
+// the instruction set chosen with set_span_isa, or -1 for the best one
+static int span_isa = -1;
+
+int span_isa_supported (int isa)
+{
+    switch (isa)
+    {
+        case SPAN_SCALAR: return TRUE;
+#ifdef SPAN_X86
+        case SPAN_SSE2: return __builtin_cpu_supports ("sse2");
+        case SPAN_AVX2: return __builtin_cpu_supports ("avx2");
+        case SPAN_AVX512: return __builtin_cpu_supports ("avx512f");
+#endif
+    }
+    return FALSE;
+}
+
+void set_span_isa (int isa)
+{
+    span_isa = isa;
+}
+
+int get_span_isa ()
+{
+    int isa;
+    if (span_isa >= 0 && span_isa_supported (span_isa))
+        return span_isa;
+    for (isa = SPAN_NUM_ISA - 1; isa > SPAN_SCALAR; isa--)
+        if (span_isa_supported (isa)) return isa;
+    return SPAN_SCALAR;
+}
+
+const char *span_isa_name (int isa)
+{
+    switch (isa)
+    {
+        case SPAN_SCALAR: return "scalar";
+        case SPAN_SSE2: return "sse2";
+        case SPAN_AVX2: return "avx2";
+        case SPAN_AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+/*
+    span_scalar() is the plain version: one pixel at a time, with a
+    separate loop for each color depth. It is also used for the pixels
+    that are left over at the end of a line by the SIMD versions.
+*/
+static void span_scalar (BITMAP *dest, int x, int y, int count,
+    BITMAP *tile, fixed u, fixed v, fixed du, fixed dv)
+{
+    int mask_x = tile->w - 1;
+    int mask_y = tile->h - 1;
+    int i;
+
+    switch (bitmap_color_depth (dest))
+    {
+        case 8:
+        {
+            unsigned char *d = dest->line[y] + x;
+            for (i = 0; i < count; i++)
+            {
+                d[i] = tile->line[fixtoi (v) & mask_y][fixtoi (u) & mask_x];
+                u += du;
+                v += dv;
+            }
+            break;
+        }
+        case 15:
+        case 16:
+        {
+            uint16_t *d = (uint16_t *)dest->line[y] + x;
+            for (i = 0; i < count; i++)
+            {
+                d[i] = ((uint16_t *)tile->line
+                    [fixtoi (v) & mask_y])[fixtoi (u) & mask_x];
+                u += du;
+                v += dv;
+            }
+            break;
+        }
+        case 24:
+        {
+            // 24 bit pixels are 3 bytes, there is no type for that
+            unsigned char *d = dest->line[y] + x * 3;
+            unsigned char *s;
+            for (i = 0; i < count; i++)
+            {
+                s = tile->line[fixtoi (v) & mask_y] + (fixtoi (u) & mask_x) * 3;
+                d[0] = s[0];
+                d[1] = s[1];
+                d[2] = s[2];
+                d += 3;
+                u += du;
+                v += dv;
+            }
+            break;
+        }
+        case 32:
+        {
+            uint32_t *d = (uint32_t *)dest->line[y] + x;
+            for (i = 0; i < count; i++)
+            {
+                d[i] = ((uint32_t *)tile->line
+                    [fixtoi (v) & mask_y])[fixtoi (u) & mask_x];
+                u += du;
+                v += dv;
+            }
+            break;
+        }
+    }
+}
+
+#ifdef SPAN_X86
+
+/*
+    The SIMD versions below all work the same way. Each lane of a vector
+    holds the u and v of one pixel. fixtoi (u) is the same as
+    (u + 0x8000) >> 16, and after masking we turn tile x and y into a
+    byte offset from the start of the tile:
+    y * pitch + x * bytes_per_pixel.
+    They return the number of pixels they have done, the rest is left
+    to span_scalar.
+
+    There is no byte or word gather instruction, so for 8 and 16 bit
+    tiles we gather the aligned 32 bit word that contains the pixel
+    and shift the pixel out of it. An aligned read can't cross a page
+    boundary, so this never reads memory we don't have access to.
+*/
+
+// the first lane is (u, v), the next ones are one step further each
+#define LANE(start, step, i) ((int)((unsigned)(start) + (unsigned)(i) * (unsigned)(step)))
+
+__attribute__((target("sse2")))
+static int span_sse2 (unsigned char *d, int bpp, int count,
+    unsigned char *base, int pitch, int mask_x, int mask_y,
+    fixed u, fixed v, fixed du, fixed dv)
+{
+    __m128i vu = _mm_setr_epi32 (u, LANE (u, du, 1), LANE (u, du, 2), LANE (u, du, 3));
+    __m128i vv = _mm_setr_epi32 (v, LANE (v, dv, 1), LANE (v, dv, 2), LANE (v, dv, 3));
+    __m128i step_u = _mm_set1_epi32 (LANE (0, du, 4));
+    __m128i step_v = _mm_set1_epi32 (LANE (0, dv, 4));
+    __m128i half = _mm_set1_epi32 (0x8000);
+    __m128i vmask_x = _mm_set1_epi32 (mask_x);
+    __m128i vmask_y = _mm_set1_epi32 (mask_y);
+    // SSE2 has no 32 bit multiply, but x and y both fit in 16 bits,
+    // so a single madd calculates x * bpp + y * pitch
+    __m128i scale = _mm_set1_epi32 (bpp | (pitch << 16));
+    int offset[4];
+    int i, j;
+
+    for (i = 0; i + 4 <= count; i += 4)
+    {
+        __m128i tx = _mm_and_si128 (_mm_srai_epi32 (_mm_add_epi32 (vu, half), 16), vmask_x);
+        __m128i ty = _mm_and_si128 (_mm_srai_epi32 (_mm_add_epi32 (vv, half), 16), vmask_y);
+        __m128i off = _mm_madd_epi16 (_mm_or_si128 (tx, _mm_slli_epi32 (ty, 16)), scale);
+        _mm_storeu_si128 ((__m128i *)offset, off);
+
+        switch (bpp)
+        {
+            case 1:
+                for (j = 0; j < 4; j++)
+                    d[i + j] = base[offset[j]];
+                break;
+            case 2:
+                for (j = 0; j < 4; j++)
+                    ((uint16_t *)d)[i + j] = *(uint16_t *)(base + offset[j]);
+                break;
+            case 4:
+                for (j = 0; j < 4; j++)
+                    ((uint32_t *)d)[i + j] = *(uint32_t *)(base + offset[j]);
+                break;
+        }
+        vu = _mm_add_epi32 (vu, step_u);
+        vv = _mm_add_epi32 (vv, step_v);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static int span_avx2 (unsigned char *d, int bpp, int count,
+    unsigned char *base, int pitch, int mask_x, int mask_y,
+    fixed u, fixed v, fixed du, fixed dv)
+{
+    __m256i vu = _mm256_setr_epi32 (u, LANE (u, du, 1), LANE (u, du, 2), LANE (u, du, 3),
+        LANE (u, du, 4), LANE (u, du, 5), LANE (u, du, 6), LANE (u, du, 7));
+    __m256i vv = _mm256_setr_epi32 (v, LANE (v, dv, 1), LANE (v, dv, 2), LANE (v, dv, 3),
+        LANE (v, dv, 4), LANE (v, dv, 5), LANE (v, dv, 6), LANE (v, dv, 7));
+    __m256i step_u = _mm256_set1_epi32 (LANE (0, du, 8));
+    __m256i step_v = _mm256_set1_epi32 (LANE (0, dv, 8));
+    __m256i half = _mm256_set1_epi32 (0x8000);
+    __m256i vmask_x = _mm256_set1_epi32 (mask_x);
+    __m256i vmask_y = _mm256_set1_epi32 (mask_y);
+    __m256i scale = _mm256_set1_epi32 (bpp | (pitch << 16));
+    // for 8 and 16 bit tiles: the aligned start of the tile,
+    // and the mask for a single pixel
+    unsigned char *aligned = (unsigned char *)((uintptr_t)base & ~(uintptr_t)3);
+    __m256i misalign = _mm256_set1_epi32 (base - aligned);
+    __m256i three = _mm256_set1_epi32 (3);
+    __m256i pixel_mask = _mm256_set1_epi32 (bpp == 1 ? 0xFF : 0xFFFF);
+    int i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        __m256i tx = _mm256_and_si256 (_mm256_srai_epi32 (_mm256_add_epi32 (vu, half), 16), vmask_x);
+        __m256i ty = _mm256_and_si256 (_mm256_srai_epi32 (_mm256_add_epi32 (vv, half), 16), vmask_y);
+        __m256i off = _mm256_madd_epi16 (_mm256_or_si256 (tx, _mm256_slli_epi32 (ty, 16)), scale);
+        __m256i pixels, packed;
+
+        if (bpp == 4)
+        {
+            pixels = _mm256_i32gather_epi32 ((const int *)base, off, 1);
+            _mm256_storeu_si256 ((__m256i *)(d + i * 4), pixels);
+        }
+        else
+        {
+            off = _mm256_add_epi32 (off, misalign);
+            pixels = _mm256_i32gather_epi32 ((const int *)aligned,
+                _mm256_andnot_si256 (three, off), 1);
+            pixels = _mm256_srlv_epi32 (pixels,
+                _mm256_slli_epi32 (_mm256_and_si256 (off, three), 3));
+            pixels = _mm256_and_si256 (pixels, pixel_mask);
+            // packing works on each 128 bit half separately, so each half
+            // ends up with 4 of the pixels in its lowest bytes
+            packed = _mm256_packus_epi32 (pixels, pixels);
+            if (bpp == 2)
+            {
+                _mm_storel_epi64 ((__m128i *)(d + i * 2),
+                    _mm256_castsi256_si128 (packed));
+                _mm_storel_epi64 ((__m128i *)(d + i * 2 + 8),
+                    _mm256_extracti128_si256 (packed, 1));
+            }
+            else
+            {
+                int four_pixels;
+                packed = _mm256_packus_epi16 (packed, packed);
+                four_pixels = _mm_cvtsi128_si32 (_mm256_castsi256_si128 (packed));
+                memcpy (d + i, &four_pixels, 4);
+                four_pixels = _mm_cvtsi128_si32 (_mm256_extracti128_si256 (packed, 1));
+                memcpy (d + i + 4, &four_pixels, 4);
+            }
+        }
+        vu = _mm256_add_epi32 (vu, step_u);
+        vv = _mm256_add_epi32 (vv, step_v);
+    }
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static int span_avx512 (unsigned char *d, int bpp, int count,
+    unsigned char *base, int pitch, int mask_x, int mask_y,
+    fixed u, fixed v, fixed du, fixed dv)
+{
+    __m512i lanes = _mm512_setr_epi32 (0, 1, 2, 3, 4, 5, 6, 7,
+        8, 9, 10, 11, 12, 13, 14, 15);
+    __m512i vu = _mm512_add_epi32 (_mm512_set1_epi32 (u),
+        _mm512_mullo_epi32 (lanes, _mm512_set1_epi32 (du)));
+    __m512i vv = _mm512_add_epi32 (_mm512_set1_epi32 (v),
+        _mm512_mullo_epi32 (lanes, _mm512_set1_epi32 (dv)));
+    __m512i step_u = _mm512_set1_epi32 (LANE (0, du, 16));
+    __m512i step_v = _mm512_set1_epi32 (LANE (0, dv, 16));
+    __m512i half = _mm512_set1_epi32 (0x8000);
+    __m512i vmask_x = _mm512_set1_epi32 (mask_x);
+    __m512i vmask_y = _mm512_set1_epi32 (mask_y);
+    __m512i vbpp = _mm512_set1_epi32 (bpp);
+    __m512i vpitch = _mm512_set1_epi32 (pitch);
+    unsigned char *aligned = (unsigned char *)((uintptr_t)base & ~(uintptr_t)3);
+    __m512i misalign = _mm512_set1_epi32 (base - aligned);
+    __m512i three = _mm512_set1_epi32 (3);
+    int i;
+
+    for (i = 0; i + 16 <= count; i += 16)
+    {
+        __m512i tx = _mm512_and_si512 (_mm512_srai_epi32 (_mm512_add_epi32 (vu, half), 16), vmask_x);
+        __m512i ty = _mm512_and_si512 (_mm512_srai_epi32 (_mm512_add_epi32 (vv, half), 16), vmask_y);
+        __m512i off = _mm512_add_epi32 (_mm512_mullo_epi32 (tx, vbpp),
+            _mm512_mullo_epi32 (ty, vpitch));
+        __m512i pixels;
+
+        if (bpp == 4)
+        {
+            pixels = _mm512_i32gather_epi32 (off, base, 1);
+            _mm512_storeu_si512 (d + i * 4, pixels);
+        }
+        else
+        {
+            off = _mm512_add_epi32 (off, misalign);
+            pixels = _mm512_i32gather_epi32 (_mm512_andnot_si512 (three, off),
+                aligned, 1);
+            pixels = _mm512_srlv_epi32 (pixels,
+                _mm512_slli_epi32 (_mm512_and_si512 (off, three), 3));
+            // the conversions keep only the lowest bits, so we don't
+            // have to mask the pixels first
+            if (bpp == 2)
+                _mm256_storeu_si256 ((__m256i *)(d + i * 2),
+                    _mm512_cvtepi32_epi16 (pixels));
+            else
+                _mm_storeu_si128 ((__m128i *)(d + i),
+                    _mm512_cvtepi32_epi8 (pixels));
+        }
+        vu = _mm512_add_epi32 (vu, step_u);
+        vv = _mm512_add_epi32 (vv, step_v);
+    }
+    return i;
+}
+
+#endif
+
+void affine_span (BITMAP *dest, int x, int y, int count,
+    BITMAP *tile, fixed u, fixed v, fixed du, fixed dv)
+{
+    int depth = bitmap_color_depth (dest);
+    int i;
+
+    // putpixel doesn't draw outside the clipping rectangle,
+    // so neither do we
+    if (dest->clip)
+    {
+        if (y < dest->ct || y >= dest->cb) return;
+        if (x < dest->cl)
+        {
+            i = dest->cl - x;
+            u += i * du;
+            v += i * dv;
+            count -= i;
+            x = dest->cl;
+        }
+        if (x + count > dest->cr) count = dest->cr - x;
+    }
+    if (count <= 0) return;
+
+    // direct access to line[] only works on memory bitmaps
+    // of the same color depth
+    if (!is_memory_bitmap (dest) || !is_memory_bitmap (tile) ||
+        depth != bitmap_color_depth (tile))
+    {
+        for (i = 0; i < count; i++)
+        {
+            putpixel (dest, x + i, y,
+                getpixel (tile, fixtoi (u) & (tile->w - 1),
+                    fixtoi (v) & (tile->h - 1)));
+            u += du;
+            v += dv;
+        }
+        return;
+    }
+
+#ifdef SPAN_X86
+    {
+        int bpp = (depth + 7) / 8;
+        unsigned char *base = tile->line[0];
+        int pitch = tile->h > 1 ? tile->line[1] - tile->line[0] : 0;
+        int isa = get_span_isa ();
+        int done = 0;
+
+        // The SIMD versions need tile x, y and pitch to fit in 16 bits,
+        // and the lines of the tile to be evenly spaced.
+        // There is no SIMD version for 24 bit pixels.
+        if (isa != SPAN_SCALAR && bpp != 3 &&
+            tile->w <= 0x8000 && tile->h <= 0x8000 &&
+            pitch >= 0 && pitch < 0x8000 &&
+            ((uintptr_t)base & (bpp - 1)) == 0 &&
+            tile->line[tile->h - 1] == base + (tile->h - 1) * pitch)
+        {
+            unsigned char *d = dest->line[y] + x * bpp;
+            int mask_x = tile->w - 1;
+            int mask_y = tile->h - 1;
+            switch (isa)
+            {
+                case SPAN_SSE2:
+                    done = span_sse2 (d, bpp, count, base, pitch,
+                        mask_x, mask_y, u, v, du, dv);
+                    break;
+                case SPAN_AVX2:
+                    done = span_avx2 (d, bpp, count, base, pitch,
+                        mask_x, mask_y, u, v, du, dv);
+                    break;
+                case SPAN_AVX512:
+                    done = span_avx512 (d, bpp, count, base, pitch,
+                        mask_x, mask_y, u, v, du, dv);
+                    break;
+            }
+            u = LANE (u, du, done);
+            v = LANE (v, dv, done);
+            x += done;
+            count -= done;
+        }
+    }
+#endif
+
+    span_scalar (dest, x, y, count, tile, u, v, du, dv);
+}
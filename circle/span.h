@@ -0,0 +1,50 @@
+/*
+   SPAN.H
+   written by Martijn van Iersel (Amarillion)
+
+   The inner loops of my_rotate_sprite (CIRCLE 9) and mode_7
+   (CIRCLE 11 and 12) do exactly the same thing: they walk through
+   a tile with a constant step in x and y, and copy one pixel at a time
+   to a horizontal line on the screen. affine_span() is a fast version
+   of that loop that can use SSE2, AVX2 or AVX-512 to work on 4, 8 or
+   16 pixels at a time.
+*/
+
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <allegro.h>
+
+// the instruction sets affine_span can use
+#define SPAN_SCALAR 0
+#define SPAN_SSE2 1
+#define SPAN_AVX2 2
+#define SPAN_AVX512 3
+#define SPAN_NUM_ISA 4
+
+/* affine_span() draws count pixels on line y of dest, starting at x.
+   The first pixel comes from position (u, v) in the tile, and for each
+   next pixel u and v increase by du and dv. The width and height of the
+   tile must be powers of 2. The result is exactly the same as:
+
+   for (i = 0; i < count; i++)
+   {
+       putpixel (dest, x + i, y,
+           getpixel (tile, fixtoi (u) & (tile->w - 1),
+               fixtoi (v) & (tile->h - 1)));
+       u += du;
+       v += dv;
+   }
+*/
+void affine_span (BITMAP *dest, int x, int y, int count,
+    BITMAP *tile, fixed u, fixed v, fixed du, fixed dv);
+
+/* Normally affine_span uses the best instruction set the processor has.
+   set_span_isa() can be used to choose a different one, for example
+   to compare them. Passing -1 goes back to the best one. */
+int span_isa_supported (int isa);
+void set_span_isa (int isa);
+int get_span_isa ();
+const char *span_isa_name (int isa);
+
+#endif
@@ -0,0 +1,221 @@
+/*
+   SPATIAL.C
+   written by Martijn van Iersel (Amarillion)
+
+   See spatial.h
+*/
+
+#include <stdlib.h>
+#include <allegro.h>
+#include "spatial.h"
+
+SPATIAL_HASH *create_spatial_hash (int cell_size, int max_items)
+{
+    SPATIAL_HASH *hash = calloc (1, sizeof (SPATIAL_HASH));
+    int i;
+
+    if (!hash) return NULL;
+
+    hash->cell_shift = 16;
+    while ((1 << (hash->cell_shift - 16)) < cell_size) hash->cell_shift++;
+
+    // twice as many buckets as items, so that few cells share a bucket
+    hash->table_size = 64;
+    while (hash->table_size < 2 * max_items) hash->table_size *= 2;
+
+    hash->max_items = max_items;
+    hash->head = malloc (hash->table_size * sizeof (int));
+    hash->bucket = malloc (max_items * sizeof (int));
+    hash->next = malloc (max_items * sizeof (int));
+    hash->prev = malloc (max_items * sizeof (int));
+    if (!hash->head || !hash->bucket || !hash->next || !hash->prev)
+    {
+        destroy_spatial_hash (hash);
+        return NULL;
+    }
+    for (i = 0; i < hash->table_size; i++) hash->head[i] = -1;
+    return hash;
+}
+
+void destroy_spatial_hash (SPATIAL_HASH *hash)
+{
+    free (hash->head);
+    free (hash->bucket);
+    free (hash->next);
+    free (hash->prev);
+    free (hash);
+}
+
+// the bucket of cell (cx, cy)
+static int cell_bucket (const SPATIAL_HASH *hash, int cx, int cy)
+{
+    return ((unsigned int)cx * 73856093u ^ (unsigned int)cy * 19349663u) &
+        (hash->table_size - 1);
+}
+
+static int item_bucket (const SPATIAL_HASH *hash, int i)
+{
+    return cell_bucket (hash, hash->x[i] >> hash->cell_shift,
+        hash->y[i] >> hash->cell_shift);
+}
+
+static void link_item (SPATIAL_HASH *hash, int i, int b)
+{
+    hash->bucket[i] = b;
+    hash->prev[i] = -1;
+    hash->next[i] = hash->head[b];
+    if (hash->head[b] >= 0) hash->prev[hash->head[b]] = i;
+    hash->head[b] = i;
+}
+
+static void unlink_item (SPATIAL_HASH *hash, int i)
+{
+    if (hash->prev[i] >= 0)
+        hash->next[hash->prev[i]] = hash->next[i];
+    else
+        hash->head[hash->bucket[i]] = hash->next[i];
+    if (hash->next[i] >= 0)
+        hash->prev[hash->next[i]] = hash->prev[i];
+}
+
+int set_spatial_items (SPATIAL_HASH *hash, const fixed *x, const fixed *y,
+    int count)
+{
+    int i;
+
+    if (count > hash->max_items) return -1;
+
+    for (i = 0; i < hash->table_size; i++) hash->head[i] = -1;
+    hash->x = x;
+    hash->y = y;
+    hash->count = count;
+    // link the items in reverse, so that each bucket lists them in order
+    for (i = count - 1; i >= 0; i--)
+        link_item (hash, i, item_bucket (hash, i));
+    return 0;
+}
+
+int update_spatial_hash (SPATIAL_HASH *hash)
+{
+    int i, moved = 0;
+
+    for (i = 0; i < hash->count; i++)
+    {
+        int b = item_bucket (hash, i);
+        if (b == hash->bucket[i]) continue;
+        unlink_item (hash, i);
+        link_item (hash, i, b);
+        moved++;
+    }
+    return moved;
+}
+
+/*
+   The distance from (x, y) to item i. For SPATIAL_EUCLIDEAN it is the
+   square of the distance, which is enough to compare distances.
+   long long, because the square of a fixed doesn't fit in an int.
+*/
+static long long distance (const SPATIAL_HASH *hash, int i,
+    fixed x, fixed y, int metric)
+{
+    long long dx = (long long)hash->x[i] - x;
+    long long dy = (long long)hash->y[i] - y;
+
+    if (metric == SPATIAL_MANHATTAN)
+        return (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy);
+    return dx * dx + dy * dy;
+}
+
+// a distance in the units that distance() returns
+static long long metric_distance (fixed d, int metric)
+{
+    if (metric == SPATIAL_MANHATTAN) return d;
+    return (long long)d * d;
+}
+
+/*
+   Loops over the items i in cell (cx, cy). Several cells can share a
+   bucket, so the items of the other cells are skipped.
+*/
+#define FOR_ITEMS_IN_CELL(hash, cx, cy, i) \
+    for (i = (hash)->head[cell_bucket (hash, cx, cy)]; i >= 0; \
+         i = (hash)->next[i]) \
+        if (((hash)->x[i] >> (hash)->cell_shift) == (cx) && \
+            ((hash)->y[i] >> (hash)->cell_shift) == (cy))
+
+int query_spatial (const SPATIAL_HASH *hash, fixed x, fixed y, fixed radius,
+    int metric, int *found, int max_found)
+{
+    long long limit = metric_distance (radius, metric);
+    int cx1 = (x - radius) >> hash->cell_shift;
+    int cx2 = (x + radius) >> hash->cell_shift;
+    int cy1 = (y - radius) >> hash->cell_shift;
+    int cy2 = (y + radius) >> hash->cell_shift;
+    int cx, cy, i, n = 0;
+
+    for (cy = cy1; cy <= cy2; cy++)
+    {
+        for (cx = cx1; cx <= cx2; cx++)
+        {
+            FOR_ITEMS_IN_CELL (hash, cx, cy, i)
+            {
+                if (distance (hash, i, x, y, metric) >= limit) continue;
+                if (n < max_found) found[n] = i;
+                n++;
+            }
+        }
+    }
+    return n;
+}
+
+int nearest_spatial (const SPATIAL_HASH *hash, fixed x, fixed y,
+    fixed radius, int metric)
+{
+    long long limit = metric_distance (radius, metric);
+    long long best_distance = limit;
+    int cell_size = 1 << hash->cell_shift;
+    int x0 = x >> hash->cell_shift;
+    int y0 = y >> hash->cell_shift;
+    int best = -1;
+    int k, cx, cy, i;
+
+    /*
+       Look at the cells in square rings around the cell of (x, y).
+       Everything outside ring k is at least k cells away, so we can
+       stop when we have found something closer than that, or when
+       that is further than radius.
+    */
+    for (k = 0; ; k++)
+    {
+        for (cy = y0 - k; cy <= y0 + k; cy++)
+        {
+            // on the top and bottom rows all cells, on the other rows
+            // only the first and the last
+            int step = (cy == y0 - k || cy == y0 + k || k == 0) ? 1 : 2 * k;
+            for (cx = x0 - k; cx <= x0 + k; cx += step)
+            {
+                FOR_ITEMS_IN_CELL (hash, cx, cy, i)
+                {
+                    long long d = distance (hash, i, x, y, metric);
+                    if (d < best_distance)
+                    {
+                        best_distance = d;
+                        best = i;
+                    }
+                }
+            }
+        }
+        if ((long long)k * cell_size >= radius ||
+            best_distance <= metric_distance (k * cell_size, metric))
+            break;
+    }
+    return best;
+}
+
+void nearest_spatial_batch (const SPATIAL_HASH *hash, const fixed *x,
+    const fixed *y, int count, fixed radius, int metric, int *nearest)
+{
+    int i;
+    for (i = 0; i < count; i++)
+        nearest[i] = nearest_spatial (hash, x[i], y[i], radius, metric);
+}
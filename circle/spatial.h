@@ -0,0 +1,78 @@
+/*
+   SPATIAL.H
+   written by Martijn van Iersel (Amarillion)
+
+   CIRCLE 7 and 8 check whether the missile has reached its target
+   with abs (x - target_x) + abs (y - target_y) < itofix (10). With
+   many missiles and many targets, checking every missile against every
+   target takes far too long.
+
+   A SPATIAL_HASH divides the plane into square cells and remembers
+   which items (targets, for example) are in which cell. A query then
+   only has to look at the items in the few cells near the point it is
+   asked about. The cells are not stored in a big two-dimensional
+   array but in a hash table, so the plane has no edges and negative
+   coordinates work too.
+
+   The positions are not copied: the hash keeps pointers to the x and y
+   arrays of the caller (for example those of an ENTITIES, see
+   entities.h). After the items have moved, update_spatial_hash() moves
+   only the items that went into another cell.
+*/
+
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#include <allegro.h>
+
+// the ways to measure distance
+#define SPATIAL_MANHATTAN 0 // abs (dx) + abs (dy), as in CIRCLE 7 and 8
+#define SPATIAL_EUCLIDEAN 1 // sqrt (dx * dx + dy * dy)
+
+typedef struct SPATIAL_HASH
+{
+    int cell_shift; // a fixed coordinate >> cell_shift is the cell
+    int table_size; // number of buckets, a power of two
+    int *head; // the first item of each bucket, or -1
+    int max_items; // room in the arrays below
+    int count; // number of items
+    const fixed *x, *y; // positions of the items, owned by the caller
+    int *bucket; // the bucket each item is in
+    int *next, *prev; // the other items in the same bucket, or -1
+} SPATIAL_HASH;
+
+/* create_spatial_hash() makes a hash for up to max_items items, with
+   cells of cell_size pixels, which must be a power of two. Queries are
+   fastest with cells about as large as the radius that is asked for.
+   returns NULL if there is not enough memory. */
+SPATIAL_HASH *create_spatial_hash (int cell_size, int max_items);
+void destroy_spatial_hash (SPATIAL_HASH *hash);
+
+/* set_spatial_items() puts count items into the hash, the position of
+   item i is (x[i], y[i]). The arrays must stay valid while the hash
+   is used. returns -1 if count is larger than max_items. */
+int set_spatial_items (SPATIAL_HASH *hash, const fixed *x, const fixed *y,
+    int count);
+
+/* update_spatial_hash() reads the positions again, after the items
+   have moved. returns the number of items that changed cell. */
+int update_spatial_hash (SPATIAL_HASH *hash);
+
+/* query_spatial() finds all items closer than radius to (x, y). Up to
+   max_found of them are stored in found, in no particular order.
+   returns the number of items it found, which can be more than
+   max_found. */
+int query_spatial (const SPATIAL_HASH *hash, fixed x, fixed y, fixed radius,
+    int metric, int *found, int max_found);
+
+/* nearest_spatial() returns the item closest to (x, y), or -1 if none
+   is closer than radius. */
+int nearest_spatial (const SPATIAL_HASH *hash, fixed x, fixed y,
+    fixed radius, int metric);
+
+/* nearest_spatial_batch() does nearest_spatial() for count points,
+   for example every missile, and stores the items in nearest. */
+void nearest_spatial_batch (const SPATIAL_HASH *hash, const fixed *x,
+    const fixed *y, int count, fixed radius, int metric, int *nearest);
+
+#endif
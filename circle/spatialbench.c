@@ -0,0 +1,198 @@
+/*
+    SPATIAL HASH BENCHMARK
+    Written by Amarillion (amarillion@yahoo.com)
+
+    This program compares checking every missile against every target
+    with a SPATIAL_HASH (see spatial.h), for 10000 missiles and 10000
+    targets spread over a field of 10000x10000 pixels. For each missile
+    it checks whether it has reached a target, as in CIRCLE 7, and
+    finds the nearest target. It doesn't need a screen, the results are
+    printed as text:
+
+    operation,method,ms,mismatches
+
+    mismatches is the number of missiles for which the hash gives
+    another answer than checking all pairs, which should be 0.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <allegro.h>
+#include "spatial.h"
+#include "../common/walltime.h"
+
+#define MISSILES 10000
+#define TARGETS 10000
+#define FIELD 10000
+#define CELL_SIZE 64
+#define NEAREST_RADIUS itofix (1000)
+#define RUNS 5
+
+fixed missile_x[MISSILES], missile_y[MISSILES];
+fixed target_x[TARGETS], target_y[TARGETS];
+int arrived[MISSILES], arrived_hash[MISSILES];
+int nearest[MISSILES], nearest_hash[MISSILES];
+
+fixed random_coordinate ()
+{
+    return itofix (rand () % FIELD) + (rand () & 0xFFFF);
+}
+
+// the square of the distance, to compare the nearest targets
+double distance2 (int m, int t)
+{
+    double dx = fixtof (target_x[t] - missile_x[m]);
+    double dy = fixtof (target_y[t] - missile_y[m]);
+    return dx * dx + dy * dy;
+}
+
+// the number of the first target a missile has reached, or -1
+void arrival_all_pairs ()
+{
+    int m, t;
+    for (m = 0; m < MISSILES; m++)
+    {
+        arrived[m] = -1;
+        for (t = 0; t < TARGETS; t++)
+        {
+            if (abs (missile_x[m] - target_x[t]) +
+                abs (missile_y[m] - target_y[t]) < itofix (10))
+            {
+                arrived[m] = t;
+                break;
+            }
+        }
+    }
+}
+
+void arrival_hash (SPATIAL_HASH *hash)
+{
+    int m, found;
+    for (m = 0; m < MISSILES; m++)
+    {
+        // any target will do, so one is enough
+        if (query_spatial (hash, missile_x[m], missile_y[m], itofix (10),
+            SPATIAL_MANHATTAN, &found, 1) > 0)
+            arrived_hash[m] = found;
+        else
+            arrived_hash[m] = -1;
+    }
+}
+
+void nearest_all_pairs ()
+{
+    int m, t;
+    for (m = 0; m < MISSILES; m++)
+    {
+        double best = fixtof (NEAREST_RADIUS) * fixtof (NEAREST_RADIUS);
+        nearest[m] = -1;
+        for (t = 0; t < TARGETS; t++)
+        {
+            double d = distance2 (m, t);
+            if (d < best)
+            {
+                best = d;
+                nearest[m] = t;
+            }
+        }
+    }
+}
+
+void print_result (const char *operation, const char *method,
+    double seconds, int mismatches)
+{
+    printf ("%s,%s,%.3f,%d\n", operation, method, seconds * 1000.0,
+        mismatches);
+}
+
+int main ()
+{
+    SPATIAL_HASH *hash;
+    double start, seconds;
+    int i, run, mismatches, moved = 0;
+
+    // we don't draw anything, so we don't need a graphics mode
+    if (allegro_init () < 0)
+    {
+        allegro_message ("Error: Could not initialize Allegro");
+        return -1;
+    }
+
+    srand (1);
+    for (i = 0; i < MISSILES; i++)
+    {
+        missile_x[i] = random_coordinate ();
+        missile_y[i] = random_coordinate ();
+    }
+    for (i = 0; i < TARGETS; i++)
+    {
+        target_x[i] = random_coordinate ();
+        target_y[i] = random_coordinate ();
+    }
+    hash = create_spatial_hash (CELL_SIZE, TARGETS);
+
+    printf ("operation,method,ms,mismatches\n");
+
+    start = wall_time ();
+    for (run = 0; run < RUNS; run++)
+        set_spatial_items (hash, target_x, target_y, TARGETS);
+    print_result ("build", "spatial_hash", (wall_time () - start) / RUNS, 0);
+
+    // move the targets a little, as in a game, and update the hash
+    seconds = 0;
+    for (run = 0; run < RUNS; run++)
+    {
+        for (i = 0; i < TARGETS; i++)
+        {
+            target_x[i] += itofix (rand () % 5 - 2);
+            target_y[i] += itofix (rand () % 5 - 2);
+        }
+        start = wall_time ();
+        moved += update_spatial_hash (hash);
+        seconds += wall_time () - start;
+    }
+    print_result ("update", "spatial_hash", seconds / RUNS, 0);
+    printf ("# %.0f of %d targets changed cell per update\n",
+        (double)moved / RUNS, TARGETS);
+
+    start = wall_time ();
+    arrival_all_pairs ();
+    print_result ("arrival", "all_pairs", wall_time () - start, 0);
+
+    start = wall_time ();
+    for (run = 0; run < RUNS; run++)
+        arrival_hash (hash);
+    seconds = (wall_time () - start) / RUNS;
+    // the hash may find another target than the first one, but it
+    // should find one for the same missiles
+    mismatches = 0;
+    for (i = 0; i < MISSILES; i++)
+        if ((arrived[i] < 0) != (arrived_hash[i] < 0)) mismatches++;
+    print_result ("arrival", "spatial_hash", seconds, mismatches);
+
+    start = wall_time ();
+    nearest_all_pairs ();
+    print_result ("nearest", "all_pairs", wall_time () - start, 0);
+
+    start = wall_time ();
+    for (run = 0; run < RUNS; run++)
+        nearest_spatial_batch (hash, missile_x, missile_y, MISSILES,
+            NEAREST_RADIUS, SPATIAL_EUCLIDEAN, nearest_hash);
+    seconds = (wall_time () - start) / RUNS;
+    // two targets can be just as close, so compare the distances
+    mismatches = 0;
+    for (i = 0; i < MISSILES; i++)
+    {
+        if ((nearest[i] < 0) != (nearest_hash[i] < 0))
+            mismatches++;
+        else if (nearest[i] >= 0 &&
+            distance2 (i, nearest[i]) != distance2 (i, nearest_hash[i]))
+            mismatches++;
+    }
+    print_result ("nearest", "spatial_hash", seconds, mismatches);
+
+    destroy_spatial_hash (hash);
+    allegro_exit ();
+    return 0;
+
+} END_OF_MAIN ();
@@ -0,0 +1,214 @@
+/*
+   STEER.C
+   written by Martijn van Iersel (Amarillion)
+
+   See steer.h
+*/
+
+#include <math.h>
+#include <allegro.h>
+#include "steer.h"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define STEER_X86
+#include <immintrin.h>
+#endif
+
+// radians to fixed angles, a full circle (2 PI) is 1 << 24
+#define RAD_TO_ANGLE 2670176.9f
+
+/*
+   atan (t) for t from 0 to 1, as a polynomial in t * t. This is a
+   least squares fit, off by at most 1.7e-6 radians, which is 4.4 units
+   of a fixed angle. The coefficients are multiplied by RAD_TO_ANGLE, so
+   the result is a fixed angle. Calculating it in floats and rounding
+   it adds up to one more unit, so approx_atan2 is off by less than 6.
+*/
+#define ATAN_C1  (0.99997726f * RAD_TO_ANGLE)
+#define ATAN_C3 (-0.33262347f * RAD_TO_ANGLE)
+#define ATAN_C5  (0.19354346f * RAD_TO_ANGLE)
+#define ATAN_C7 (-0.11643287f * RAD_TO_ANGLE)
+#define ATAN_C9  (0.05265332f * RAD_TO_ANGLE)
+#define ATAN_C11 (-0.01172120f * RAD_TO_ANGLE)
+
+// FALSE if set_steer_simd (FALSE) was called
+static int use_simd = TRUE;
+
+/*
+   The angle of (x, y), as a fixed angle & 0xFFFFFF. The AVX2 version
+   below does exactly the same operations in the same order, so it
+   gets exactly the same results.
+*/
+static fixed approx_atan2 (fixed y, fixed x)
+{
+    float ax = fabsf ((float)x);
+    float ay = fabsf ((float)y);
+    float mx = ax > ay ? ax : ay;
+    float mn = ax > ay ? ay : ax;
+    float t, s, r;
+    fixed a;
+
+    // atan (t) for the smaller of y/x and x/y, so that t <= 1
+    t = mx > 0 ? mn / mx : 0;
+    s = t * t;
+    r = ATAN_C11;
+    r = r * s + ATAN_C9;
+    r = r * s + ATAN_C7;
+    r = r * s + ATAN_C5;
+    r = r * s + ATAN_C3;
+    r = r * s + ATAN_C1;
+    r = r * t;
+
+    a = (fixed)lrintf (r);
+
+    // then mirror it into the right octant. This is done with ints,
+    // so that -ffast-math can't change the rounding.
+    if (ay > ax) a = itofix (64) - a;
+    if (x < 0) a = itofix (128) - a;
+    if (y < 0) a = -a;
+
+    return a & 0xFFFFFF;
+}
+
+#ifdef STEER_X86
+
+/*
+   approx_atan2() on 8 pairs at once
+*/
+__attribute__((target("avx2")))
+static __m256i atan2_avx2 (__m256i y, __m256i x)
+{
+    __m256 sign = _mm256_set1_ps (-0.0f);
+    __m256 fx = _mm256_cvtepi32_ps (x);
+    __m256 fy = _mm256_cvtepi32_ps (y);
+    __m256 ax = _mm256_andnot_ps (sign, fx);
+    __m256 ay = _mm256_andnot_ps (sign, fy);
+    __m256 mx = _mm256_max_ps (ax, ay);
+    __m256 mn = _mm256_min_ps (ax, ay);
+    __m256 t, s, r;
+    __m256i a;
+
+    // With -ffast-math gcc turns a float division into an approximate
+    // one, but only for vectors, so the C version would differ. A
+    // division in double rounded to float is the same as an exact
+    // float division.
+    t = _mm256_setr_m128 (
+        _mm256_cvtpd_ps (_mm256_div_pd (
+            _mm256_cvtps_pd (_mm256_castps256_ps128 (mn)),
+            _mm256_cvtps_pd (_mm256_castps256_ps128 (mx)))),
+        _mm256_cvtpd_ps (_mm256_div_pd (
+            _mm256_cvtps_pd (_mm256_extractf128_ps (mn, 1)),
+            _mm256_cvtps_pd (_mm256_extractf128_ps (mx, 1)))));
+    // where mx is 0, t would be 0 / 0
+    t = _mm256_and_ps (t, _mm256_cmp_ps (mx, _mm256_setzero_ps (), _CMP_GT_OQ));
+    s = _mm256_mul_ps (t, t);
+    r = _mm256_set1_ps (ATAN_C11);
+    r = _mm256_add_ps (_mm256_mul_ps (r, s), _mm256_set1_ps (ATAN_C9));
+    r = _mm256_add_ps (_mm256_mul_ps (r, s), _mm256_set1_ps (ATAN_C7));
+    r = _mm256_add_ps (_mm256_mul_ps (r, s), _mm256_set1_ps (ATAN_C5));
+    r = _mm256_add_ps (_mm256_mul_ps (r, s), _mm256_set1_ps (ATAN_C3));
+    r = _mm256_add_ps (_mm256_mul_ps (r, s), _mm256_set1_ps (ATAN_C1));
+    r = _mm256_mul_ps (r, t);
+
+    a = _mm256_cvtps_epi32 (r);
+
+    a = _mm256_blendv_epi8 (a, _mm256_sub_epi32 (_mm256_set1_epi32 (itofix (64)), a),
+        _mm256_castps_si256 (_mm256_cmp_ps (ay, ax, _CMP_GT_OQ)));
+    a = _mm256_blendv_epi8 (a, _mm256_sub_epi32 (_mm256_set1_epi32 (itofix (128)), a),
+        _mm256_srai_epi32 (x, 31));
+    a = _mm256_blendv_epi8 (a, _mm256_sub_epi32 (_mm256_setzero_si256 (), a),
+        _mm256_srai_epi32 (y, 31));
+
+    return _mm256_and_si256 (a, _mm256_set1_epi32 (0xFFFFFF));
+}
+
+// returns how many angles it did, the rest is left for the C version
+__attribute__((target("avx2")))
+static int batch_atan2_avx2 (const fixed *y, const fixed *x, fixed *angle,
+    int count)
+{
+    int i;
+    for (i = 0; i + 8 <= count; i += 8)
+        _mm256_storeu_si256 ((__m256i *)(angle + i), atan2_avx2 (
+            _mm256_loadu_si256 ((const __m256i *)(y + i)),
+            _mm256_loadu_si256 ((const __m256i *)(x + i))));
+    return i;
+}
+
+__attribute__((target("avx2")))
+static int steer_avx2 (const fixed *x, const fixed *y,
+    const fixed *target_x, const fixed *target_y,
+    fixed *angle, fixed angle_stepsize, int count)
+{
+    __m256i mask = _mm256_set1_epi32 (0xFFFFFF);
+    __m256i half = _mm256_set1_epi32 (itofix (128));
+    __m256i step = _mm256_set1_epi32 (angle_stepsize);
+    int i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        __m256i vx = _mm256_loadu_si256 ((const __m256i *)(x + i));
+        __m256i vy = _mm256_loadu_si256 ((const __m256i *)(y + i));
+        __m256i tx = _mm256_loadu_si256 ((const __m256i *)(target_x + i));
+        __m256i ty = _mm256_loadu_si256 ((const __m256i *)(target_y + i));
+        __m256i a = _mm256_loadu_si256 ((const __m256i *)(angle + i));
+        __m256i target_angle = atan2_avx2 (_mm256_sub_epi32 (ty, vy),
+            _mm256_sub_epi32 (tx, vx));
+        // after the & both sides are positive, so a signed compare works
+        __m256i left = _mm256_cmpgt_epi32 (half,
+            _mm256_and_si256 (_mm256_sub_epi32 (a, target_angle), mask));
+        // step where we turn right, -step where we turn left
+        __m256i turn = _mm256_sub_epi32 (_mm256_xor_si256 (step, left), left);
+        _mm256_storeu_si256 ((__m256i *)(angle + i),
+            _mm256_and_si256 (_mm256_add_epi32 (a, turn), mask));
+    }
+    return i;
+}
+
+#endif
+
+void batch_atan2 (const fixed *y, const fixed *x, fixed *angle, int count)
+{
+    int i = 0;
+#ifdef STEER_X86
+    if (use_simd && steer_simd_supported ())
+        i = batch_atan2_avx2 (y, x, angle, count);
+#endif
+    for (; i < count; i++)
+        angle[i] = approx_atan2 (y[i], x[i]);
+}
+
+void steer_missiles (const fixed *x, const fixed *y,
+    const fixed *target_x, const fixed *target_y,
+    fixed *angle, fixed angle_stepsize, int count)
+{
+    int i = 0;
+#ifdef STEER_X86
+    if (use_simd && steer_simd_supported ())
+        i = steer_avx2 (x, y, target_x, target_y, angle, angle_stepsize, count);
+#endif
+    for (; i < count; i++)
+    {
+        fixed target_angle = approx_atan2 (target_y[i] - y[i],
+            target_x[i] - x[i]);
+        // see circ7.c
+        if (((angle[i] - target_angle) & 0xFFFFFF) < itofix (128))
+            angle[i] = (angle[i] - angle_stepsize) & 0xFFFFFF;
+        else
+            angle[i] = (angle[i] + angle_stepsize) & 0xFFFFFF;
+    }
+}
+
+int steer_simd_supported ()
+{
+#ifdef STEER_X86
+    return __builtin_cpu_supports ("avx2");
+#else
+    return FALSE;
+#endif
+}
+
+void set_steer_simd (int enable)
+{
+    use_simd = enable;
+}
@@ -0,0 +1,49 @@
+/*
+   STEER.H
+   written by Martijn van Iersel (Amarillion)
+
+   home_in() in CIRCLE 7 steers one homing missile. A game with
+   thousands of them spends most of its time in fatan2(), one call per
+   missile per frame. steer_missiles() steers a whole array of
+   missiles at once. The positions are kept in separate arrays for x
+   and y (not in an array of structs), so that AVX2 can load 8 missiles
+   at a time.
+
+   Instead of fatan2(), the angle to the target comes from a small
+   polynomial. The polynomial is off by at most 1.7e-6 radians, which
+   is 4.4 units of a fixed angle (a ten-thousandth of a degree). After
+   rounding, the angle is less than 6 units off. So a missile only turns
+   the other way than in CIRCLE 7 when the target is almost straight
+   ahead or behind it.
+*/
+
+#ifndef STEER_H
+#define STEER_H
+
+#include <allegro.h>
+
+/* batch_atan2() is like fatan2 (y[i], x[i]) for count pairs, but the
+   angles are between 0 and 256 (& 0xFFFFFF) instead of between
+   -128 and 128. The angle of (0, 0) is 0. */
+void batch_atan2 (const fixed *y, const fixed *x, fixed *angle, int count);
+
+/* steer_missiles() turns each missile angle_stepsize towards its
+   target, with the same rule as CIRCLE 7:
+
+   target_angle = fatan2 (target_y[i] - y[i], target_x[i] - x[i]);
+   if (((angle[i] - target_angle) & 0xFFFFFF) < itofix (128))
+       angle[i] = (angle[i] - angle_stepsize) & 0xFFFFFF;
+   else
+       angle[i] = (angle[i] + angle_stepsize) & 0xFFFFFF;
+
+   The results are the same with and without AVX2. */
+void steer_missiles (const fixed *x, const fixed *y,
+    const fixed *target_x, const fixed *target_y,
+    fixed *angle, fixed angle_stepsize, int count);
+
+/* Returns TRUE if AVX2 can be used on this processor.
+   set_steer_simd (FALSE) turns it off, to compare both. */
+int steer_simd_supported ();
+void set_steer_simd (int enable);
+
+#endif
@@ -0,0 +1,168 @@
+/*
+    STEERING BENCHMARK
+    Written by Amarillion (amarillion@yahoo.com)
+
+    This program measures how many homing missiles per second can be
+    steered with fatan2(), as in CIRCLE 7, and with steer_missiles()
+    (see steer.h) with and without AVX2, for 1000, 10000 and 100000
+    missiles. It doesn't need a screen, the results are printed as
+    text:
+
+    method,missiles,mmissiles_per_sec,max_error,different_turns
+
+    max_error is the largest difference between the angle to the target
+    and the exact one, in units of a fixed angle (1 << 24 is a full
+    circle). different_turns is the number of missiles that turn the
+    other way than with fatan2().
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <allegro.h>
+#include "steer.h"
+#include "../common/walltime.h"
+
+// about this many missiles are steered for each measurement
+#define UPDATES 20000000
+
+enum { FATAN2, STEER_C, STEER_AVX2 };
+
+const char *method_names[] = { "fatan2", "steer_c", "steer_avx2" };
+
+fixed *x, *y, *target_x, *target_y, *angle;
+
+// home_in() of CIRCLE 7, without the moving and drawing
+void steer_fatan2 (int count, fixed angle_stepsize)
+{
+    int i;
+    for (i = 0; i < count; i++)
+    {
+        fixed target_angle = fatan2 (target_y[i] - y[i], target_x[i] - x[i]);
+        if (((angle[i] - target_angle) & 0xFFFFFF) < itofix (128))
+            angle[i] = (angle[i] - angle_stepsize) & 0xFFFFFF;
+        else
+            angle[i] = (angle[i] + angle_stepsize) & 0xFFFFFF;
+    }
+}
+
+void run_method (int method, int count)
+{
+    if (method == FATAN2)
+        steer_fatan2 (count, itofix (3));
+    else
+    {
+        set_steer_simd (method == STEER_AVX2);
+        steer_missiles (x, y, target_x, target_y, angle, itofix (3), count);
+        set_steer_simd (TRUE);
+    }
+}
+
+// random missiles and targets on a 1920x1080 screen
+void init_missiles (int count)
+{
+    int i;
+    srand (1);
+    for (i = 0; i < count; i++)
+    {
+        x[i] = itofix (rand () % 1920) + (rand () & 0xFFFF);
+        y[i] = itofix (rand () % 1080) + (rand () & 0xFFFF);
+        target_x[i] = itofix (rand () % 1920) + (rand () & 0xFFFF);
+        target_y[i] = itofix (rand () % 1080) + (rand () & 0xFFFF);
+        angle[i] = itofix (rand () % 256);
+    }
+}
+
+void benchmark (int method, int count)
+{
+    int frames = UPDATES / count;
+    fixed *start_angle = malloc (count * sizeof (fixed));
+    fixed *reference = malloc (count * sizeof (fixed));
+    double start, seconds, max_error = 0;
+    int i, different_turns = 0;
+
+    init_missiles (count);
+    for (i = 0; i < count; i++) start_angle[i] = angle[i];
+
+    // one step of each missile, compared with fatan2
+    steer_fatan2 (count, itofix (3));
+    for (i = 0; i < count; i++)
+    {
+        reference[i] = angle[i];
+        angle[i] = start_angle[i];
+    }
+    run_method (method, count);
+    for (i = 0; i < count; i++)
+    {
+        if (angle[i] != reference[i]) different_turns++;
+        angle[i] = start_angle[i];
+    }
+
+    // the angles to the targets, compared with the exact ones
+    for (i = 0; i < count; i++)
+    {
+        fixed dx = target_x[i] - x[i], dy = target_y[i] - y[i];
+        fixed approx;
+        double exact, error;
+        if (method == FATAN2)
+            approx = fatan2 (dy, dx);
+        else
+        {
+            set_steer_simd (method == STEER_AVX2);
+            batch_atan2 (&dy, &dx, &approx, 1);
+            set_steer_simd (TRUE);
+        }
+        exact = atan2 (dy, dx) * (1 << 23) / AL_PI;
+        error = fmod (fabs (approx - exact), 1 << 24);
+        if (error > (1 << 23)) error = (1 << 24) - error;
+        if (error > max_error) max_error = error;
+    }
+
+    start = wall_time ();
+    for (i = 0; i < frames; i++)
+        run_method (method, count);
+    seconds = wall_time () - start;
+
+    printf ("%s,%d,%.1f,%.0f,%d\n", method_names[method], count,
+        (double)frames * count / seconds / 1e6, max_error, different_turns);
+    free (reference);
+    free (start_angle);
+}
+
+int main ()
+{
+    int counts[] = {1000, 10000, 100000};
+    int i, method;
+
+    // we don't draw anything, so we don't need a graphics mode
+    if (allegro_init () < 0)
+    {
+        allegro_message ("Error: Could not initialize Allegro");
+        return -1;
+    }
+
+    x = malloc (100000 * sizeof (fixed));
+    y = malloc (100000 * sizeof (fixed));
+    target_x = malloc (100000 * sizeof (fixed));
+    target_y = malloc (100000 * sizeof (fixed));
+    angle = malloc (100000 * sizeof (fixed));
+
+    printf ("method,missiles,mmissiles_per_sec,max_error,different_turns\n");
+    for (i = 0; i < 3; i++)
+    {
+        for (method = FATAN2; method <= STEER_AVX2; method++)
+        {
+            if (method == STEER_AVX2 && !steer_simd_supported ()) continue;
+            benchmark (method, counts[i]);
+        }
+    }
+
+    free (angle);
+    free (target_y);
+    free (target_x);
+    free (y);
+    free (x);
+    allegro_exit ();
+    return 0;
+
+} END_OF_MAIN ();
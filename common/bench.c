@@ -0,0 +1,231 @@
+/*
+   BENCH.C
+   written by Martijn van Iersel (Amarillion)
+
+   See bench.h
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <allegro.h>
+#include "bench.h"
+#include "walltime.h"
+
+static int bench_w = 640;
+static int bench_h = 480;
+static int bench_depth = 32;
+static int bench_runs = 100;
+static const char *bench_only = NULL;
+static int accuracy_header = FALSE;
+static int failed_checks = 0;
+
+// returns TRUE if name is one of the comma separated names in list
+static int in_list (const char *list, const char *name)
+{
+    int len = strlen (name);
+    while (list)
+    {
+        if (strncmp (list, name, len) == 0 &&
+            (list[len] == ',' || list[len] == '\0'))
+            return TRUE;
+        list = strchr (list, ',');
+        if (list) list++;
+    }
+    return FALSE;
+}
+
+static int compare_doubles (const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+    count_pixels() finds out how many pixels a kernel draws.
+    It draws the frame twice, once on a bitmap filled with 0 and once on
+    a bitmap filled with 1. Each pixel that was drawn has the same value
+    both times, so it can't still be 0 the first time and 1 the second.
+*/
+static int count_pixels (BITMAP *bmp, BENCH_KERNEL kernel, void *data)
+{
+    BITMAP *first = create_bitmap (bmp->w, bmp->h);
+    int x, y, count = 0;
+
+    clear_to_color (bmp, 0);
+    kernel (bmp, 0, data);
+    blit (bmp, first, 0, 0, 0, 0, bmp->w, bmp->h);
+    clear_to_color (bmp, 1);
+    kernel (bmp, 0, data);
+
+    for (y = 0; y < bmp->h; y++)
+        for (x = 0; x < bmp->w; x++)
+            if (getpixel (first, x, y) != 0 || getpixel (bmp, x, y) != 1)
+                count++;
+
+    destroy_bitmap (first);
+    return count;
+}
+
+int bench_init (int argc, char *argv[])
+{
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp (argv[i], "-w") == 0 && i + 1 < argc)
+            bench_w = atoi (argv[++i]);
+        else if (strcmp (argv[i], "-h") == 0 && i + 1 < argc)
+            bench_h = atoi (argv[++i]);
+        else if (strcmp (argv[i], "-depth") == 0 && i + 1 < argc)
+            bench_depth = atoi (argv[++i]);
+        else if (strcmp (argv[i], "-runs") == 0 && i + 1 < argc)
+            bench_runs = atoi (argv[++i]);
+        else if (strcmp (argv[i], "-kernel") == 0 && i + 1 < argc)
+            bench_only = argv[++i];
+        else
+        {
+            fprintf (stderr, "Error: unknown option %s\n", argv[i]);
+            return -1;
+        }
+    }
+    if (bench_w <= 0 || bench_h <= 0 || bench_runs <= 0) return -1;
+
+    // we only use memory bitmaps, so we don't need any drivers
+    if (install_allegro (SYSTEM_NONE, &errno, atexit) != 0)
+        return -1;
+    set_color_depth (bench_depth);
+    screen = create_bitmap (bench_w, bench_h);
+    if (!screen) return -1;
+
+    printf ("kernel,width,height,depth,runs,pixels,"
+        "min_ms,median_ms,p99_ms,ns_per_pixel,fps\n");
+    return 0;
+}
+
+void bench_kernel (const char *name, BENCH_KERNEL kernel, void *data)
+{
+    BITMAP *bmp;
+    double *times, start, median;
+    int i, pixels;
+
+    if (bench_only && !in_list (bench_only, name)) return;
+
+    bmp = create_bitmap (bench_w, bench_h);
+    times = malloc (bench_runs * sizeof (double));
+
+    // this also warms up the caches
+    pixels = count_pixels (bmp, kernel, data);
+
+    for (i = 0; i < bench_runs; i++)
+    {
+        start = wall_time ();
+        kernel (bmp, i, data);
+        times[i] = (wall_time () - start) * 1000.0;
+    }
+    qsort (times, bench_runs, sizeof (double), compare_doubles);
+    median = times[bench_runs / 2];
+
+    printf ("%s,%d,%d,%d,%d,%d,%.4f,%.4f,%.4f,%.3f,%.1f\n",
+        name, bench_w, bench_h, bench_depth, bench_runs, pixels,
+        times[0], median, times[(bench_runs * 99 - 1) / 100],
+        pixels ? median * 1e6 / pixels : 0.0,
+        median > 0 ? 1000.0 / median : 0.0);
+    fflush (stdout);
+
+    free (times);
+    destroy_bitmap (bmp);
+}
+
+static void print_accuracy_header ()
+{
+    if (!accuracy_header)
+    {
+        printf ("\nkernel,reference,width,height,depth,differing_pixels,max_error\n");
+        accuracy_header = TRUE;
+    }
+}
+
+/*
+    compare_frame() draws a frame of kernel and of reference, each on a
+    cleared bitmap, adds the number of pixels that differ to *differ
+    and raises *max_error to the largest difference.
+*/
+static void compare_frame (BENCH_KERNEL kernel, BENCH_KERNEL reference,
+    void *data, int frame, int *differ, int *max_error)
+{
+    BITMAP *bmp = create_bitmap (bench_w, bench_h);
+    BITMAP *ref = create_bitmap (bench_w, bench_h);
+    int depth = bitmap_color_depth (screen);
+    int x, y;
+
+    clear_bitmap (bmp);
+    clear_bitmap (ref);
+    kernel (bmp, frame, data);
+    reference (ref, frame, data);
+
+    for (y = 0; y < bmp->h; y++)
+        for (x = 0; x < bmp->w; x++)
+        {
+            int a = getpixel (bmp, x, y), b = getpixel (ref, x, y);
+            int error;
+            if (a == b) continue;
+            (*differ)++;
+            error = ABS (getr_depth (depth, a) - getr_depth (depth, b));
+            error = MAX (error, ABS (getg_depth (depth, a) - getg_depth (depth, b)));
+            error = MAX (error, ABS (getb_depth (depth, a) - getb_depth (depth, b)));
+            if (error > *max_error) *max_error = error;
+        }
+
+    destroy_bitmap (bmp);
+    destroy_bitmap (ref);
+}
+
+void bench_accuracy (const char *name, BENCH_KERNEL kernel,
+    const char *ref_name, BENCH_KERNEL reference, void *data)
+{
+    int differ = 0, max_error = 0;
+
+    if (bench_only && !in_list (bench_only, name)) return;
+    print_accuracy_header ();
+
+    compare_frame (kernel, reference, data, 0, &differ, &max_error);
+
+    printf ("%s,%s,%d,%d,%d,%d,%d\n", name, ref_name, bench_w, bench_h,
+        bench_depth, differ, max_error);
+    fflush (stdout);
+}
+
+void bench_check (const char *name, BENCH_KERNEL kernel,
+    const char *ref_name, BENCH_KERNEL reference, void *data, int max_error)
+{
+    int frame, differ = 0, error = 0;
+
+    if (bench_only && !in_list (bench_only, name)) return;
+    print_accuracy_header ();
+
+    for (frame = 0; frame < 256; frame += 17)
+        compare_frame (kernel, reference, data, frame, &differ, &error);
+
+    printf ("%s,%s,%d,%d,%d,%d,%d\n", name, ref_name, bench_w, bench_h,
+        bench_depth, differ, error);
+    fflush (stdout);
+
+    // a bit that is not red, green or blue also counts when they
+    // have to be the same
+    if (error > max_error || (max_error == 0 && differ > 0))
+    {
+        fprintf (stderr, "Error: %s is off by %d from %s at %d bit, "
+            "more than %d\n", name, error, ref_name, bench_depth, max_error);
+        failed_checks++;
+    }
+}
+
+int bench_exit ()
+{
+    destroy_bitmap (screen);
+    screen = NULL;
+    allegro_exit ();
+    return failed_checks ? -1 : 0;
+}
@@ -0,0 +1,67 @@
+/*
+   BENCH.H
+   written by Martijn van Iersel (Amarillion)
+
+   A small harness to measure the drawing functions of the examples on
+   their own. Each function is called again and again on a memory
+   bitmap, and the results are printed as CSV, one line per function:
+
+   kernel,width,height,depth,runs,pixels,min_ms,median_ms,p99_ms,ns_per_pixel,fps
+
+   pixels is the number of pixels the function draws in one call.
+   ns_per_pixel and fps are calculated from the median time.
+
+   Command line options:
+
+   -w W, -h H         size of the bitmap to draw on (default 640x480)
+   -depth BPP         color depth (default 32)
+   -runs N            number of calls to time (default 100)
+   -kernel NAMES      only measure these functions, separated by commas
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <allegro.h>
+
+/* A kernel draws one frame on bmp. frame counts up from 0, so the
+   kernel can for example rotate a bit further each time.
+   data is passed on unchanged. */
+typedef void (*BENCH_KERNEL) (BITMAP *bmp, int frame, void *data);
+
+/* bench_init() reads the command line, initializes Allegro without
+   a graphics driver and prints the CSV header. Some drawing functions
+   look at the color depth of the screen, so the screen is a memory
+   bitmap of the chosen size and depth. Bitmaps created after
+   bench_init() have the chosen color depth as well.
+   returns 0 on success. */
+int bench_init (int argc, char *argv[]);
+
+/* bench_kernel() measures a single kernel and prints its CSV line. */
+void bench_kernel (const char *name, BENCH_KERNEL kernel, void *data);
+
+/* bench_accuracy() draws frame 0 of kernel and of reference, each on a
+   cleared bitmap, and compares them. After the timings it prints a
+   second table, with the number of pixels that differ and the largest
+   difference of a red, green or blue value (0 - 255):
+
+   kernel,reference,width,height,depth,differing_pixels,max_error
+
+   -kernel selects these lines by the name of kernel as well. */
+void bench_accuracy (const char *name, BENCH_KERNEL kernel,
+    const char *ref_name, BENCH_KERNEL reference, void *data);
+
+/* bench_check() is bench_accuracy() as a test. It compares the frames
+   0, 17, 34 ... 255, a full turn for the kernels that rotate with the
+   frame, and prints one line for all of them together. If any frame
+   is off by more than max_error, it prints an error and bench_exit()
+   will fail. With a max_error of 0 the pictures must be exactly the
+   same. */
+void bench_check (const char *name, BENCH_KERNEL kernel,
+    const char *ref_name, BENCH_KERNEL reference, void *data, int max_error);
+
+/* bench_exit() returns 0, or -1 if a bench_check() failed, so main()
+   can return it. */
+int bench_exit ();
+
+#endif
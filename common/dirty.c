@@ -0,0 +1,194 @@
+/*
+   DIRTY.C
+   written by Martijn van Iersel (Amarillion)
+
+   See dirty.h
+*/
+
+#include <stdlib.h>
+#include <allegro.h>
+#include "dirty.h"
+
+DIRTY *create_dirty (BITMAP *background)
+{
+    DIRTY *dirty = calloc (1, sizeof (DIRTY));
+    if (!dirty) return NULL;
+    dirty->background = background;
+    return dirty;
+}
+
+void destroy_dirty (DIRTY *dirty)
+{
+    free (dirty->drawn.rects);
+    free (dirty->erased.rects);
+    free (dirty->flush.rects);
+    free (dirty);
+}
+
+// add a rectangle to list, which must already be clipped
+static void add_rect (DIRTY_LIST *list, const DIRTY_RECT *rect)
+{
+    if (list->count >= list->max)
+    {
+        int max = list->max ? list->max * 2 : 64;
+        DIRTY_RECT *rects = realloc (list->rects, max * sizeof (DIRTY_RECT));
+        // without memory we can't remember it, so then just forget it
+        if (!rects) return;
+        list->rects = rects;
+        list->max = max;
+    }
+    list->rects[list->count++] = *rect;
+}
+
+void mark_dirty (DIRTY *dirty, int x, int y, int w, int h)
+{
+    DIRTY_RECT rect;
+    int x2 = MIN (x + w, dirty->background->w);
+    int y2 = MIN (y + h, dirty->background->h);
+
+    rect.x = MAX (x, 0);
+    rect.y = MAX (y, 0);
+    rect.w = x2 - rect.x;
+    rect.h = y2 - rect.y;
+    if (rect.w > 0 && rect.h > 0)
+        add_rect (&dirty->drawn, &rect);
+}
+
+void dirty_putpixel (DIRTY *dirty, BITMAP *bmp, int x, int y, int color)
+{
+    putpixel (bmp, x, y, color);
+    mark_dirty (dirty, x, y, 1, 1);
+}
+
+void dirty_line (DIRTY *dirty, BITMAP *bmp, int x1, int y1, int x2, int y2,
+    int color)
+{
+    line (bmp, x1, y1, x2, y2, color);
+    mark_dirty (dirty, MIN (x1, x2), MIN (y1, y2),
+        ABS (x2 - x1) + 1, ABS (y2 - y1) + 1);
+}
+
+void dirty_circle (DIRTY *dirty, BITMAP *bmp, int x, int y, int radius,
+    int color)
+{
+    circle (bmp, x, y, radius, color);
+    mark_dirty (dirty, x - radius, y - radius, 2 * radius + 1, 2 * radius + 1);
+}
+
+static int compare_x (const void *a, const void *b)
+{
+    return ((const DIRTY_RECT *)a)->x - ((const DIRTY_RECT *)b)->x;
+}
+
+void merge_dirty_rects (DIRTY_LIST *list)
+{
+    int i, j, n, merged;
+
+    if (list->count < 2) return;
+
+    // Joining two rectangles makes a bigger one, which may now
+    // overlap a rectangle that was checked before, so keep going
+    // until nothing changes.
+    do
+    {
+        merged = FALSE;
+
+        // Sorted from left to right, only the rectangles that start
+        // before a ends can overlap with a. a is the leftmost of the
+        // two, so joining them can only move its right side.
+        qsort (list->rects, list->count, sizeof (DIRTY_RECT), compare_x);
+        for (i = 0; i < list->count; i++)
+        {
+            DIRTY_RECT *a = &list->rects[i];
+            if (a->w == 0) continue;
+            for (j = i + 1; j < list->count &&
+                list->rects[j].x < a->x + a->w; j++)
+            {
+                DIRTY_RECT *b = &list->rects[j];
+                int y2;
+
+                if (b->w == 0 || b->y >= a->y + a->h || a->y >= b->y + b->h)
+                    continue;
+                a->w = MAX (a->x + a->w, b->x + b->w) - a->x;
+                y2 = MAX (a->y + a->h, b->y + b->h);
+                a->y = MIN (a->y, b->y);
+                a->h = y2 - a->y;
+
+                // b is part of a now
+                b->w = 0;
+                merged = TRUE;
+            }
+        }
+
+        // remove the rectangles that were joined with another one
+        for (i = n = 0; i < list->count; i++)
+            if (list->rects[i].w > 0)
+                list->rects[n++] = list->rects[i];
+        list->count = n;
+    } while (merged);
+}
+
+/*
+   When the rectangles cover half the background or more anyway, a
+   single rectangle over all of it is faster to copy, and to compute.
+*/
+static void simplify_rects (DIRTY *dirty, DIRTY_LIST *list)
+{
+    double area = 0;
+    int i;
+
+    for (i = 0; i < list->count; i++)
+        area += (double)list->rects[i].w * list->rects[i].h;
+    if (area * 2 >= (double)dirty->background->w * dirty->background->h)
+    {
+        list->count = 1;
+        list->rects[0].x = 0;
+        list->rects[0].y = 0;
+        list->rects[0].w = dirty->background->w;
+        list->rects[0].h = dirty->background->h;
+    }
+    else
+        merge_dirty_rects (list);
+}
+
+// copy the rectangles of list from source to target
+static int copy_rects (const DIRTY_LIST *list, BITMAP *source, BITMAP *target)
+{
+    int i, pixels = 0;
+    for (i = 0; i < list->count; i++)
+    {
+        const DIRTY_RECT *r = &list->rects[i];
+        blit (source, target, r->x, r->y, r->x, r->y, r->w, r->h);
+        pixels += r->w * r->h;
+    }
+    return pixels;
+}
+
+void restore_dirty (DIRTY *dirty, BITMAP *target)
+{
+    DIRTY_LIST swap;
+
+    simplify_rects (dirty, &dirty->drawn);
+    dirty->restored_pixels = copy_rects (&dirty->drawn, dirty->background,
+        target);
+
+    // what was drawn is now erased, and nothing is drawn yet
+    swap = dirty->erased;
+    dirty->erased = dirty->drawn;
+    dirty->drawn = swap;
+    dirty->drawn.count = 0;
+}
+
+void flush_dirty (DIRTY *dirty, BITMAP *buffer, BITMAP *target)
+{
+    int i;
+
+    // everything that was erased or drawn, merged together
+    dirty->flush.count = 0;
+    for (i = 0; i < dirty->erased.count; i++)
+        add_rect (&dirty->flush, &dirty->erased.rects[i]);
+    for (i = 0; i < dirty->drawn.count; i++)
+        add_rect (&dirty->flush, &dirty->drawn.rects[i]);
+    simplify_rects (dirty, &dirty->flush);
+    dirty->flushed_pixels = copy_rects (&dirty->flush, buffer, target);
+}
@@ -0,0 +1,79 @@
+/*
+   DIRTY.H
+   written by Martijn van Iersel (Amarillion)
+
+   Most animated examples clear the whole screen each frame, or erase
+   the last frame by drawing over it in black, and then draw everything
+   again. But only a few small parts of the screen actually change.
+
+   A DIRTY keeps track of those parts. Draw with dirty_putpixel(),
+   dirty_line() and dirty_circle() and it remembers a rectangle around
+   everything that was drawn. At the start of the next frame,
+   restore_dirty() erases all of it by copying those rectangles back
+   from a background bitmap, and nothing else is touched.
+
+   When drawing on a buffer first, flush_dirty() copies only the parts
+   of the buffer that changed to the screen.
+*/
+
+#ifndef DIRTY_H
+#define DIRTY_H
+
+#include <allegro.h>
+
+typedef struct DIRTY_RECT
+{
+    int x, y, w, h;
+} DIRTY_RECT;
+
+// a growing list of rectangles
+typedef struct DIRTY_LIST
+{
+    int count, max;
+    DIRTY_RECT *rects;
+} DIRTY_LIST;
+
+typedef struct DIRTY
+{
+    BITMAP *background; // what the screen looks like with nothing on it
+    DIRTY_LIST drawn; // what was drawn during this frame
+    DIRTY_LIST erased; // what restore_dirty() erased last
+    DIRTY_LIST flush; // used by flush_dirty()
+    int restored_pixels; // the number of pixels restore_dirty() copied
+    int flushed_pixels; // and the same for flush_dirty()
+} DIRTY;
+
+/* create_dirty() makes a DIRTY that restores from background.
+   Rectangles are clipped to the size of the background.
+   returns NULL if there is not enough memory. */
+DIRTY *create_dirty (BITMAP *background);
+void destroy_dirty (DIRTY *dirty);
+
+/* mark_dirty() adds a rectangle to the parts drawn during this frame.
+   It is only needed for drawing that doesn't go through the functions
+   below. */
+void mark_dirty (DIRTY *dirty, int x, int y, int w, int h);
+
+/* the same as putpixel(), line() and circle(), and they mark what
+   they draw */
+void dirty_putpixel (DIRTY *dirty, BITMAP *bmp, int x, int y, int color);
+void dirty_line (DIRTY *dirty, BITMAP *bmp, int x1, int y1, int x2, int y2,
+    int color);
+void dirty_circle (DIRTY *dirty, BITMAP *bmp, int x, int y, int radius,
+    int color);
+
+/* merge_dirty_rects() joins all overlapping rectangles in list into
+   one around both, until no two of them overlap. */
+void merge_dirty_rects (DIRTY_LIST *list);
+
+/* restore_dirty() copies the background over everything that was
+   drawn on target since the last call, and starts a new frame.
+   When that is half the background or more, it simply copies all of
+   it. */
+void restore_dirty (DIRTY *dirty, BITMAP *target);
+
+/* flush_dirty() copies what was erased and drawn during this frame
+   from buffer to target, for example from a buffer to the screen. */
+void flush_dirty (DIRTY *dirty, BITMAP *buffer, BITMAP *target);
+
+#endif
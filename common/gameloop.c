@@ -0,0 +1,151 @@
+/*
+   GAMELOOP.C
+   written by Martijn van Iersel (Amarillion)
+
+   See gameloop.h
+*/
+
+#include <string.h>
+#include <allegro.h>
+#include "gameloop.h"
+#include "headless.h"
+#include "walltime.h"
+
+/*
+   ticks is increased by the timer updates_per_second times per second.
+   It only goes up, the loop keeps its own count of the updates it did.
+*/
+static volatile int ticks = 0;
+
+static void ticker ()
+{
+    ticks++;
+}
+END_OF_STATIC_FUNCTION (ticker);
+
+// add the times of one frame to stats
+static void count_frame (GAME_LOOP_STATS *stats, int updates,
+    double update_seconds, double render_seconds)
+{
+    stats->frames++;
+    stats->updates += updates;
+    stats->frame_updates = updates;
+    stats->update_ms = update_seconds * 1000.0;
+    stats->render_ms = render_seconds * 1000.0;
+    stats->total_update_ms += stats->update_ms;
+    stats->total_render_ms += stats->render_ms;
+}
+
+// without a timer: one update, then draw
+static void run_headless (GAME_UPDATE update, GAME_RENDER render,
+    void *data, GAME_LOOP_STATS *stats)
+{
+    int done = FALSE;
+    double start, updated;
+
+    while (!done)
+    {
+        start = wall_time ();
+        done = update (data);
+        if (done)
+        {
+            stats->updates++;
+            break;
+        }
+        updated = wall_time ();
+        render (data, itofix (1));
+        count_frame (stats, 1, updated - start, wall_time () - updated);
+        headless_frame ();
+    }
+}
+
+int run_game_loop (int updates_per_second, int max_frame_skip,
+    int interpolate, GAME_UPDATE update, GAME_RENDER render, void *data,
+    GAME_LOOP_STATS *stats)
+{
+    GAME_LOOP_STATS local_stats;
+    int done = FALSE;
+    int updates_done = 0; // the number of ticks handled so far
+    int last_tick = 0;
+    double last_tick_time, start, updated;
+
+    if (!stats) stats = &local_stats;
+    memset (stats, 0, sizeof (GAME_LOOP_STATS));
+
+    if (is_headless ())
+    {
+        run_headless (update, render, data, stats);
+        return 0;
+    }
+
+    LOCK_VARIABLE (ticks);
+    LOCK_FUNCTION (ticker);
+    ticks = 0;
+    if (install_int_ex (ticker, BPS_TO_TIMER (updates_per_second)) != 0)
+        return -1;
+    last_tick_time = wall_time ();
+
+    while (!done)
+    {
+        int now = ticks;
+        int pending = now - updates_done;
+        int frame_updates = 0;
+        fixed alpha = itofix (1);
+
+        // The timer only tells us that a tick happened, not when, so
+        // we take the time at which we first see it. That is precise
+        // enough to interpolate with.
+        if (now != last_tick)
+        {
+            last_tick = now;
+            last_tick_time = wall_time ();
+        }
+
+        if (pending == 0 && !interpolate)
+        {
+            // nothing has changed, so there is nothing to draw
+            rest (1);
+            continue;
+        }
+
+        // If we are too far behind, forget about the oldest updates.
+        // The game slows down, but it doesn't have to catch up with
+        // more and more updates, each taking time as well.
+        if (pending > max_frame_skip + 1)
+        {
+            stats->skipped += pending - (max_frame_skip + 1);
+            updates_done += pending - (max_frame_skip + 1);
+            pending = max_frame_skip + 1;
+        }
+
+        start = wall_time ();
+        while (pending > 0 && !done)
+        {
+            done = update (data);
+            updates_done++;
+            pending--;
+            frame_updates++;
+        }
+        updated = wall_time ();
+        if (done)
+        {
+            stats->updates += frame_updates;
+            break;
+        }
+
+        if (interpolate)
+        {
+            double a = (updated - last_tick_time) * updates_per_second;
+            alpha = a < 1.0 ? ftofix (a) : itofix (1);
+        }
+        render (data, alpha);
+        count_frame (stats, frame_updates, updated - start,
+            wall_time () - updated);
+
+        // give other programs a chance too
+        if (interpolate) rest (0);
+    }
+
+    remove_int (ticker);
+    return 0;
+}
@@ -0,0 +1,74 @@
+/*
+   GAMELOOP.H
+   written by Martijn van Iersel (Amarillion)
+
+   The animated examples used to move everything one step, draw it,
+   and then rest (10). So the speed depended on how long the drawing
+   took, and the rest of the time the processor did nothing.
+
+   run_game_loop() separates the two. An Allegro timer says when it is
+   time for the next update, so the game runs at the same speed on every
+   computer. In between, the frame is drawn as often as there is time
+   for. Because the drawing is usually somewhere in between two
+   updates, it gets an alpha that says how far: it can then draw
+   everything a bit further than the previous update, for a smoother
+   animation than the update rate alone would give.
+
+   When the computer can't keep up, a couple of updates are done
+   before drawing the next frame (frame skipping). If it is even
+   slower than that, the game slows down instead.
+
+   In headless mode (see headless.h) there is no timer: each frame
+   is exactly one update, drawn with alpha itofix (1), so the saved
+   frames are the same on every computer.
+*/
+
+#ifndef GAMELOOP_H
+#define GAMELOOP_H
+
+#include <allegro.h>
+
+/* update moves the game one step further. It returns TRUE to stop
+   the loop. */
+typedef int (*GAME_UPDATE) (void *data);
+
+/* render draws the game. alpha goes from 0 (draw the state of the
+   update before the last one) to itofix (1) (draw the last update). */
+typedef void (*GAME_RENDER) (void *data, fixed alpha);
+
+typedef struct GAME_LOOP_STATS
+{
+    int frames; // number of frames drawn
+    int updates; // number of updates done
+    int skipped; // updates dropped because the computer was too slow
+    // the last frame: updates done before it, and the time in
+    // milliseconds spent updating and drawing
+    int frame_updates;
+    double update_ms, render_ms;
+    // the total times of all frames
+    double total_update_ms, total_render_ms;
+} GAME_LOOP_STATS;
+
+/* run_game_loop() calls update updates_per_second times per second,
+   until it returns TRUE, and render after each batch of updates.
+   max_frame_skip is the number of frames that may be skipped to
+   catch up, 0 means never skip a frame.
+   With interpolate TRUE, render is also called when there was no
+   update, with an alpha that grows with the time since the last one.
+   Otherwise render is only called after updates, with itofix (1).
+   If stats is not NULL it is kept up to date after every frame, so
+   render can show it.
+   Allegro's timer must be installed. returns 0, or -1 if the timer
+   could not be started. */
+int run_game_loop (int updates_per_second, int max_frame_skip,
+    int interpolate, GAME_UPDATE update, GAME_RENDER render, void *data,
+    GAME_LOOP_STATS *stats);
+
+/* helpers for render: the value between a and b at alpha, and the same
+   for angles, going the short way around the circle */
+#define lerp_fixed(a, b, alpha) ((a) + fmul ((b) - (a), alpha))
+#define lerp_angle(a, b, alpha) \
+    (((a) + fmul ((((b) - (a) + itofix (128)) & 0xFFFFFF) - itofix (128), \
+        alpha)) & 0xFFFFFF)
+
+#endif
@@ -0,0 +1,235 @@
+/*
+   HEADLESS.C
+   written by Martijn van Iersel (Amarillion)
+
+   See headless.h
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <allegro.h>
+#include "headless.h"
+
+// a single line of the key script
+typedef struct KEY_EVENT
+{
+    int first, last; // the frames to hold the key down
+    int scancode;
+} KEY_EVENT;
+
+#define MAX_KEY_EVENTS 256
+
+static int headless = FALSE;
+static int num_frames = 1;
+static int frame = 0;
+static const char *out_pattern = "frame%04d.ppm";
+static int depth = 0;
+static KEY_EVENT key_events[MAX_KEY_EVENTS];
+static int num_key_events = 0;
+
+// the names that can be used in a key script
+static const struct { const char *name; int scancode; } key_names[] =
+{
+    {"A", KEY_A}, {"B", KEY_B}, {"C", KEY_C}, {"D", KEY_D}, {"E", KEY_E},
+    {"F", KEY_F}, {"G", KEY_G}, {"H", KEY_H}, {"I", KEY_I}, {"J", KEY_J},
+    {"K", KEY_K}, {"L", KEY_L}, {"M", KEY_M}, {"N", KEY_N}, {"O", KEY_O},
+    {"P", KEY_P}, {"Q", KEY_Q}, {"R", KEY_R}, {"S", KEY_S}, {"T", KEY_T},
+    {"U", KEY_U}, {"V", KEY_V}, {"W", KEY_W}, {"X", KEY_X}, {"Y", KEY_Y},
+    {"Z", KEY_Z},
+    {"0", KEY_0}, {"1", KEY_1}, {"2", KEY_2}, {"3", KEY_3}, {"4", KEY_4},
+    {"5", KEY_5}, {"6", KEY_6}, {"7", KEY_7}, {"8", KEY_8}, {"9", KEY_9},
+    {"UP", KEY_UP}, {"DOWN", KEY_DOWN}, {"LEFT", KEY_LEFT},
+    {"RIGHT", KEY_RIGHT}, {"SPACE", KEY_SPACE}, {"ENTER", KEY_ENTER},
+    {"ESC", KEY_ESC},
+    {NULL, 0}
+};
+
+/*
+    parse_keys() reads a key script like "0-49:UP,60:B".
+    returns 0 on success.
+*/
+static int parse_keys (const char *script)
+{
+    char name[16];
+    int first, last, n, i;
+
+    while (*script)
+    {
+        if (num_key_events >= MAX_KEY_EVENTS) return -1;
+        if (sscanf (script, "%d-%d:%15[A-Z0-9]%n", &first, &last, name, &n) != 3)
+        {
+            if (sscanf (script, "%d:%15[A-Z0-9]%n", &first, name, &n) != 2)
+                return -1;
+            last = first;
+        }
+        for (i = 0; key_names[i].name; i++)
+            if (strcmp (key_names[i].name, name) == 0) break;
+        if (!key_names[i].name) return -1;
+
+        key_events[num_key_events].first = first;
+        key_events[num_key_events].last = last;
+        key_events[num_key_events].scancode = key_names[i].scancode;
+        num_key_events++;
+
+        script += n;
+        if (*script == ',') script++;
+        else if (*script) return -1;
+    }
+    return 0;
+}
+
+// set key[] for the current frame
+static void apply_keys ()
+{
+    int i;
+    for (i = 0; i < num_key_events; i++)
+        key[key_events[i].scancode] = 0;
+    for (i = 0; i < num_key_events; i++)
+        if (frame >= key_events[i].first && frame <= key_events[i].last)
+            key[key_events[i].scancode] = TRUE;
+}
+
+/*
+    save_ppm() saves a bitmap as a binary PPM file.
+    PPM is about the simplest image format there is: a short text
+    header followed by the red, green and blue bytes of each pixel.
+    returns 0 on success.
+*/
+static int save_ppm (const char *filename, BITMAP *bmp)
+{
+    int bpp = bitmap_color_depth (bmp);
+    FILE *fp = fopen (filename, "wb");
+    int x, y, c;
+
+    if (!fp) return -1;
+    fprintf (fp, "P6\n%d %d\n255\n", bmp->w, bmp->h);
+    for (y = 0; y < bmp->h; y++)
+    {
+        for (x = 0; x < bmp->w; x++)
+        {
+            c = getpixel (bmp, x, y);
+            fputc (getr_depth (bpp, c), fp);
+            fputc (getg_depth (bpp, c), fp);
+            fputc (getb_depth (bpp, c), fp);
+        }
+    }
+    fclose (fp);
+    return 0;
+}
+
+int headless_init (int argc, char *argv[])
+{
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp (argv[i], "-headless") == 0)
+            headless = TRUE;
+        else if (strcmp (argv[i], "-frames") == 0 && i + 1 < argc)
+            num_frames = atoi (argv[++i]);
+        else if (strcmp (argv[i], "-out") == 0 && i + 1 < argc)
+            out_pattern = argv[++i];
+        else if (strcmp (argv[i], "-depth") == 0 && i + 1 < argc)
+            depth = atoi (argv[++i]);
+        else if (strcmp (argv[i], "-keys") == 0 && i + 1 < argc)
+        {
+            if (parse_keys (argv[++i]) != 0)
+            {
+                fprintf (stderr, "Error: could not understand key script %s\n",
+                    argv[i]);
+                return -1;
+            }
+        }
+        else
+        {
+            fprintf (stderr, "Error: unknown option or missing value: %s\n", argv[i]);
+            return -1;
+        }
+    }
+
+    if (!headless)
+        return allegro_init ();
+
+    // start Allegro without any drivers at all
+    if (install_allegro (SYSTEM_NONE, &errno, atexit) != 0)
+        return -1;
+    apply_keys ();
+    return 0;
+}
+
+int headless_set_gfx_mode (int card, int w, int h, int v_w, int v_h)
+{
+    if (!headless)
+        return set_gfx_mode (card, w, h, v_w, v_h);
+
+    if (depth) set_color_depth (depth);
+    screen = create_bitmap (w, h);
+    if (!screen) return -1;
+    clear_bitmap (screen);
+    return 0;
+}
+
+int headless_install_keyboard ()
+{
+    if (!headless)
+        return install_keyboard ();
+    return 0;
+}
+
+int headless_install_timer ()
+{
+    if (!headless)
+        return install_timer ();
+    return 0;
+}
+
+void headless_rest (unsigned int time)
+{
+    if (!headless)
+        rest (time);
+}
+
+void headless_vsync ()
+{
+    if (!headless)
+        vsync ();
+}
+
+void headless_frame ()
+{
+    char filename[1024];
+
+    if (!headless) return;
+
+    if (strcmp (out_pattern, "none") != 0)
+    {
+        snprintf (filename, sizeof (filename), out_pattern, frame);
+        if (save_ppm (filename, screen) != 0)
+            fprintf (stderr, "Error: could not write %s\n", filename);
+    }
+
+    frame++;
+    apply_keys ();
+
+    // after the last frame, press Esc to stop the example
+    if (frame >= num_frames)
+    {
+        key[KEY_ESC] = TRUE;
+        simulate_keypress ((KEY_ESC << 8) | 27);
+    }
+}
+
+void headless_still ()
+{
+    if (!headless) return;
+
+    do headless_frame ();
+    while (frame < num_frames);
+}
+
+int is_headless ()
+{
+    return headless;
+}
@@ -0,0 +1,66 @@
+/*
+   HEADLESS.H
+   written by Martijn van Iersel (Amarillion)
+
+   All examples can also run without a screen or keyboard, for example
+   to render frames on a machine without a display. Start them with
+   -headless and they draw onto a memory bitmap instead of the screen,
+   save every frame to a file, and stop after a number of frames.
+
+   Command line options:
+
+   -headless          turn headless mode on
+   -frames N          stop after N frames (default 1). The examples
+                      that draw only one picture save it N times.
+   -keys SCRIPT       keys to hold down during certain frames, for
+                      example "0-49:UP,20-29:LEFT,60:B" holds UP during
+                      frames 0 to 49, LEFT during frames 20 to 29, and
+                      presses B during frame 60
+   -out PATTERN       file name for the frames, printf style
+                      (default "frame%04d.ppm"). Use "none" to save
+                      nothing, for example when benchmarking.
+   -depth BPP         color depth of the screen bitmap
+
+   The functions below are used instead of the Allegro functions of
+   the same name. Without -headless they just call those functions.
+*/
+
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <allegro.h>
+
+/* In headless mode there is no graphics driver, so the size of the
+   screen has to come from the screen bitmap itself. */
+#undef SCREEN_W
+#undef SCREEN_H
+#define SCREEN_W (gfx_driver ? gfx_driver->w : (screen ? screen->w : 0))
+#define SCREEN_H (gfx_driver ? gfx_driver->h : (screen ? screen->h : 0))
+
+// instead of allegro_init ()
+int headless_init (int argc, char *argv[]);
+// instead of set_gfx_mode (), creates a memory bitmap for the screen
+int headless_set_gfx_mode (int card, int w, int h, int v_w, int v_h);
+// instead of install_keyboard (), the keys come from the script
+int headless_install_keyboard ();
+// instead of install_timer (), there is nothing to wait for
+int headless_install_timer ();
+// instead of rest () and vsync (), these don't wait in headless mode
+void headless_rest (unsigned int time);
+void headless_vsync ();
+
+/* headless_frame() must be called at the end of each frame, when the
+   screen shows what it should. In headless mode it saves the screen,
+   sets key[] for the next frame according to the script, and after
+   the last frame presses Esc so that the example stops. */
+void headless_frame ();
+
+/* The examples that draw only one picture call headless_still()
+   instead. In headless mode it saves the picture as every frame, so
+   that Esc is pressed whatever -frames says. */
+void headless_still ();
+
+// returns TRUE if the program was started with -headless
+int is_headless ();
+
+#endif
@@ -0,0 +1,129 @@
+/*
+   REAL.H
+   written by Martijn van Iersel (Amarillion)
+
+   Most examples calculate with Allegro's fixed numbers, CIRCLE 1 uses
+   floats. Which is faster, and how much accuracy do you lose? To find
+   out, a function can be written once with the macros below and then
+   compiled for fixed, float or double numbers.
+
+   Define REAL_FLOAT or REAL_DOUBLE before including this file to get
+   floats or doubles, otherwise you get fixed. That can be done on the
+   command line: sphere/makefile compiles spherereal.c three times,
+   with -DREAL_FLOAT, -DREAL_DOUBLE and neither, and links the objects
+   it needs. Unlike other headers this one can also be included again
+   with another choice, so a single source file can hold all three
+   versions: circle/realbench.c includes circreal.c three times.
+
+   Angles are always in the units of fsin() and fcos(): 256 is a full
+   circle. Parameters that come from the rest of the program stay
+   fixed, ftor() converts them.
+
+   REAL                 the type: fixed, float or double
+   REAL_NAME(name)      name_fixed, name_float or name_double
+   itor(i), rtoi(r)     int to real and back, rtoi() rounds like fixtoi()
+   ftor(f)              fixed to real
+   rmul(a, b), rdiv(a, b)
+   rmuli(a, i), rdivi(a, i)     multiply or divide by an int
+   rsin(a), rcos(a), rasin(x), ratan2(y, x), rsqrt(x)
+   rsqrti(i)            square root of an int, for fixed done in double
+   rwrap(a)             an angle brought back to 0 .. 256
+*/
+
+#include <math.h>
+#include <allegro.h>
+
+#ifndef REAL_H_FUNCTIONS
+#define REAL_H_FUNCTIONS
+
+#define REAL_PI 3.14159265358979323846
+
+// fixasin() doesn't accept anything outside -1 .. 1, so neither do these
+static inline float real_asinf (float x)
+{
+    return asinf (x < -1.0f ? -1.0f : (x > 1.0f ? 1.0f : x)) *
+        (float)(128.0 / REAL_PI);
+}
+
+static inline double real_asind (double x)
+{
+    return asin (x < -1.0 ? -1.0 : (x > 1.0 ? 1.0 : x)) * (128.0 / REAL_PI);
+}
+
+#endif
+
+#undef REAL
+#undef REAL_NAME
+#undef itor
+#undef rtoi
+#undef ftor
+#undef rmul
+#undef rdiv
+#undef rmuli
+#undef rdivi
+#undef rsin
+#undef rcos
+#undef rasin
+#undef ratan2
+#undef rsqrt
+#undef rsqrti
+#undef rwrap
+
+#if defined(REAL_FLOAT)
+
+#define REAL float
+#define REAL_NAME(name) name##_float
+#define itor(i) ((float)(i))
+#define rtoi(r) ((int)floorf ((r) + 0.5f))
+#define ftor(f) fixtof (f)
+#define rmul(a, b) ((a) * (b))
+#define rdiv(a, b) ((a) / (b))
+#define rmuli(a, i) ((a) * (i))
+#define rdivi(a, i) ((a) / (i))
+#define rsin(a) sinf ((a) * (float)(REAL_PI / 128.0))
+#define rcos(a) cosf ((a) * (float)(REAL_PI / 128.0))
+#define rasin(x) real_asinf (x)
+#define ratan2(y, x) (atan2f (y, x) * (float)(128.0 / REAL_PI))
+#define rsqrt(x) sqrtf (x)
+#define rsqrti(i) sqrtf ((float)(i))
+#define rwrap(a) ((a) - 256.0f * floorf ((a) / 256.0f))
+
+#elif defined(REAL_DOUBLE)
+
+#define REAL double
+#define REAL_NAME(name) name##_double
+#define itor(i) ((double)(i))
+#define rtoi(r) ((int)floor ((r) + 0.5))
+#define ftor(f) fixtof (f)
+#define rmul(a, b) ((a) * (b))
+#define rdiv(a, b) ((a) / (b))
+#define rmuli(a, i) ((a) * (i))
+#define rdivi(a, i) ((a) / (i))
+#define rsin(a) sin ((a) * (REAL_PI / 128.0))
+#define rcos(a) cos ((a) * (REAL_PI / 128.0))
+#define rasin(x) real_asind (x)
+#define ratan2(y, x) (atan2 (y, x) * (128.0 / REAL_PI))
+#define rsqrt(x) sqrt (x)
+#define rsqrti(i) sqrt ((double)(i))
+#define rwrap(a) ((a) - 256.0 * floor ((a) / 256.0))
+
+#else
+
+#define REAL fixed
+#define REAL_NAME(name) name##_fixed
+#define itor(i) itofix (i)
+#define rtoi(r) fixtoi (r)
+#define ftor(f) (f)
+#define rmul(a, b) fixmul (a, b)
+#define rdiv(a, b) fixdiv (a, b)
+#define rmuli(a, i) ((a) * (i))
+#define rdivi(a, i) ((a) / (i))
+#define rsin(a) fixsin (a)
+#define rcos(a) fixcos (a)
+#define rasin(x) fixasin (x)
+#define ratan2(y, x) fixatan2 (y, x)
+#define rsqrt(x) fixsqrt (x)
+#define rsqrti(i) ftofix (sqrt ((double)(i)))
+#define rwrap(a) ((a) & 0xFFFFFF)
+
+#endif
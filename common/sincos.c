@@ -0,0 +1,202 @@
+/*
+   SINCOS.C
+   written by Martijn van Iersel (Amarillion)
+
+   See sincos.h
+*/
+
+#include <math.h>
+#include <allegro.h>
+#include "sincos.h"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define SINCOS_X86
+#include <immintrin.h>
+#endif
+
+#define MAX_BITS 16
+
+/*
+    The first quarter of the sine, quarter[k] = sin (k / size * 2 PI)
+    for k from 0 to size / 4. A full circle is 1 << 24 in fixed, so an
+    angle becomes an index by shifting it right by shift = 24 - bits.
+*/
+static fixed quarter[(1 << MAX_BITS) / 4 + 1];
+static int bits, size, shift;
+static int interpolate;
+static int ready = FALSE;
+
+// FALSE if set_sincos_simd (FALSE) was called
+static int use_simd = TRUE;
+
+int set_sincos_table (int new_size, int new_interpolate)
+{
+    int k, new_bits = 0;
+
+    while ((1 << new_bits) < new_size) new_bits++;
+    if ((1 << new_bits) != new_size || new_bits < 8 || new_bits > MAX_BITS)
+        return -1;
+
+    bits = new_bits;
+    size = new_size;
+    shift = 24 - bits;
+    interpolate = new_interpolate;
+    for (k = 0; k <= size / 4; k++)
+        quarter[k] = (fixed)floor (sin (k * 2 * AL_PI / size) * 65536.0 + 0.5);
+    ready = TRUE;
+    return 0;
+}
+
+/*
+    The index in the table for angle. Without interpolation the angle
+    is rounded to the nearest entry, like fsin() does.
+    Unsigned, so that negative angles wrap around too.
+*/
+#define SINCOS_INDEX(angle) \
+    ((((unsigned int)(angle) + (interpolate ? 0 : (1u << shift) / 2)) >> shift) \
+        & (size - 1))
+
+void fsincos (fixed angle, fixed *s, fixed *c)
+{
+    int i, q, j, frac, max = size / 4;
+    fixed s0, s1, c0, c1;
+
+    if (!ready) set_sincos_table (4096, FALSE);
+
+    i = SINCOS_INDEX (angle);
+    // the quarter of the circle, and the position in it
+    q = i >> (bits - 2);
+    j = i & (max - 1);
+
+    // in the second and fourth quarter the curve runs backwards,
+    // and the cosine is the sine a quarter further on
+    if (q & 1)
+    {
+        s0 = quarter[max - j];
+        c0 = quarter[j];
+    }
+    else
+    {
+        s0 = quarter[j];
+        c0 = quarter[max - j];
+    }
+
+    if (interpolate)
+    {
+        frac = angle & ((1 << shift) - 1);
+        if (q & 1)
+        {
+            s1 = quarter[max - j - 1];
+            c1 = quarter[j + 1];
+        }
+        else
+        {
+            s1 = quarter[j + 1];
+            c1 = quarter[max - j - 1];
+        }
+        s0 += ((s1 - s0) * frac + (1 << shift) / 2) >> shift;
+        c0 += ((c1 - c0) * frac + (1 << shift) / 2) >> shift;
+    }
+
+    // the sine is negative in the last two quarters,
+    // the cosine in the middle two
+    *s = (q & 2) ? -s0 : s0;
+    *c = ((q + 1) & 2) ? -c0 : c0;
+}
+
+#ifdef SINCOS_X86
+
+// negate the lanes of x where mask is all ones
+__attribute__((target("avx2")))
+static __m256i negate_where (__m256i x, __m256i mask)
+{
+    return _mm256_sub_epi32 (_mm256_xor_si256 (x, mask), mask);
+}
+
+/*
+    sincos_avx2() does exactly the same as fsincos(), on 8 angles at a
+    time. The table entries are fetched with gather instructions.
+    returns how many angles it did, the rest is left for fsincos().
+*/
+__attribute__((target("avx2")))
+static int sincos_avx2 (const fixed *angles, fixed *s, fixed *c, int count)
+{
+    const int *table = (const int *)quarter;
+    int max = size / 4;
+    __m128i vshift = _mm_cvtsi32_si128 (shift);
+    __m128i qshift = _mm_cvtsi32_si128 (bits - 2);
+    __m256i round = _mm256_set1_epi32 (interpolate ? 0 : (1 << shift) / 2);
+    __m256i index_mask = _mm256_set1_epi32 (size - 1);
+    __m256i j_mask = _mm256_set1_epi32 (max - 1);
+    __m256i frac_mask = _mm256_set1_epi32 ((1 << shift) - 1);
+    __m256i half = _mm256_set1_epi32 ((1 << shift) / 2);
+    __m256i vmax = _mm256_set1_epi32 (max);
+    __m256i one = _mm256_set1_epi32 (1);
+    __m256i two = _mm256_set1_epi32 (2);
+    int n;
+
+    for (n = 0; n + 8 <= count; n += 8)
+    {
+        __m256i a = _mm256_loadu_si256 ((const __m256i *)(angles + n));
+        __m256i i = _mm256_and_si256 (
+            _mm256_srl_epi32 (_mm256_add_epi32 (a, round), vshift), index_mask);
+        __m256i q = _mm256_srl_epi32 (i, qshift);
+        __m256i j = _mm256_and_si256 (i, j_mask);
+        __m256i k = _mm256_sub_epi32 (vmax, j);
+        __m256i odd = _mm256_cmpeq_epi32 (_mm256_and_si256 (q, one), one);
+        __m256i tj = _mm256_i32gather_epi32 (table, j, 4);
+        __m256i tk = _mm256_i32gather_epi32 (table, k, 4);
+        __m256i s0 = _mm256_blendv_epi8 (tj, tk, odd);
+        __m256i c0 = _mm256_blendv_epi8 (tk, tj, odd);
+
+        if (interpolate)
+        {
+            __m256i frac = _mm256_and_si256 (a, frac_mask);
+            __m256i tj1 = _mm256_i32gather_epi32 (table, _mm256_add_epi32 (j, one), 4);
+            __m256i tk1 = _mm256_i32gather_epi32 (table, _mm256_sub_epi32 (k, one), 4);
+            __m256i s1 = _mm256_blendv_epi8 (tj1, tk1, odd);
+            __m256i c1 = _mm256_blendv_epi8 (tk1, tj1, odd);
+            s0 = _mm256_add_epi32 (s0, _mm256_sra_epi32 (_mm256_add_epi32 (
+                _mm256_mullo_epi32 (_mm256_sub_epi32 (s1, s0), frac), half), vshift));
+            c0 = _mm256_add_epi32 (c0, _mm256_sra_epi32 (_mm256_add_epi32 (
+                _mm256_mullo_epi32 (_mm256_sub_epi32 (c1, c0), frac), half), vshift));
+        }
+
+        s0 = negate_where (s0,
+            _mm256_cmpeq_epi32 (_mm256_and_si256 (q, two), two));
+        c0 = negate_where (c0, _mm256_cmpeq_epi32 (
+            _mm256_and_si256 (_mm256_add_epi32 (q, one), two), two));
+        _mm256_storeu_si256 ((__m256i *)(s + n), s0);
+        _mm256_storeu_si256 ((__m256i *)(c + n), c0);
+    }
+    return n;
+}
+
+#endif
+
+void fsincos_batch (const fixed *angles, fixed *s, fixed *c, int count)
+{
+    int i = 0;
+
+    if (!ready) set_sincos_table (4096, FALSE);
+#ifdef SINCOS_X86
+    if (use_simd && sincos_simd_supported ())
+        i = sincos_avx2 (angles, s, c, count);
+#endif
+    for (; i < count; i++)
+        fsincos (angles[i], &s[i], &c[i]);
+}
+
+int sincos_simd_supported ()
+{
+#ifdef SINCOS_X86
+    return __builtin_cpu_supports ("avx2");
+#else
+    return FALSE;
+#endif
+}
+
+void set_sincos_simd (int enable)
+{
+    use_simd = enable;
+}
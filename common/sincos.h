@@ -0,0 +1,49 @@
+/*
+   SINCOS.H
+   written by Martijn van Iersel (Amarillion)
+
+   The animation loops often need the sine and the cosine of the same
+   angle. fsincos() looks up both at once in a table.
+
+   Because 256 is a full circle, an angle can be turned into a table
+   index with just a shift. And sin and cos are the same curve, a
+   quarter circle apart, and each quarter of the curve is a mirror
+   image of the first one. So the table only holds the first quarter,
+   and both values come from the same place in it.
+
+   The table can have from 256 to 65536 entries for a full circle.
+   Allegro's fsin() uses 512. Without interpolation the angle is
+   rounded to the nearest entry. With interpolation fsincos() goes in a
+   straight line from one entry to the next, which is a lot more
+   accurate for the price of two extra multiplications.
+*/
+
+#ifndef SINCOS_H
+#define SINCOS_H
+
+#include <allegro.h>
+
+/* set_sincos_table() makes a new table with size entries for a full
+   circle. size must be a power of two from 256 to 65536.
+   interpolate is TRUE to interpolate between the entries.
+   Without a call to set_sincos_table(), the first call to fsincos()
+   makes a table of 4096 entries without interpolation.
+   Don't call this while other threads use fsincos().
+   returns 0 on success. */
+int set_sincos_table (int size, int interpolate);
+
+/* fsincos() returns the sine and cosine of angle in *s and *c.
+   angle is in the same units as fsin() uses. */
+void fsincos (fixed angle, fixed *s, fixed *c);
+
+/* fsincos_batch() does the same for count angles at once. With AVX2 it
+   works on 8 angles at a time. The results are exactly the same as
+   those of fsincos(). */
+void fsincos_batch (const fixed *angles, fixed *s, fixed *c, int count);
+
+/* Returns TRUE if fsincos_batch() can use AVX2 on this processor.
+   set_sincos_simd (FALSE) turns it off, to compare both. */
+int sincos_simd_supported ();
+void set_sincos_simd (int enable);
+
+#endif
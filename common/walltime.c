@@ -0,0 +1,33 @@
+/*
+   WALLTIME.C
+   written by Martijn van Iersel (Amarillion)
+
+   See walltime.h
+*/
+
+#include "walltime.h"
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+double wall_time ()
+{
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter (&count);
+    QueryPerformanceFrequency (&frequency);
+    return (double)count.QuadPart / frequency.QuadPart;
+}
+
+#else
+
+#include <time.h>
+
+double wall_time ()
+{
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+#endif
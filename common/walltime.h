@@ -0,0 +1,15 @@
+/*
+   WALLTIME.H
+   written by Martijn van Iersel (Amarillion)
+
+   clock() measures processor time, which adds up the time of all
+   threads. To time multithreaded code we need the real time instead.
+*/
+
+#ifndef WALLTIME_H
+#define WALLTIME_H
+
+/* returns the time in seconds since some fixed point in the past */
+double wall_time ();
+
+#endif
@@ -0,0 +1,155 @@
+/*
+   WORKERS.C
+   written by Martijn van Iersel (Amarillion)
+
+   See workers.h
+*/
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "workers.h"
+
+struct WORKER_POOL
+{
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready; // signalled when there is a new job
+    pthread_cond_t work_done; // signalled when the last index is done
+    pthread_t *threads;
+    int num_threads;
+
+    // the current job
+    WORKER_JOB job;
+    void *data;
+    int count;
+    int next; // the next index that has not been handed out yet
+    int busy; // the number of indices that are not finished yet
+
+    int quit;
+};
+
+/*
+    take_index() hands out the next index of the current job.
+    The pool must be locked. Returns FALSE if there is nothing left.
+*/
+static int take_index (WORKER_POOL *pool, WORKER_JOB *job, void **data, int *index)
+{
+    if (pool->next >= pool->count) return 0;
+    *job = pool->job;
+    *data = pool->data;
+    *index = pool->next++;
+    return 1;
+}
+
+/*
+    finish_index() is called after an index is done.
+    The pool must be locked.
+*/
+static void finish_index (WORKER_POOL *pool)
+{
+    pool->busy--;
+    if (pool->busy == 0)
+        pthread_cond_signal (&pool->work_done);
+}
+
+static void *worker_thread (void *arg)
+{
+    WORKER_POOL *pool = arg;
+    WORKER_JOB job;
+    void *data;
+    int index;
+
+    pthread_mutex_lock (&pool->lock);
+    while (1)
+    {
+        // sleep until there is something to do
+        while (!pool->quit && !take_index (pool, &job, &data, &index))
+            pthread_cond_wait (&pool->work_ready, &pool->lock);
+        if (pool->quit) break;
+
+        // do the work without holding the lock
+        pthread_mutex_unlock (&pool->lock);
+        job (data, index);
+        pthread_mutex_lock (&pool->lock);
+        finish_index (pool);
+    }
+    pthread_mutex_unlock (&pool->lock);
+    return NULL;
+}
+
+WORKER_POOL *create_worker_pool (int num_threads)
+{
+    WORKER_POOL *pool = malloc (sizeof (WORKER_POOL));
+    int i;
+
+    if (num_threads < 1) num_threads = 1;
+    pthread_mutex_init (&pool->lock, NULL);
+    pthread_cond_init (&pool->work_ready, NULL);
+    pthread_cond_init (&pool->work_done, NULL);
+    pool->num_threads = num_threads;
+    pool->job = NULL;
+    pool->data = NULL;
+    pool->count = 0;
+    pool->next = 0;
+    pool->busy = 0;
+    pool->quit = 0;
+
+    // the calling thread is one of the workers, so we start one less
+    pool->threads = malloc (num_threads * sizeof (pthread_t));
+    for (i = 1; i < num_threads; i++)
+        pthread_create (&pool->threads[i], NULL, worker_thread, pool);
+    return pool;
+}
+
+void destroy_worker_pool (WORKER_POOL *pool)
+{
+    int i;
+
+    pthread_mutex_lock (&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast (&pool->work_ready);
+    pthread_mutex_unlock (&pool->lock);
+    for (i = 1; i < pool->num_threads; i++)
+        pthread_join (pool->threads[i], NULL);
+
+    pthread_cond_destroy (&pool->work_done);
+    pthread_cond_destroy (&pool->work_ready);
+    pthread_mutex_destroy (&pool->lock);
+    free (pool->threads);
+    free (pool);
+}
+
+int worker_pool_size (WORKER_POOL *pool)
+{
+    return pool->num_threads;
+}
+
+void run_workers (WORKER_POOL *pool, WORKER_JOB job, void *data, int count)
+{
+    void *my_data;
+    WORKER_JOB my_job;
+    int index;
+
+    if (count <= 0) return;
+
+    pthread_mutex_lock (&pool->lock);
+    pool->job = job;
+    pool->data = data;
+    pool->count = count;
+    pool->next = 0;
+    pool->busy = count;
+    pthread_cond_broadcast (&pool->work_ready);
+
+    // help out until everything is handed out
+    while (take_index (pool, &my_job, &my_data, &index))
+    {
+        pthread_mutex_unlock (&pool->lock);
+        my_job (my_data, index);
+        pthread_mutex_lock (&pool->lock);
+        finish_index (pool);
+    }
+
+    // then wait for the other threads to finish their part
+    while (pool->busy > 0)
+        pthread_cond_wait (&pool->work_done, &pool->lock);
+    pthread_mutex_unlock (&pool->lock);
+}
@@ -0,0 +1,30 @@
+/*
+   WORKERS.H
+   written by Martijn van Iersel (Amarillion)
+
+   A small pool of worker threads. The threads are started once and
+   then reused, so handing out work costs very little.
+*/
+
+#ifndef WORKERS_H
+#define WORKERS_H
+
+/* A job is a function that is called once for each index
+   from 0 to count - 1. data is passed on unchanged. */
+typedef void (*WORKER_JOB) (void *data, int index);
+
+typedef struct WORKER_POOL WORKER_POOL;
+
+/* create_worker_pool() creates a pool that runs jobs on num_threads
+   threads. The thread calling run_workers() counts as one of them,
+   so with num_threads = 1 no extra threads are started at all. */
+WORKER_POOL *create_worker_pool (int num_threads);
+void destroy_worker_pool (WORKER_POOL *pool);
+int worker_pool_size (WORKER_POOL *pool);
+
+/* run_workers() calls job (data, i) for each i from 0 to count - 1,
+   divided over all threads of the pool, and returns
+   when all of them are done. */
+void run_workers (WORKER_POOL *pool, WORKER_JOB job, void *data, int count);
+
+#endif
@@ -0,0 +1,35 @@
+/*
+   BMP2TEX.C
+   written by Martijn van Iersel (Amarillion)
+
+   Converts a BMP file to a tiled texture (see tiletex.h).
+   The bitmap is read a piece at a time, so it can be much larger
+   than the memory of the computer.
+
+   usage: bmp2tex input.bmp output.tex [tile_size]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <allegro.h>
+#include "tiletex.h"
+
+int main(int argc, char *argv[])
+{
+    int tile_size = 64;
+
+    if (argc < 3 || argc > 4)
+    {
+        printf ("usage: bmp2tex input.bmp output.tex [tile_size]\n");
+        return 1;
+    }
+    if (argc == 4) tile_size = atoi (argv[3]);
+    if (convert_bmp_to_tiled (argv[1], argv[2], tile_size) != 0)
+    {
+        printf ("Error: could not convert %s. It must be an uncompressed "
+            "24 or 32 bit BMP, and the tile size a power of two.\n", argv[1]);
+        return 1;
+    }
+    return 0;
+
+} END_OF_MAIN();
@@ -0,0 +1,245 @@
+/*
+   LIGHTRAMP.C
+   written by Martijn van Iersel (Amarillion)
+
+   See lightramp.h
+*/
+
+#include <stdint.h>
+#include <allegro.h>
+#include "lightramp.h"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define LIGHTRAMP_X86
+#include <emmintrin.h>
+#endif
+
+#define LIGHT_LEVELS 257
+
+// light factors above 256 are treated as 256, below 0 as 0
+#define CLAMP_LIGHT(l) MID (0, (l), LIGHT_LEVELS - 1)
+
+/*
+    The ramps for a 15 or 16 bit color depth. A channel of a pixel is
+    (pixel >> shift) & mask. ramp[c][l][v] is the part of the lit pixel
+    for value v of channel c at light level l, already shifted into
+    place, so a lit pixel is just the three parts or-ed together.
+*/
+typedef struct LIGHT_RAMPS
+{
+    int ready;
+    int shift[3], mask[3];
+    uint16_t ramp[3][LIGHT_LEVELS][64];
+} LIGHT_RAMPS;
+
+static LIGHT_RAMPS ramps15, ramps16;
+
+// find the shift and mask of a channel from the pixel of its full color
+static void find_channel (int full, int *shift, int *mask)
+{
+    *shift = 0;
+    while (!(full & 1))
+    {
+        full >>= 1;
+        (*shift)++;
+    }
+    *mask = full;
+}
+
+/*
+    make_ramps() fills the ramps with lit_color() itself, by lighting
+    each channel value on its own. That works because makecol15() and
+    makecol16() don't mix the channels.
+*/
+static void make_ramps (LIGHT_RAMPS *ramps, int depth)
+{
+    int c, l, v, pixel, rgb[3];
+
+    find_channel (makecol_depth (depth, 255, 0, 0), &ramps->shift[0], &ramps->mask[0]);
+    find_channel (makecol_depth (depth, 0, 255, 0), &ramps->shift[1], &ramps->mask[1]);
+    find_channel (makecol_depth (depth, 0, 0, 255), &ramps->shift[2], &ramps->mask[2]);
+
+    for (c = 0; c < 3; c++)
+    {
+        for (v = 0; v <= ramps->mask[c]; v++)
+        {
+            pixel = v << ramps->shift[c];
+            for (l = 0; l < LIGHT_LEVELS; l++)
+            {
+                rgb[0] = (getr_depth (depth, pixel) * l) >> 8;
+                rgb[1] = (getg_depth (depth, pixel) * l) >> 8;
+                rgb[2] = (getb_depth (depth, pixel) * l) >> 8;
+                ramps->ramp[c][l][v] =
+                    makecol_depth (depth, rgb[0], rgb[1], rgb[2]);
+            }
+        }
+    }
+    ramps->ready = TRUE;
+}
+
+static void light_ramps (LIGHT_RAMPS *ramps, int *colors, const int *light,
+    int count)
+{
+    int i, l, pixel;
+    for (i = 0; i < count; i++)
+    {
+        l = CLAMP_LIGHT (light[i]);
+        pixel = colors[i];
+        colors[i] =
+            ramps->ramp[0][l][(pixel >> ramps->shift[0]) & ramps->mask[0]] |
+            ramps->ramp[1][l][(pixel >> ramps->shift[1]) & ramps->mask[1]] |
+            ramps->ramp[2][l][(pixel >> ramps->shift[2]) & ramps->mask[2]];
+    }
+}
+
+/*
+    light_bytes() lights 24 and 32 bit colors. In both, each channel is a
+    byte of its own, so all bytes are multiplied by the light factor.
+    rgb_mask keeps only the bytes that are red, green or blue.
+*/
+static void light_bytes (int *colors, const int *light, int count,
+    int rgb_mask)
+{
+    int i = 0;
+
+#ifdef LIGHTRAMP_X86
+    __m128i zero = _mm_setzero_si128 ();
+    __m128i mask = _mm_set1_epi32 (rgb_mask);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i c = _mm_loadu_si128 ((const __m128i *)(colors + i));
+        __m128i l = _mm_loadu_si128 ((const __m128i *)(light + i));
+        // each light factor in the 4 words of its pixel
+        __m128i l16 = _mm_packs_epi32 (l, l);
+        __m128i l_lo, l_hi, c_lo, c_hi;
+        l16 = _mm_min_epi16 (l16, _mm_set1_epi16 (LIGHT_LEVELS - 1));
+        l16 = _mm_max_epi16 (l16, zero);
+        l16 = _mm_unpacklo_epi16 (l16, l16);
+        l_lo = _mm_unpacklo_epi32 (l16, l16);
+        l_hi = _mm_unpackhi_epi32 (l16, l16);
+        // 255 * 256 still fits in an unsigned word
+        c_lo = _mm_srli_epi16 (_mm_mullo_epi16 (_mm_unpacklo_epi8 (c, zero), l_lo), 8);
+        c_hi = _mm_srli_epi16 (_mm_mullo_epi16 (_mm_unpackhi_epi8 (c, zero), l_hi), 8);
+        c = _mm_and_si128 (_mm_packus_epi16 (c_lo, c_hi), mask);
+        _mm_storeu_si128 ((__m128i *)(colors + i), c);
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        unsigned int pixel = colors[i];
+        unsigned int l = CLAMP_LIGHT (light[i]);
+        colors[i] = ((((pixel & 0xFF) * l) >> 8) |
+            ((((pixel >> 8) & 0xFF) * l) >> 8) << 8 |
+            ((((pixel >> 16) & 0xFF) * l) >> 8) << 16 |
+            ((((pixel >> 24) & 0xFF) * l) >> 8) << 24) & rgb_mask;
+    }
+}
+
+void init_light_ramps (int depth)
+{
+    // only 15 and 16 bit colors use tables
+    if (depth == 15 && !ramps15.ready) make_ramps (&ramps15, 15);
+    if (depth == 16 && !ramps16.ready) make_ramps (&ramps16, 16);
+}
+
+void light_colors (int depth, int *colors, const int *light, int count)
+{
+    int i;
+
+    switch (depth)
+    {
+        case 15:
+            init_light_ramps (15);
+            light_ramps (&ramps15, colors, light, count);
+            break;
+        case 16:
+            init_light_ramps (16);
+            light_ramps (&ramps16, colors, light, count);
+            break;
+        case 24:
+        case 32:
+            light_bytes (colors, light, count,
+                makecol_depth (depth, 255, 255, 255));
+            break;
+        default:
+            // 8 bit colors depend on the palette, so we can't make
+            // the ramps in advance
+            for (i = 0; i < count; i++)
+            {
+                int l = CLAMP_LIGHT (light[i]);
+                colors[i] = makecol8 (
+                    (getr8 (colors[i]) * l) >> 8,
+                    (getg8 (colors[i]) * l) >> 8,
+                    (getb8 (colors[i]) * l) >> 8);
+            }
+            break;
+    }
+}
+
+void put_colors (BITMAP *bmp, int x, int y, const int *colors, int count)
+{
+    int i;
+
+    // putpixel doesn't draw outside the clipping rectangle,
+    // so neither do we
+    if (bmp->clip)
+    {
+        if (y < bmp->ct || y >= bmp->cb) return;
+        if (x < bmp->cl)
+        {
+            colors += bmp->cl - x;
+            count -= bmp->cl - x;
+            x = bmp->cl;
+        }
+        if (x + count > bmp->cr) count = bmp->cr - x;
+    }
+    if (count <= 0) return;
+
+    // direct access to line[] only works on memory bitmaps
+    if (!is_memory_bitmap (bmp))
+    {
+        for (i = 0; i < count; i++)
+            putpixel (bmp, x + i, y, colors[i]);
+        return;
+    }
+
+    switch (bitmap_color_depth (bmp))
+    {
+        case 8:
+        {
+            unsigned char *d = bmp->line[y] + x;
+            for (i = 0; i < count; i++)
+                d[i] = colors[i];
+            break;
+        }
+        case 15:
+        case 16:
+        {
+            uint16_t *d = (uint16_t *)bmp->line[y] + x;
+            for (i = 0; i < count; i++)
+                d[i] = colors[i];
+            break;
+        }
+        case 24:
+        {
+            // 24 bit pixels are 3 bytes, there is no type for that
+            unsigned char *d = bmp->line[y] + x * 3;
+            for (i = 0; i < count; i++)
+            {
+                d[0] = colors[i];
+                d[1] = colors[i] >> 8;
+                d[2] = colors[i] >> 16;
+                d += 3;
+            }
+            break;
+        }
+        case 32:
+        {
+            uint32_t *d = (uint32_t *)bmp->line[y] + x;
+            for (i = 0; i < count; i++)
+                d[i] = colors[i];
+            break;
+        }
+    }
+}
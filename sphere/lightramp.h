@@ -0,0 +1,39 @@
+/*
+   LIGHTRAMP.H
+   written by Martijn van Iersel (Amarillion)
+
+   lit_color() (SPHERE 5 and 6) looks up the color depth of the screen
+   for every pixel, takes the color apart, multiplies red, green and blue
+   by the light factor and puts the color together again.
+
+   light_colors() does the same for a whole line of pixels at once, so
+   it only has to look at the color depth once. For 15 and 16 bit
+   colors it looks the result up in tables with a "ramp" of 257 light
+   levels for each possible red, green and blue value. For 24 and 32
+   bit colors it uses SSE2 to multiply all channels of 4 pixels at once.
+   The result is exactly the same as that of lit_color().
+*/
+
+#ifndef LIGHTRAMP_H
+#define LIGHTRAMP_H
+
+#include <allegro.h>
+
+/* light_colors() sets colors[i] to lit_color (colors[i], light[i]),
+   for count colors in the given color depth.
+   A light factor goes from 0 (black) to 256 (full color). lit_color()
+   can't handle more than 256, light_colors() treats it as 256, and a
+   negative factor as 0. */
+void light_colors (int depth, int *colors, const int *light, int count);
+
+/* init_light_ramps() makes the tables light_colors() uses for depth.
+   light_colors() makes them itself the first time they are needed,
+   but that is not safe when several threads draw at once, so call
+   this before starting them. */
+void init_light_ramps (int depth);
+
+/* put_colors() draws count colors on line y of bmp, starting at x.
+   It writes directly to the bitmap memory when it can. */
+void put_colors (BITMAP *bmp, int x, int y, const int *colors, int count);
+
+#endif
@@ -0,0 +1,99 @@
+/*
+   LITSPHERE.C
+   written by Martijn van Iersel (Amarillion)
+
+   See litsphere.h
+*/
+
+#include <math.h>
+#include <allegro.h>
+#include "lightramp.h"
+#include "litsphere.h"
+
+int bitmap_sampler (void *map, int x, int y)
+{
+    return getpixel (map, x, y);
+}
+
+/*
+    This is mapped_sphere_ex() and lit_sphere() combined, see sphere3.c
+    and sphere4.c for more comments. Instead of calling lit_color() for
+    every pixel, it collects a piece of a line at a time and lights it
+    with light_colors() (see lightramp.h), which gives the same colors.
+*/
+void mapped_lit_sphere_lines (BITMAP *target, int cx, int cy, int r,
+    MAP_SAMPLER sampler, void *map, int map_w, int map_h,
+    MATRIX *rotmat, fixed longitude, fixed latitude, int y1, int y2)
+{
+    int x, y; // coordinates on target bitmap
+    int p, q; // coordinates on source bitmap
+    int colors[256], light[256]; // the pixels of a piece of a line
+    int depth = bitmap_color_depth (target);
+    int n, start;
+    
+    // calculate the light vector
+    fixed lightx, lighty, lightz;    
+    lightx = fixmul (fixsin (longitude), fixcos(latitude));
+    lighty = fixsin (latitude);
+    lightz = fixmul (fixcos (longitude), fixcos(latitude));
+
+    // only the lines that belong to the sphere
+    if (y1 < cy - r) y1 = cy - r;
+    if (y2 > cy + r) y2 = cy + r;
+
+    for (y = y1 - cy; y < y2 - cy; y++)
+    {
+        fixed q_cos = fixcos (- fixasin (itofix (y) / r)) * r;            
+        n = 0;
+        start = - fixtoi (q_cos) + 1;
+        for (x = start; x < fixtoi(q_cos) - 1; x++)
+        {
+             fixed lightf;
+             fixed temp_p, temp_q;
+             fixed newx, newy, newz;
+             fixed z = ftofix (sqrt((double)(r * r - x * x - y * y)));
+             
+             // rotate x, y and z             
+             // put the result in newx, newy and newz
+             apply_matrix (rotmat, itofix(x), itofix(y), z,
+                  &newx, &newy, &newz);
+
+             // see if we are near the poles
+             temp_q = - fixasin (newy / r);             
+             if (temp_q != 0)
+             {
+                // again, I chose to use fixatan2 instead of 
+                // temp_p = fixasin (newx)
+                // so we'll have less problems with rounding errors.
+                temp_p = fixatan2 (newx, newz);                
+             }
+             else
+                 temp_p = 0;
+             temp_p &= 0xFFFFFF;
+
+             q = fixtoi (-temp_q + itofix (64)) * (map_h-1) >> 7;
+             p = fixtoi (temp_p) * (map_w-1) >> 8;
+
+             lightf = dot_product (
+                 // normal of sphere surface
+                 itofix(x) / r, itofix(y) / r, z / r,
+                 // light source vector
+                 lightx, lighty, lightz
+             );
+             if (lightf < 0) lightf = 0;
+
+             colors[n] = sampler (map, p, q);
+             light[n] = fixtoi ((lightf << 8) - lightf);
+             n++;
+
+             // the piece is full, or this is the end of the line
+             if (n == 256 || x == fixtoi(q_cos) - 2)
+             {
+                 light_colors (depth, colors, light, n);
+                 put_colors (target, start + cx, y + cy, colors, n);
+                 start += n;
+                 n = 0;
+             }
+        }
+    }
+}
@@ -0,0 +1,37 @@
+/*
+   LITSPHERE.H
+   written by Martijn van Iersel (Amarillion)
+
+   mapped_lit_sphere() (SPHERE 5) takes its map from a BITMAP, but the
+   same sphere is also drawn from a tiled texture (see tiletex.h).
+   mapped_lit_sphere_lines() is the drawing of all of them, written
+   once. The pixels of the map come from a sampler function, so it
+   doesn't matter where the map is kept.
+
+   The map is looked up with whole angles, like in the original
+   mapped_lit_sphere(): 256 steps around the sphere and 128 from pole
+   to pole. However large the map is, at most 256 x 128 of its pixels
+   are ever used.
+*/
+
+#ifndef LITSPHERE_H
+#define LITSPHERE_H
+
+#include <allegro.h>
+
+/* A sampler returns the color of pixel (x, y) of map, in the color
+   depth of the target, like getpixel() does for a BITMAP. */
+typedef int (*MAP_SAMPLER) (void *map, int x, int y);
+
+// bitmap_sampler() is getpixel() as a MAP_SAMPLER, map is a BITMAP
+int bitmap_sampler (void *map, int x, int y);
+
+/* mapped_lit_sphere_lines() draws the lines y1 up to y2 of target that
+   belong to the sphere, with the result of mapped_lit_sphere().
+   The pixels of the map come from sampler (map, x, y), map_w and map_h
+   are the size of the map. Pass cy - r and cy + r for the whole sphere. */
+void mapped_lit_sphere_lines (BITMAP *target, int cx, int cy, int r,
+    MAP_SAMPLER sampler, void *map, int map_w, int map_h,
+    MATRIX *rotmat, fixed longitude, fixed latitude, int y1, int y2);
+
+#endif
@@ -0,0 +1,92 @@
+/*
+   MIPMAP.C
+   written by Martijn van Iersel (Amarillion)
+
+   See mipmap.h
+*/
+
+#include <stdlib.h>
+#include <allegro.h>
+#include "mipmap.h"
+
+/*
+    half_bitmap() returns a copy of src, half as wide and high. Each pixel
+    is the average of the 2x2 pixels it comes from. When src is an odd
+    number of pixels wide or high, the last column or line is left out.
+*/
+static BITMAP *half_bitmap (BITMAP *src)
+{
+    int depth = bitmap_color_depth (src);
+    int w = src->w / 2, h = src->h / 2;
+    BITMAP *dest = create_bitmap_ex (depth, w, h);
+    int x, y, i;
+
+    if (!dest) return NULL;
+    for (y = 0; y < h; y++)
+    {
+        for (x = 0; x < w; x++)
+        {
+            int c[4], r = 0, g = 0, b = 0;
+            c[0] = getpixel (src, 2 * x, 2 * y);
+            if (depth == 8)
+            {
+                // palette indices can't be averaged
+                putpixel (dest, x, y, c[0]);
+                continue;
+            }
+            c[1] = getpixel (src, 2 * x + 1, 2 * y);
+            c[2] = getpixel (src, 2 * x, 2 * y + 1);
+            c[3] = getpixel (src, 2 * x + 1, 2 * y + 1);
+            for (i = 0; i < 4; i++)
+            {
+                r += getr_depth (depth, c[i]);
+                g += getg_depth (depth, c[i]);
+                b += getb_depth (depth, c[i]);
+            }
+            // + 2 to round to the nearest value
+            putpixel (dest, x, y, makecol_depth (depth,
+                (r + 2) >> 2, (g + 2) >> 2, (b + 2) >> 2));
+        }
+    }
+    return dest;
+}
+
+MIPMAP *create_mipmap (BITMAP *map)
+{
+    MIPMAP *mip = malloc (sizeof (MIPMAP));
+    BITMAP *level = map;
+
+    if (!mip) return NULL;
+    mip->count = 1;
+    mip->levels[0] = map;
+    while (level->w >= 2 && level->h >= 2 && mip->count < MAX_MIPMAP_LEVELS)
+    {
+        level = half_bitmap (level);
+        if (!level)
+        {
+            destroy_mipmap (mip);
+            return NULL;
+        }
+        mip->levels[mip->count++] = level;
+    }
+    return mip;
+}
+
+void destroy_mipmap (MIPMAP *mip)
+{
+    int i;
+    // level 0 belongs to the caller
+    for (i = 1; i < mip->count; i++)
+        destroy_bitmap (mip->levels[i]);
+    free (mip);
+}
+
+BITMAP *get_mipmap_level (MIPMAP *mip, int r)
+{
+    // the equator of the sphere is 2 * PI * r pixels around
+    int needed = r * 44 / 7;
+    int i = 0;
+    while (i + 1 < mip->count && mip->levels[i + 1]->w >= needed)
+        i++;
+    return mip->levels[i];
+}
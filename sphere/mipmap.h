@@ -0,0 +1,47 @@
+/*
+   MIPMAP.H
+   written by Martijn van Iersel (Amarillion)
+
+   A small sphere only shows a few pixels of the map, but mapped_sphere()
+   and friends still pick them from the full map. Neighbouring pixels
+   of the sphere then come from far apart on the map, which is slow when
+   the map is large, and looks noisy because most of the map is skipped.
+
+   A mipmap is the map together with smaller copies of itself, each
+   half the size of the one before, so that each pixel of a copy is the
+   average of four pixels of the one before. get_mipmap_level() picks
+   the copy that suits a sphere of a certain radius, and that copy is
+   passed to the drawing functions instead of the map itself.
+*/
+
+#ifndef MIPMAP_H
+#define MIPMAP_H
+
+#include <allegro.h>
+
+#define MAX_MIPMAP_LEVELS 32
+
+typedef struct MIPMAP
+{
+    int count; // number of levels
+    // level 0 is the map itself, each next one is half as wide and high
+    BITMAP *levels[MAX_MIPMAP_LEVELS];
+} MIPMAP;
+
+/* create_mipmap() makes the smaller copies of map, down to 1 pixel
+   wide or high. The copies have the color depth of map. In 8 bit
+   colors can't be averaged, so there every fourth pixel is used.
+   map itself is not copied, it must stay around as long as the mipmap.
+   returns NULL if there is not enough memory. */
+MIPMAP *create_mipmap (BITMAP *map);
+
+// destroys the copies, but not the map itself
+void destroy_mipmap (MIPMAP *mip);
+
+/* get_mipmap_level() returns the smallest level that still has at least
+   one column for every pixel around the equator of a sphere of radius r.
+   Near the middle of the sphere that is one pixel of the map for each
+   pixel on the screen. */
+BITMAP *get_mipmap_level (MIPMAP *mip, int r);
+
+#endif
@@ -0,0 +1,72 @@
+/*
+   PLANETS.C
+   written by Martijn van Iersel (Amarillion)
+
+   See planets.h
+*/
+
+#include <allegro.h>
+#include "lightramp.h"
+#include "litsphere.h"
+#include "planets.h"
+
+typedef struct PLANET_JOB
+{
+    BITMAP *target;
+    const PLANET *planets;
+    int count;
+    int top; // the first line of the first band
+} PLANET_JOB;
+
+// draws one band of the target, called by the workers
+static void draw_band (void *data, int index)
+{
+    PLANET_JOB *job = data;
+    int y1 = job->top + index * PLANET_BAND;
+    int y2 = y1 + PLANET_BAND;
+    int i;
+
+    for (i = 0; i < job->count; i++)
+    {
+        const PLANET *planet = &job->planets[i];
+        if (planet->r <= 0) continue;
+        // skip the planets that are not in this band
+        if (planet->cy + planet->r <= y1 || planet->cy - planet->r >= y2)
+            continue;
+        mapped_lit_sphere_lines (job->target, planet->cx, planet->cy,
+            planet->r, bitmap_sampler, planet->map, planet->map->w,
+            planet->map->h, (MATRIX *)&planet->rotmat, planet->longitude,
+            planet->latitude, y1, y2);
+    }
+}
+
+void draw_planets (BITMAP *target, const PLANET *planets, int count,
+    WORKER_POOL *pool)
+{
+    PLANET_JOB job;
+    int top = 0, bottom = target->h;
+    int i, bands;
+
+    // nothing is drawn outside the clipping rectangle,
+    // so we don't need bands there
+    if (target->clip)
+    {
+        top = target->ct;
+        bottom = target->cb;
+    }
+    if (bottom <= top) return;
+    bands = (bottom - top + PLANET_BAND - 1) / PLANET_BAND;
+
+    // before the workers all try to make the tables at once
+    init_light_ramps (bitmap_color_depth (target));
+
+    job.target = target;
+    job.planets = planets;
+    job.count = count;
+    job.top = top;
+    if (pool)
+        run_workers (pool, draw_band, &job, bands);
+    else
+        for (i = 0; i < bands; i++)
+            draw_band (&job, i);
+}
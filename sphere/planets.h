@@ -0,0 +1,42 @@
+/*
+   PLANETS.H
+   written by Martijn van Iersel (Amarillion)
+
+   A star map can show hundreds of planets at once. draw_planets() draws
+   a whole list of them with the threads of a worker pool (see
+   ../common/workers.h).
+
+   The target is cut into bands of PLANET_BAND lines, and each band is a
+   separate job. A worker draws the lines of every planet that falls in
+   its band. So a large planet is spread over many workers, and small
+   ones don't have to wait for it. Because each band is drawn by a
+   single worker, in the order of the list, planets that overlap look
+   exactly the same as when they are drawn one after another.
+*/
+
+#ifndef PLANETS_H
+#define PLANETS_H
+
+#include <allegro.h>
+#include "../common/workers.h"
+
+#define PLANET_BAND 16
+
+typedef struct PLANET
+{
+    int cx, cy, r; // center and radius on the target
+    BITMAP *map; // bitmap to map onto the sphere
+    MATRIX rotmat; // rotation of the sphere
+    // position of the light source, as in mapped_lit_sphere() (SPHERE 5)
+    fixed longitude, latitude;
+} PLANET;
+
+/* draw_planets() draws count planets onto target, with the same result
+   as calling mapped_lit_sphere() (SPHERE 5) for each of them.
+   Later planets are drawn over earlier ones.
+   target must be a memory bitmap if pool has more than one thread.
+   pool may be NULL, then everything is drawn by the calling thread. */
+void draw_planets (BITMAP *target, const PLANET *planets, int count,
+    WORKER_POOL *pool);
+
+#endif
@@ -0,0 +1,94 @@
+/*
+   FIXED, FLOAT OR DOUBLE BENCHMARK
+   written by Martijn van Iersel (Amarillion)
+
+   This program measures the fixed, float and double versions of
+   mapped_sphere_ex and mapped_lit_sphere (see spherereal.c) like
+   spherebench does. Then it compares the pictures they draw with those
+   of the double versions, to show how much accuracy fixed and float
+   numbers lose. See ../common/bench.h for the command line options.
+
+   mapped_sphere_ex_fixed can't draw spheres with a radius over 181
+   (see spherevec.h), so keep the bitmap smaller than 364 x 364 to
+   compare it.
+*/
+
+#include <stdio.h>
+#include <allegro.h>
+#include "../common/bench.h"
+#include "spherereal.h"
+
+// the radius of a sphere that just fits on the bitmap
+int bench_radius (BITMAP *bmp)
+{
+    return (bmp->w < bmp->h ? bmp->w : bmp->h) / 2 - 1;
+}
+
+// the same rotation as get_planet_rotation_matrix () in sphere3.c
+void bench_rotation (MATRIX *m, int frame)
+{
+    MATRIX m1, m2;
+    get_y_rotate_matrix (&m1, itofix (frame + 10));
+    get_rotation_matrix (&m2, itofix (16), 0, 0);
+    matrix_mul (&m2, &m1, m);
+}
+
+// BENCH_REAL_KERNELS() writes the bench kernels for one kind of number
+#define BENCH_REAL_KERNELS(kind) \
+void bench_mapped_sphere_ex_##kind (BITMAP *bmp, int frame, void *map) \
+{ \
+    MATRIX m; \
+    bench_rotation (&m, frame); \
+    mapped_sphere_ex_##kind (bmp, bmp->w / 2, bmp->h / 2, \
+        bench_radius (bmp), map, &m); \
+} \
+void bench_mapped_lit_sphere_##kind (BITMAP *bmp, int frame, void *map) \
+{ \
+    MATRIX m; \
+    bench_rotation (&m, frame); \
+    mapped_lit_sphere_##kind (bmp, bmp->w / 2, bmp->h / 2, \
+        bench_radius (bmp), map, &m, itofix (64), itofix (32)); \
+}
+
+BENCH_REAL_KERNELS (fixed)
+BENCH_REAL_KERNELS (float)
+BENCH_REAL_KERNELS (double)
+
+int main(int argc, char *argv[])
+{
+    PALETTE pal;
+    BITMAP *map;
+
+    if (bench_init (argc, argv) != 0)
+    {
+        allegro_message ("Error: Could not initialize the benchmark");
+        return -1;
+    }
+    map = load_bitmap ("earth.bmp", pal);
+    if (!map)
+    {
+        allegro_message ("Error: Could not load earth.bmp");
+        return -1;
+    }
+
+    bench_kernel ("mapped_sphere_ex_fixed", bench_mapped_sphere_ex_fixed, map);
+    bench_kernel ("mapped_sphere_ex_float", bench_mapped_sphere_ex_float, map);
+    bench_kernel ("mapped_sphere_ex_double", bench_mapped_sphere_ex_double, map);
+    bench_kernel ("mapped_lit_sphere_fixed", bench_mapped_lit_sphere_fixed, map);
+    bench_kernel ("mapped_lit_sphere_float", bench_mapped_lit_sphere_float, map);
+    bench_kernel ("mapped_lit_sphere_double", bench_mapped_lit_sphere_double, map);
+
+    bench_accuracy ("mapped_sphere_ex_fixed", bench_mapped_sphere_ex_fixed,
+        "mapped_sphere_ex_double", bench_mapped_sphere_ex_double, map);
+    bench_accuracy ("mapped_sphere_ex_float", bench_mapped_sphere_ex_float,
+        "mapped_sphere_ex_double", bench_mapped_sphere_ex_double, map);
+    bench_accuracy ("mapped_lit_sphere_fixed", bench_mapped_lit_sphere_fixed,
+        "mapped_lit_sphere_double", bench_mapped_lit_sphere_double, map);
+    bench_accuracy ("mapped_lit_sphere_float", bench_mapped_lit_sphere_float,
+        "mapped_lit_sphere_double", bench_mapped_lit_sphere_double, map);
+
+    destroy_bitmap (map);
+    bench_exit ();
+    return 0;
+
+} END_OF_MAIN();
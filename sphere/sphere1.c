@@ -10,34 +10,42 @@
 */
 
 #include <allegro.h>
+#include "../common/headless.h"
+
+// spherebench.c includes this file with KERNELS_ONLY defined,
+// it only needs the drawing functions
+#ifndef KERNELS_ONLY
 
 /*
    The function init() initializes allegro and the graphics mode.
+   argc and argv are passed on for the headless mode (see headless.h)
    returns 0 on success.
 */
-int init()
+int init(int argc, char *argv[])
 {
     // list of color depths we are going to try:
     int color_depths[] = {32, 24, 16, 15, 0};
     int i, bpp;
 
-    allegro_init();
+    if (headless_init (argc, argv) != 0) return -1;
     i = 0;
     // try a couple of different color depths
     // keep on trying until bpp reaches 0
     while (bpp = color_depths[i])
     {
         set_color_depth (bpp);
-        if (set_gfx_mode (GFX_AUTODETECT, 640, 480, 0, 0) == 0)
+        if (headless_set_gfx_mode (GFX_AUTODETECT, 640, 480, 0, 0) == 0)
             break;
     }
     // if bpp reached 0, it means we failed finding a suitable color depth
     if (bpp == 0) return -1;
-    if (install_keyboard() != 0) return -1;
-    if (install_timer() != 0) return -1;
+    if (headless_install_keyboard() != 0) return -1;
+    if (headless_install_timer() != 0) return -1;
     return 0;
 }
 
+#endif
+
 /*
    mapped_cylinder() maps a bitmap onto a cylinder.
    
@@ -93,9 +101,11 @@ void mapped_cylinder (BITMAP *target, int cx, int top, int r, int h, BITMAP *map
     }
 }
 
-int main(void)
+#ifndef KERNELS_ONLY
+
+int main(int argc, char *argv[])
 {
-    if (init() == 0)
+    if (init(argc, argv) == 0)
     {
         PALETTE pal;
         
@@ -113,6 +123,7 @@ int main(void)
             SCREEN_W / 2, 10, 100 * SCREEN_W / 320, SCREEN_H - 20, map);
 
         blit (buffer, screen, 0, 0, 0, 0, SCREEN_W, SCREEN_H);
+        headless_still ();
         
         // wait until we press ESC
         while (!key[KEY_ESC]) {}
@@ -123,3 +134,5 @@ int main(void)
     return 0;
 
 } END_OF_MAIN();
+
+#endif
@@ -10,34 +10,43 @@
 */
 
 #include <allegro.h>
+#include "spheretab.h"
+#include "../common/headless.h"
+
+// spherebench.c includes this file with KERNELS_ONLY defined,
+// it only needs the drawing functions
+#ifndef KERNELS_ONLY
 
 /*
    The function init() initializes allegro and the graphics mode.
+   argc and argv are passed on for the headless mode (see headless.h)
    returns 0 on success.
 */
-int init()
+int init(int argc, char *argv[])
 {
     // list of color depths we are going to try:
     int color_depths[] = {32, 24, 16, 15, 0};
     int i, bpp;
 
-    allegro_init();
+    if (headless_init (argc, argv) != 0) return -1;
     i = 0;
     // try a couple of different color depths
     // keep on trying until bpp reaches 0
     while (bpp = color_depths[i])
     {
         set_color_depth (bpp);
-        if (set_gfx_mode (GFX_AUTODETECT, 640, 480, 0, 0) == 0)
+        if (headless_set_gfx_mode (GFX_AUTODETECT, 640, 480, 0, 0) == 0)
             break;
     }
     // if bpp reached 0, it means we failed finding a suitable color depth
     if (bpp == 0) return -1;
-    if (install_keyboard() != 0) return -1;
-    if (install_timer() != 0) return -1;
+    if (headless_install_keyboard() != 0) return -1;
+    if (headless_install_timer() != 0) return -1;
     return 0;
 }
 
+#endif
+
 /*
     mapped_sphere() maps a bitmap onto a sphere and displays it.
     
@@ -103,9 +112,27 @@ void mapped_sphere (BITMAP *target, int cx, int cy, int r, BITMAP *map)
     }
 }
 
-int main(void)
+/*
+    mapped_sphere_cached() draws exactly the same as mapped_sphere(), but
+    the map position of each pixel comes from a SPHERE_TABLE (see
+    spheretab.h). The first time a radius is drawn the table is
+    calculated, after that drawing the sphere is only copying pixels.
+*/
+void mapped_sphere_cached (BITMAP *target, int cx, int cy, int r, BITMAP *map)
 {
-    if (init() == 0)
+    SPHERE_TABLE *table = get_sphere_table (r, map->w, map->h);
+    if (table)
+        draw_sphere_table (target, cx, cy, table, map, 0);
+    else if (r > 0)
+        // not enough memory for the table
+        mapped_sphere (target, cx, cy, r, map);
+}
+
+#ifndef KERNELS_ONLY
+
+int main(int argc, char *argv[])
+{
+    if (init(argc, argv) == 0)
     {
         PALETTE pal;
         BITMAP *map = load_bitmap ("earth.bmp", pal);
@@ -117,6 +144,7 @@ int main(void)
             SCREEN_W / 2, SCREEN_H / 2, 110 * SCREEN_H / 240, map);
         
         blit (buffer, screen, 0, 0, 0, 0, SCREEN_W, SCREEN_H);
+        headless_still ();
         
         // wait until we press ESC
         while (!key[KEY_ESC]) {}
@@ -127,3 +155,5 @@ int main(void)
     return 0;
 
 } END_OF_MAIN();
+
+#endif
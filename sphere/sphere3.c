@@ -10,34 +10,44 @@
 */
 
 #include <allegro.h>
+#include "spheretab.h"
+#include "mipmap.h"
+#include "../common/headless.h"
+
+// spherebench.c includes this file with KERNELS_ONLY defined,
+// it only needs the drawing functions
+#ifndef KERNELS_ONLY
 
 /*
    The function init() initializes allegro and the graphics mode.
+   argc and argv are passed on for the headless mode (see headless.h)
    returns 0 on success.
 */
-int init()
+int init(int argc, char *argv[])
 {
     // list of color depths we are going to try:
     int color_depths[] = {32, 24, 16, 15, 0};
     int i, bpp;
 
-    allegro_init();
+    if (headless_init (argc, argv) != 0) return -1;
     i = 0;
     // try a couple of different color depths
     // keep on trying until bpp reaches 0
     while (bpp = color_depths[i])
     {
         set_color_depth (bpp);
-        if (set_gfx_mode (GFX_AUTODETECT, 640, 480, 0, 0) == 0)
+        if (headless_set_gfx_mode (GFX_AUTODETECT, 640, 480, 0, 0) == 0)
             break;
     }
     // if bpp reached 0, it means we failed finding a suitable color depth
     if (bpp == 0) return -1;
-    if (install_keyboard() != 0) return -1;
-    if (install_timer() != 0) return -1;
+    if (headless_install_keyboard() != 0) return -1;
+    if (headless_install_timer() != 0) return -1;
     return 0;
 }
 
+#endif
+
 
 /*
 get_planet_rotation_matrix() is a little helper function to calculate a 
@@ -94,6 +104,10 @@ void mapped_sphere_ex (BITMAP *target, int cx, int cy, int r, BITMAP *map,
              apply_matrix (rotmat, itofix(x), itofix(y), z,
                  &newx, &newy, &newz);
 
+             // calculate q first, we need temp_q for p as well
+             temp_q = fixasin (newy / r);
+             q = fixtoi (temp_q + itofix (64)) * (map->h-1) / 128;
+
              //just as in sphere2.c, we need to check if q_cos is 0
              //however, q_cos depends on y, and we just calculated a new y
              //thus we have to calculate q_cos again.
@@ -111,10 +125,6 @@ void mapped_sphere_ex (BITMAP *target, int cx, int cy, int r, BITMAP *map,
              temp_p &= 0xFFFFFF;
 
              p = fixtoi (temp_p) * (map->w-1) / 256;
-
-             // calculate q
-             temp_q = fixasin (newy / r);             
-             q = fixtoi (temp_q + itofix (64)) * (map->h-1) / 128;
              
              putpixel (target, x + cx, y + cy,
                  getpixel (map, p, q)
@@ -124,9 +134,54 @@ void mapped_sphere_ex (BITMAP *target, int cx, int cy, int r, BITMAP *map,
 }
 
 
-int main(void)
+/*
+    get_spin_angle() checks if rotmat only turns the planet around its own
+    axis, like get_planet_rotation_matrix (&m, rotation, 0, 0) does. If so
+    it sets *angle to the rotation and returns TRUE.
+*/
+int get_spin_angle (MATRIX *rotmat, fixed *angle)
+{
+    if (rotmat->v[1][1] != itofix (1) ||
+        rotmat->v[0][1] != 0 || rotmat->v[1][0] != 0 ||
+        rotmat->v[1][2] != 0 || rotmat->v[2][1] != 0 ||
+        rotmat->v[0][0] != rotmat->v[2][2] ||
+        rotmat->v[0][2] != -rotmat->v[2][0] ||
+        rotmat->t[0] != 0 || rotmat->t[1] != 0 || rotmat->t[2] != 0)
+        return FALSE;
+    *angle = fixatan2 (rotmat->v[0][2], rotmat->v[0][0]);
+    return TRUE;
+}
+
+/*
+    mapped_sphere_ex_fast() draws nearly the same planet as
+    mapped_sphere_ex(). If the planet only spins around its own axis, every pixel just moves
+    to another column of the map, and all lines move by the same amount.
+    Then we take the unrotated sphere from a SPHERE_TABLE (see spheretab.h)
+    and only add an offset to the columns. A tilted planet still needs
+    mapped_sphere_ex().
+    The table rounds the map coordinates in other places than
+    mapped_sphere_ex() does, so a spinning planet may take a pixel up to
+    two columns or lines away on the map. make check tests that.
+*/
+void mapped_sphere_ex_fast (BITMAP *target, int cx, int cy, int r, BITMAP *map,
+    MATRIX *rotmat)
+{
+    SPHERE_TABLE *table;
+    fixed angle;
+
+    if (get_spin_angle (rotmat, &angle) &&
+        (table = get_sphere_table (r, map->w, map->h)) != NULL)
+        draw_sphere_table (target, cx, cy, table, map,
+            sphere_spin_offset (angle, map->w));
+    else
+        mapped_sphere_ex (target, cx, cy, r, map, rotmat);
+}
+
+#ifndef KERNELS_ONLY
+
+int main(int argc, char *argv[])
 {
-    if (init() == 0)
+    if (init(argc, argv) == 0)
     {
         PALETTE pal;
         BITMAP *map = load_bitmap ("earth.bmp", pal);
@@ -136,6 +191,11 @@ int main(void)
         int xgrid = SCREEN_W / 8;
         int ygrid = SCREEN_H / 6;
         int radius = (xgrid > ygrid ? ygrid : xgrid) / 2 - 2;
+        MIPMAP *mip;
+        BITMAP *small; // the level of the mipmap that suits the radius
+        // the spheres are small, so they don't need the whole map
+        mip = create_mipmap (map);
+        small = get_mipmap_level (mip, radius);
         clear_bitmap (buffer);        
         for (i = 0; i < 8; i ++)
         {
@@ -144,32 +204,36 @@ int main(void)
             // the first two rows are rotated around the earth's rotation axis
             get_planet_rotation_matrix (&m, i * itofix (16), 0, 0);
             mapped_sphere_ex (buffer,
-                (1 + 2 * i) * xgrid / 2, ygrid / 2, radius, map, &m);
+                (1 + 2 * i) * xgrid / 2, ygrid / 2, radius, small, &m);
             get_planet_rotation_matrix (&m, (8 + i) * itofix (16), 0, 0);
             mapped_sphere_ex (buffer,
-                (1 + 2 * i) * xgrid / 2, 3 * ygrid / 2, radius, map, &m);
+                (1 + 2 * i) * xgrid / 2, 3 * ygrid / 2, radius, small, &m);
                 
             // the third and fourth rows are rotated around the x axis
             get_planet_rotation_matrix (&m, 0, i * itofix (16), 0);
             mapped_sphere_ex (buffer,
-                (1 + 2 * i) * xgrid / 2, 5 * ygrid / 2, radius, map, &m);
+                (1 + 2 * i) * xgrid / 2, 5 * ygrid / 2, radius, small, &m);
             get_planet_rotation_matrix (&m, 0, (8 + i) * itofix (16), 0);
             mapped_sphere_ex (buffer,
-                (1 + 2 * i) * xgrid / 2, 7 * ygrid / 2, radius, map, &m);
+                (1 + 2 * i) * xgrid / 2, 7 * ygrid / 2, radius, small, &m);
                 
             // the 5th and 6th rows are rotated around the z axis
             get_planet_rotation_matrix (&m, 0, 0, i * itofix (16));
             mapped_sphere_ex (buffer,
-                (1 + 2 * i) * xgrid / 2, 9 * ygrid / 2, radius, map, &m);
+                (1 + 2 * i) * xgrid / 2, 9 * ygrid / 2, radius, small, &m);
             get_planet_rotation_matrix (&m, 0, 0, (8 + i) * itofix (16));
             mapped_sphere_ex (buffer,
-                (1 + 2 * i) * xgrid / 2, 11 * ygrid / 2, radius, map, &m);
+                (1 + 2 * i) * xgrid / 2, 11 * ygrid / 2, radius, small, &m);
         }
         blit (buffer, screen, 0, 0, 0, 0, SCREEN_W, SCREEN_H);
+        headless_still ();
         while (!key[KEY_ESC]) {}
+        destroy_mipmap (mip);
         destroy_bitmap (map);
         destroy_bitmap (buffer);
     }
     return 0;
 
 } END_OF_MAIN();
+
+#endif
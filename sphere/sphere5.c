@@ -11,34 +11,46 @@
 
 #include <allegro.h>
 #include <math.h>
+#include "lightramp.h"
+#include "litsphere.h"
+#include "tiletex.h"
+#include "mipmap.h"
+#include "../common/headless.h"
+
+// spherebench.c includes this file with KERNELS_ONLY defined,
+// it only needs the drawing functions
+#ifndef KERNELS_ONLY
 
 /*
    The function init() initializes allegro and the graphics mode.
+   argc and argv are passed on for the headless mode (see headless.h)
    returns 0 on success.
 */
-int init()
+int init(int argc, char *argv[])
 {
     // list of color depths we are going to try:
     int color_depths[] = {32, 24, 16, 15, 0};
     int i, bpp;
 
-    allegro_init();
+    if (headless_init (argc, argv) != 0) return -1;
     i = 0;
     // try a couple of different color depths
     // keep on trying until bpp reaches 0
     while (bpp = color_depths[i])
     {
         set_color_depth (bpp);
-        if (set_gfx_mode (GFX_AUTODETECT, 640, 480, 0, 0) == 0)
+        if (headless_set_gfx_mode (GFX_AUTODETECT, 640, 480, 0, 0) == 0)
             break;
     }
     // if bpp reached 0, it means we failed finding a suitable color depth
     if (bpp == 0) return -1;
-    if (install_keyboard() != 0) return -1;
-    if (install_timer() != 0) return -1;
+    if (headless_install_keyboard() != 0) return -1;
+    if (headless_install_timer() != 0) return -1;
     return 0;
 }
 
+#endif
+
 /*
     lit_color is a colordepth independant function to 
     adjust the lighting of a certain pixel
@@ -47,6 +59,9 @@ int init()
         (8, 15, 16, 24 or 32 bit)
     light = light factor from 0 to 255
     returns the adjusted color in 8, 15, 15, 24 or 32 bit format
+
+    mapped_lit_sphere() doesn't call it anymore, but spherebench checks
+    the light ramps against it.
 */
 int lit_color (int color, int light)
 {
@@ -96,8 +111,12 @@ void get_planet_rotation_matrix (MATRIX *m, fixed rotation, fixed axisx, fixed a
 
 /*
 mapped_lit_sphere() maps a bitmap onto a sphere and applies lighting at the same time
-This is essentially mapped_sphere_ex() and lit_sphere() combined. Look at 
-those functions for more comments.
+This is essentially mapped_sphere_ex() and lit_sphere() combined. The
+drawing itself is done by mapped_lit_sphere_lines() (see litsphere.c), so
+that it can also take the map from somewhere else than a bitmap.
+Instead of calling lit_color() for every pixel, it lights a piece of a
+line at a time with light_colors() (see lightramp.h), which gives the same
+colors. The colors are lit for the color depth of target, not of the screen.
 
 BITMAP *target = the bitmap to draw onto
 int cx, cy = center of the sphere
@@ -110,96 +129,86 @@ fixed longitude, latitude = position of the light source, as if it were right ab
 void mapped_lit_sphere (BITMAP *target, int cx, int cy, int r, BITMAP *map,
     MATRIX *rotmat, fixed longitude, fixed latitude)
 {
-    int x, y; // coordinates on target bitmap
-    int p, q; // coordinates on source bitmap
-    
-    // calculate the light vector
-    fixed lightx, lighty, lightz;    
-    lightx = fixmul (fixsin (longitude), fixcos(latitude));
-    lighty = fixsin (latitude);
-    lightz = fixmul (fixcos (longitude), fixcos(latitude));
+    mapped_lit_sphere_lines (target, cx, cy, r, bitmap_sampler, map,
+        map->w, map->h, rotmat, longitude, latitude, cy - r, cy + r);
+}
 
-    for (y = -r; y < r; y++)
-    {
-        fixed q_cos = fixcos (- fixasin (itofix (y) / r)) * r;            
-        for (x = - fixtoi (q_cos) + 1; x < fixtoi(q_cos) - 1; x++)
-        {
-             fixed light;
-             int lighti, color;
-             fixed temp_p, temp_q;
-             fixed newx, newy, newz;
-             fixed z = ftofix (sqrt((double)(r * r - x * x - y * y)));
-             
-             // rotate x, y and z             
-             // put the result in newx, newy and newz
-             apply_matrix (rotmat, itofix(x), itofix(y), z,
-                  &newx, &newy, &newz);
-
-             // see if we are near the poles
-             temp_q = - fixasin (newy / r);             
-             if (temp_q != 0)
-             {
-                // again, I chose to use fixatan2 instead of 
-                // temp_p = fixasin (newx)
-                // so we'll have less problems with rounding errors.
-                temp_p = fixatan2 (newx, newz);                
-             }
-             else
-                 temp_p = 0;
-             temp_p &= 0xFFFFFF;
-
-             
-             q = fixtoi (-temp_q + itofix (64)) * (map->h-1) >> 7;
-             
-             temp_q = fixcos (temp_q) * r + itofix (1);
-             
-             p = fixtoi (temp_p) * (map->w-1) >> 8;
-
-             light = dot_product (
-                 // normal of sphere surface
-                 itofix(x) / r, itofix(y) / r, z / r,
-                 // light source vector
-                 lightx, lighty, lightz
-             );
-
-             if (light < 0) light = 0;
-
-             //lighti = fixtoi (light * 255);
-             lighti = fixtoi ((light << 8) - light);
-             color = getpixel (map, p, q);
-             putpixel (target, x + cx, y + cy, lit_color (color, lighti));
-        }
-    }
+// tiled_getpixel() as a MAP_SAMPLER (see litsphere.h)
+static int tiled_sampler (void *map, int x, int y)
+{
+    return tiled_getpixel (map, x, y);
 }
 
+/*
+mapped_lit_sphere_tiled() draws the same as mapped_lit_sphere(), but
+takes the pixels from a tiled texture (see tiletex.h) instead of a bitmap.
+Only the tiles that are on the visible side of the sphere are read.
+The texture must have the color depth of target.
+*/
+void mapped_lit_sphere_tiled (BITMAP *target, int cx, int cy, int r,
+    TILED_TEXTURE *map, MATRIX *rotmat, fixed longitude, fixed latitude)
+{
+    mapped_lit_sphere_lines (target, cx, cy, r, tiled_sampler, map,
+        map->w, map->h, rotmat, longitude, latitude, cy - r, cy + r);
+}
+
+#ifndef KERNELS_ONLY
 
-int main(void)
+int main(int argc, char *argv[])
 {
-    if (init() == 0)
+    if (init(argc, argv) == 0)
     {
         PALETTE pal;
-        BITMAP *map = load_bitmap ("earth.bmp", pal);
+        BITMAP *map = NULL;
+        TILED_TEXTURE *tex = NULL;
         BITMAP *buffer = create_bitmap (SCREEN_W, SCREEN_H);
         MATRIX m;
         int i, j;
         int xgrid = SCREEN_W / 4;
         int ygrid = SCREEN_H / 3;
         int radius = (xgrid > ygrid ? ygrid : xgrid) / 2 - 2;
+        MIPMAP *mip = NULL;
+        BITMAP *small = NULL; // the level of the mipmap that suits the radius
+        // use the tiled version of the map if there is one (see tiletex.h),
+        // it's made with: bmp2tex earth.bmp earth.tex
+        if (exists ("earth.tex"))
+            tex = open_tiled_texture ("earth.tex", bitmap_color_depth (buffer), 256);
+        if (!tex)
+        {
+            // the spheres are small, so they don't need the whole map
+            map = load_bitmap ("earth.bmp", pal);
+            mip = create_mipmap (map);
+            small = get_mipmap_level (mip, radius);
+        }
         clear_bitmap (buffer);        
         for (i = 0; i < 4; i ++)
             for (j = 0; j < 3; j ++)
             {
                 get_planet_rotation_matrix (&m, (j * 4 + i) * itofix (16), 0, 0);
-                mapped_lit_sphere (buffer,
-                    (2 * i + 1) * xgrid / 2,
-                    (2 * j + 1) * ygrid / 2,
-                    radius, map, &m, i * itofix (32), (j + 1) * itofix (16));
+                if (tex)
+                    mapped_lit_sphere_tiled (buffer,
+                        (2 * i + 1) * xgrid / 2,
+                        (2 * j + 1) * ygrid / 2,
+                        radius, tex, &m, i * itofix (32), (j + 1) * itofix (16));
+                else
+                    mapped_lit_sphere (buffer,
+                        (2 * i + 1) * xgrid / 2,
+                        (2 * j + 1) * ygrid / 2,
+                        radius, small, &m, i * itofix (32), (j + 1) * itofix (16));
             }
         blit (buffer, screen, 0, 0, 0, 0, SCREEN_W, SCREEN_H);
+        headless_still ();
         while (!key[KEY_ESC]) {}
-        destroy_bitmap (map);
+        if (tex) close_tiled_texture (tex);
+        else
+        {
+            destroy_mipmap (mip);
+            destroy_bitmap (map);
+        }
         destroy_bitmap (buffer);
     }
     return 0;
 
 } END_OF_MAIN();
+
+#endif
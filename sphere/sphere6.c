@@ -9,36 +9,47 @@
    your pals sin & cos"
 */
 
+#include <stdlib.h>
+#include <string.h>
 #include <allegro.h>
+#include "lightramp.h"
+#include "../common/headless.h"
 
 
+// spherebench.c includes this file with KERNELS_ONLY defined,
+// it only needs the drawing functions
+#ifndef KERNELS_ONLY
+
 /*
    The function init() initializes allegro and the graphics mode.
+   argc and argv are passed on for the headless mode (see headless.h)
    returns 0 on success.
 */
-int init()
+int init(int argc, char *argv[])
 {
     // list of color depths we are going to try:
     int color_depths[] = {32, 24, 16, 15, 0};
     int i, bpp;
 
-    allegro_init();
+    if (headless_init (argc, argv) != 0) return -1;
     i = 0;
     // try a couple of different color depths
     // keep on trying until bpp reaches 0
     while (bpp = color_depths[i])
     {
         set_color_depth (bpp);
-        if (set_gfx_mode (GFX_AUTODETECT, 640, 480, 0, 0) == 0)
+        if (headless_set_gfx_mode (GFX_AUTODETECT, 640, 480, 0, 0) == 0)
             break;
     }
     // if bpp reached 0, it means we failed finding a suitable color depth
     if (bpp == 0) return -1;
-    if (install_keyboard() != 0) return -1;
-    if (install_timer() != 0) return -1;
+    if (headless_install_keyboard() != 0) return -1;
+    if (headless_install_timer() != 0) return -1;
     return 0;
 }
 
+#endif
+
 /*
     lit_color is a colordepth independant function to 
     adjust the lighting of a certain pixel
@@ -127,20 +138,337 @@ void lit_projection (BITMAP *target, BITMAP *map,
 }
 
 
-int main(void)
+/*
+     lit_projection_ramp () draws the same as lit_projection (), but
+     lights a whole line at a time with light_colors() (see lightramp.h)
+     instead of calling lit_color() for every pixel.
+     The colors are lit for the color depth of target, not of the screen.
+*/
+void lit_projection_ramp (BITMAP *target, BITMAP *map,
+     fixed longitude, fixed latitude)
+{
+    int x, y; // coordinates on target bitmap
+    fixed p_angle, q_angle;
+    int colors[256], light[256]; // the pixels of a piece of a line
+    int depth = bitmap_color_depth (target);
+    int n, start;
+    
+    // calculate the light vector
+    fixed lightx, lighty, lightz;    
+    lightx = fixmul (fixsin (longitude), fixcos(latitude));
+    lighty = fixsin (latitude);
+    lightz = fixmul (fixcos (longitude), fixcos(latitude));
+    
+    for (y = 0; y < target->h; y++)
+    {
+        int q = y * map->h / target->h;
+        p_angle = ((itofix(y) / target->h) * 128) - itofix (64);
+        for (start = 0; start < target->w; start += n)
+        {
+            n = target->w - start < 256 ? target->w - start : 256;
+            for (x = start; x < start + n; x++)
+            {
+                // the same calculations as in lit_projection
+                int p = x * map->w / target->w;
+                fixed lightf;
+                q_angle = (itofix (x) / target->w * 256);
+
+                lightf = dot_product (
+                     fixmul (fixsin (p_angle), fixcos (p_angle)),
+                     fixsin (p_angle),
+                     fixmul (fixcos (q_angle), fixcos (p_angle)),
+                     lightx, lighty, lightz
+                );
+                if (lightf < 0) lightf = 0;
+                light[x - start] = fixtoi (lightf * 255);
+                colors[x - start] = getpixel (map, p, q);
+            }
+            light_colors (depth, colors, light, n);
+            put_colors (target, start, y, colors, n);
+        }
+    }
+}
+
+/*
+     LIT_PROJECTION_CACHE holds everything lit_projection_cached() needs
+     to remember between frames. The normal of the sphere surface at each
+     pixel only depends on the size of the target, so it is calculated
+     once. Only the light vector changes from frame to frame.
+*/
+typedef struct LIT_PROJECTION_CACHE
+{
+    int w, h; // the size of the target
+    // the normal at each pixel. normalx and normaly only depend on the
+    // line, so they are stored once per line, normalz once per pixel.
+    fixed *normalx, *normaly, *normalz;
+    // the largest normalz (ignoring the sign) of each line
+    fixed *max_normalz;
+    // the light level of each pixel in the last frame
+    unsigned short *level;
+    // TRUE for each line that was completely dark in the last frame
+    char *dark;
+    // room for the new light levels of one line
+    unsigned short *row;
+    // what we drew on last time, NULL if nothing yet
+    BITMAP *last_target, *last_map;
+    // the light vector of the last frame
+    fixed lightx, lighty, lightz;
+} LIT_PROJECTION_CACHE;
+
+/*
+     A part of the target that was changed by lit_projection_update ()
+*/
+typedef struct LIT_RECT
+{
+    int x, y, w, h;
+} LIT_RECT;
+
+void destroy_lit_projection_cache (LIT_PROJECTION_CACHE *cache)
+{
+    free (cache->normalx);
+    free (cache->normaly);
+    free (cache->normalz);
+    free (cache->max_normalz);
+    free (cache->level);
+    free (cache->dark);
+    free (cache->row);
+    free (cache);
+}
+
+/*
+     create_lit_projection_cache() makes a cache for a target of w x h
+     pixels and calculates the normals. returns NULL if there is not
+     enough memory.
+*/
+LIT_PROJECTION_CACHE *create_lit_projection_cache (int w, int h)
+{
+    LIT_PROJECTION_CACHE *cache = calloc (1, sizeof (LIT_PROJECTION_CACHE));
+    int x, y;
+    fixed p_angle, q_angle;
+    if (!cache) return NULL;
+
+    cache->w = w;
+    cache->h = h;
+    cache->normalx = malloc (h * sizeof (fixed));
+    cache->normaly = malloc (h * sizeof (fixed));
+    cache->normalz = malloc (w * h * sizeof (fixed));
+    cache->max_normalz = malloc (h * sizeof (fixed));
+    cache->level = malloc (w * h * sizeof (unsigned short));
+    cache->dark = malloc (h);
+    cache->row = malloc (w * sizeof (unsigned short));
+    if (!cache->normalx || !cache->normaly || !cache->normalz ||
+        !cache->max_normalz || !cache->level || !cache->dark || !cache->row)
+    {
+        destroy_lit_projection_cache (cache);
+        return NULL;
+    }
+    cache->last_target = NULL;
+    cache->last_map = NULL;
+
+    // these are exactly the same calculations as in lit_projection
+    for (y = 0; y < h; y++)
+    {
+        p_angle = ((itofix(y) / h) * 128) - itofix (64);
+        cache->normalx[y] = fixmul (fixsin (p_angle), fixcos (p_angle));
+        cache->normaly[y] = fixsin (p_angle);
+        cache->max_normalz[y] = 0;
+        for (x = 0; x < w; x++)
+        {
+            fixed nz;
+            q_angle = (itofix (x) / w * 256);
+            nz = fixmul (fixcos (q_angle), fixcos (p_angle));
+            cache->normalz[y * w + x] = nz;
+            if (abs (nz) > cache->max_normalz[y]) cache->max_normalz[y] = abs (nz);
+        }
+    }
+    return cache;
+}
+
+/*
+     lit_projection_update () draws the same as lit_projection_ramp (), but
+     takes the normals from the cache, so each pixel is only a dot product.
+
+     It also remembers the light level of every pixel. When it draws on the
+     same target with the same map as last time, only the pixels that
+     change light level are drawn again. So the target must not be changed
+     in between, or you have to use another cache.
+     The target must have the size the cache was made for.
+
+     Along a line of the target only normalz changes, so the line is
+     completely dark if the light is still below zero with the largest
+     normalz of the line. Lines that were dark and stay dark are skipped
+     without calculating any light. When the light moves slowly, like
+     in a world clock, that's the whole night side. Of the other lines,
+     only the pixels from the first to the last changed one are drawn.
+
+     The parts of the target that were changed are stored in rects, so
+     that you only have to blit those to the screen. Lines next to each
+     other go into the same rectangle. When there are more than
+     max_rects, the last one grows to hold the rest.
+     rects may be NULL if you don't need them.
+     returns the number of rectangles.
+*/
+int lit_projection_update (BITMAP *target, BITMAP *map,
+     fixed longitude, fixed latitude, LIT_PROJECTION_CACHE *cache,
+     LIT_RECT *rects, int max_rects)
+{
+    int x, y, i, n;
+    int x1, x2; // the first and last pixel that changed on a line
+    int colors[256], light[256]; // the pixels of a piece of a line
+    int depth = bitmap_color_depth (target);
+    int w = cache->w;
+    unsigned short *row = cache->row;
+    int count = 0; // the number of rectangles
+    int open = FALSE; // TRUE if the last line is in rects[count - 1]
+    // if we didn't draw this before, all lines have to be drawn
+    int redraw = cache->last_target != target || cache->last_map != map;
+    
+    // calculate the light vector
+    fixed lightx, lighty, lightz;    
+    lightx = fixmul (fixsin (longitude), fixcos(latitude));
+    lighty = fixsin (latitude);
+    lightz = fixmul (fixcos (longitude), fixcos(latitude));
+
+    // the light didn't move, so nothing changes
+    if (!redraw && lightx == cache->lightx && lighty == cache->lighty &&
+        lightz == cache->lightz)
+        return 0;
+
+    for (y = 0; y < cache->h; y++)
+    {
+        int q = y * map->h / cache->h;
+        fixed nx = cache->normalx[y];
+        fixed ny = cache->normaly[y];
+        fixed *nz = cache->normalz + y * w;
+        unsigned short *last = cache->level + y * w;
+        // the most light any pixel of this line can get. The 4 is
+        // for the rounding of fixmul, so we never skip a lit pixel.
+        fixed brightest = dot_product (nx, ny, cache->max_normalz[y],
+            lightx, lighty, abs (lightz)) + 4;
+        int dark = brightest < 0 || fixtoi (brightest * 255) == 0;
+
+        if (dark && cache->dark[y] && !redraw)
+        {
+            open = FALSE;
+            continue;
+        }
+
+        // first only the light levels of the whole line
+        if (dark)
+            memset (row, 0, w * sizeof (row[0]));
+        else for (x = 0; x < w; x++)
+        {
+            fixed lightf = dot_product (nx, ny, nz[x],
+                lightx, lighty, lightz);
+            if (lightf < 0) lightf = 0;
+            row[x] = fixtoi (lightf * 255);
+        }
+        cache->dark[y] = dark;
+
+        // find the pixels that changed
+        x1 = 0;
+        x2 = w - 1;
+        if (!redraw)
+        {
+            while (x1 < w && row[x1] == last[x1]) x1++;
+            // nothing changed on this line, so skip it
+            if (x1 == w)
+            {
+                open = FALSE;
+                continue;
+            }
+            while (row[x2] == last[x2]) x2--;
+        }
+        memcpy (last + x1, row + x1, (x2 - x1 + 1) * sizeof (row[0]));
+
+        for (x = x1; x <= x2; x += n)
+        {
+            n = x2 + 1 - x < 256 ? x2 + 1 - x : 256;
+            for (i = 0; i < n; i++)
+            {
+                colors[i] = getpixel (map, (x + i) * map->w / w, q);
+                light[i] = row[x + i];
+            }
+            light_colors (depth, colors, light, n);
+            put_colors (target, x, y, colors, n);
+        }
+
+        if (!rects) continue;
+        // add this line to the rectangles
+        if (!open && count < max_rects)
+        {
+            rects[count].x = x1;
+            rects[count].y = y;
+            rects[count].w = x2 - x1 + 1;
+            rects[count].h = 1;
+            count++;
+            open = TRUE;
+        }
+        else if (count > 0)
+        {
+            LIT_RECT *r = &rects[count - 1];
+            int right = r->x + r->w;
+            if (x1 < r->x) r->x = x1;
+            if (x2 + 1 > right) right = x2 + 1;
+            r->w = right - r->x;
+            r->h = y + 1 - r->y;
+            open = TRUE;
+        }
+    }
+    cache->last_target = target;
+    cache->last_map = map;
+    cache->lightx = lightx;
+    cache->lighty = lighty;
+    cache->lightz = lightz;
+    return count;
+}
+
+/*
+     lit_projection_cached () is lit_projection_update () for when you
+     don't need to know what changed.
+*/
+void lit_projection_cached (BITMAP *target, BITMAP *map,
+     fixed longitude, fixed latitude, LIT_PROJECTION_CACHE *cache)
+{
+    lit_projection_update (target, map, longitude, latitude, cache, NULL, 0);
+}
+
+#ifndef KERNELS_ONLY
+
+int main(int argc, char *argv[])
 {
-    if (init() == 0)
+    if (init(argc, argv) == 0)
     {
         PALETTE pal;
         BITMAP *earthmap = load_bitmap ("earth.bmp", pal);
         BITMAP *buffer = create_bitmap (SCREEN_W, SCREEN_H);
+        LIT_PROJECTION_CACHE *cache =
+            create_lit_projection_cache (SCREEN_W, SCREEN_H);
+        LIT_RECT rects[64];
+        fixed longitude = itofix (128);
+        int i, count;
         clear_bitmap (buffer);                
-        lit_projection (buffer, earthmap, itofix (128), itofix (-20));
-        blit (buffer, screen, 0, 0, 0, 0, SCREEN_W, SCREEN_H);
-        while (!key[KEY_ESC]) {}
+        if (!cache)
+            allegro_message ("Error: Not enough memory for the cache");
+        // like a world clock, the sun slowly moves along the earth
+        while (cache && !key[KEY_ESC])
+        {
+            count = lit_projection_update (buffer, earthmap,
+                longitude, itofix (-20), cache, rects, 64);
+            // only blit the parts that have changed
+            for (i = 0; i < count; i++)
+                blit (buffer, screen, rects[i].x, rects[i].y,
+                    rects[i].x, rects[i].y, rects[i].w, rects[i].h);
+            headless_frame ();
+            longitude -= ftofix (0.1);
+            headless_rest (10);
+        }
+        if (cache) destroy_lit_projection_cache (cache);
         destroy_bitmap (earthmap);
         destroy_bitmap (buffer);
     }
     return 0;
 
 } END_OF_MAIN();
+
+#endif
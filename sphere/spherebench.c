@@ -0,0 +1,425 @@
+/*
+   SPHERE BENCHMARK
+   written by Martijn van Iersel (Amarillion)
+
+   This program measures the drawing functions of the sphere examples
+   one by one, on memory bitmaps. It doesn't need a screen, the results
+   are printed as CSV. See ../common/bench.h for the command line options.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <allegro.h>
+#include "spherevec.h"
+#include "mipmap.h"
+#include "planets.h"
+#include "../common/bench.h"
+
+// we only want the drawing functions of these examples, not their main()
+#define KERNELS_ONLY
+#include "sphere1.c"
+#include "sphere2.c"
+#include "sphere3.c"
+#include "sphere4.c"
+// sphere5.c and sphere6.c have their own copies of
+// get_planet_rotation_matrix and lit_color, so we give those other names
+#define get_planet_rotation_matrix get_planet_rotation_matrix_5
+#define lit_color lit_color_5
+#include "sphere5.c"
+#undef lit_color
+#define lit_color lit_color_6
+#include "sphere6.c"
+#undef lit_color
+#undef get_planet_rotation_matrix
+
+// the radius of a sphere that just fits on the bitmap
+int bench_radius (BITMAP *bmp)
+{
+    return (bmp->w < bmp->h ? bmp->w : bmp->h) / 2 - 1;
+}
+
+void bench_mapped_cylinder (BITMAP *bmp, int frame, void *map)
+{
+    mapped_cylinder (bmp, bmp->w / 2, 0, bmp->w / 2 - 1, bmp->h, map);
+}
+
+void bench_mapped_sphere (BITMAP *bmp, int frame, void *map)
+{
+    mapped_sphere (bmp, bmp->w / 2, bmp->h / 2, bench_radius (bmp), map);
+}
+
+void bench_mapped_sphere_cached (BITMAP *bmp, int frame, void *map)
+{
+    mapped_sphere_cached (bmp, bmp->w / 2, bmp->h / 2, bench_radius (bmp), map);
+}
+
+void bench_mapped_sphere_ex (BITMAP *bmp, int frame, void *map)
+{
+    MATRIX m;
+    get_planet_rotation_matrix (&m, itofix (frame), itofix (16), 0);
+    mapped_sphere_ex (bmp, bmp->w / 2, bmp->h / 2, bench_radius (bmp), map, &m);
+}
+
+/*
+    bench_planet_grid() draws 12 planets in a 4 x 3 grid, like the examples
+    do. Each planet spins around its own axis, a bit further every frame.
+    grid_kernel is mapped_sphere_ex or mapped_sphere_ex_fast.
+*/
+void bench_planet_grid (BITMAP *bmp, int frame, BITMAP *map,
+    void (*grid_kernel) (BITMAP *, int, int, int, BITMAP *, MATRIX *))
+{
+    MATRIX m;
+    int i, j;
+    int xgrid = bmp->w / 4;
+    int ygrid = bmp->h / 3;
+    int radius = (xgrid > ygrid ? ygrid : xgrid) / 2 - 2;
+    for (i = 0; i < 4; i ++)
+        for (j = 0; j < 3; j ++)
+        {
+            get_planet_rotation_matrix (&m,
+                (j * 4 + i) * itofix (16) + itofix (frame), 0, 0);
+            grid_kernel (bmp, (2 * i + 1) * xgrid / 2, (2 * j + 1) * ygrid / 2,
+                radius, map, &m);
+        }
+}
+
+void bench_planet_grid_ex (BITMAP *bmp, int frame, void *map)
+{
+    bench_planet_grid (bmp, frame, map, mapped_sphere_ex);
+}
+
+void bench_planet_grid_ex_fast (BITMAP *bmp, int frame, void *map)
+{
+    bench_planet_grid (bmp, frame, map, mapped_sphere_ex_fast);
+}
+
+void bench_mapped_sphere_vec (BITMAP *bmp, int frame, void *map)
+{
+    MATRIX m;
+    get_planet_rotation_matrix (&m, itofix (frame), itofix (16), 0);
+    mapped_sphere_vec (bmp, bmp->w / 2, bmp->h / 2, bench_radius (bmp), map, &m);
+}
+
+// the same without AVX2
+void bench_mapped_sphere_vec_c (BITMAP *bmp, int frame, void *map)
+{
+    set_sphere_vec_simd (FALSE);
+    bench_mapped_sphere_vec (bmp, frame, map);
+    set_sphere_vec_simd (TRUE);
+}
+
+void bench_lit_sphere (BITMAP *bmp, int frame, void *map)
+{
+    lit_sphere (bmp, bmp->w / 2, bmp->h / 2, bench_radius (bmp),
+        itofix (frame), itofix (32));
+}
+
+void bench_lit_sphere_span (BITMAP *bmp, int frame, void *map)
+{
+    lit_sphere_span (bmp, bmp->w / 2, bmp->h / 2, bench_radius (bmp),
+        itofix (frame), itofix (32));
+}
+
+void bench_mapped_lit_sphere (BITMAP *bmp, int frame, void *map)
+{
+    MATRIX m;
+    get_planet_rotation_matrix_5 (&m, itofix (frame), itofix (16), 0);
+    mapped_lit_sphere (bmp, bmp->w / 2, bmp->h / 2, bench_radius (bmp), map,
+        &m, itofix (64), itofix (32));
+}
+
+/*
+   mapped_lit_sphere_lit_color() is mapped_lit_sphere() as it was in the
+   article, calling lit_color() (SPHERE 5) for every pixel. It is the
+   baseline for the light ramps: bench_depth times both, and make check
+   makes sure they draw exactly the same.
+*/
+void mapped_lit_sphere_lit_color (BITMAP *target, int cx, int cy, int r,
+    BITMAP *map, MATRIX *rotmat, fixed longitude, fixed latitude)
+{
+    int x, y; // coordinates on target bitmap
+    int p, q; // coordinates on source bitmap
+    
+    // calculate the light vector
+    fixed lightx, lighty, lightz;    
+    lightx = fixmul (fixsin (longitude), fixcos(latitude));
+    lighty = fixsin (latitude);
+    lightz = fixmul (fixcos (longitude), fixcos(latitude));
+
+    // see litsphere.c for the explanation
+    for (y = -r; y < r; y++)
+    {
+        fixed q_cos = fixcos (- fixasin (itofix (y) / r)) * r;            
+        for (x = - fixtoi (q_cos) + 1; x < fixtoi(q_cos) - 1; x++)
+        {
+             fixed light;
+             int lighti, color;
+             fixed temp_p, temp_q;
+             fixed newx, newy, newz;
+             fixed z = ftofix (sqrt((double)(r * r - x * x - y * y)));
+             
+             apply_matrix (rotmat, itofix(x), itofix(y), z,
+                  &newx, &newy, &newz);
+             temp_q = - fixasin (newy / r);             
+             if (temp_q != 0)
+                temp_p = fixatan2 (newx, newz);                
+             else
+                 temp_p = 0;
+             temp_p &= 0xFFFFFF;
+             q = fixtoi (-temp_q + itofix (64)) * (map->h-1) >> 7;
+             p = fixtoi (temp_p) * (map->w-1) >> 8;
+
+             light = dot_product (
+                 itofix(x) / r, itofix(y) / r, z / r,
+                 lightx, lighty, lightz
+             );
+             if (light < 0) light = 0;
+
+             lighti = fixtoi ((light << 8) - light);
+             color = getpixel (map, p, q);
+             putpixel (target, x + cx, y + cy, lit_color_5 (color, lighti));
+        }
+    }
+}
+
+void bench_mapped_lit_sphere_lit_color (BITMAP *bmp, int frame, void *map)
+{
+    MATRIX m;
+    get_planet_rotation_matrix_5 (&m, itofix (frame), itofix (16), 0);
+    mapped_lit_sphere_lit_color (bmp, bmp->w / 2, bmp->h / 2,
+        bench_radius (bmp), map, &m, itofix (64), itofix (32));
+}
+
+void bench_lit_projection (BITMAP *bmp, int frame, void *map)
+{
+    lit_projection (bmp, map, itofix (frame), itofix (-20));
+}
+
+void bench_lit_projection_ramp (BITMAP *bmp, int frame, void *map)
+{
+    lit_projection_ramp (bmp, map, itofix (frame), itofix (-20));
+}
+
+// the normals only depend on the size of bmp, so the cache is made
+// again only when the benchmark size changes
+void bench_lit_projection_cached (BITMAP *bmp, int frame, void *map)
+{
+    static LIT_PROJECTION_CACHE *cache = NULL;
+    if (cache && (cache->w != bmp->w || cache->h != bmp->h))
+    {
+        destroy_lit_projection_cache (cache);
+        cache = NULL;
+    }
+    if (!cache) cache = create_lit_projection_cache (bmp->w, bmp->h);
+    lit_projection_cached (bmp, map, itofix (frame), itofix (-20), cache);
+}
+
+// like the world clock in sphere6.c, the light moves only a little each
+// frame, so lit_projection_update () redraws only part of bmp
+void bench_lit_projection_clock (BITMAP *bmp, int frame, void *map)
+{
+    static LIT_PROJECTION_CACHE *cache = NULL;
+    LIT_RECT rects[64];
+    if (cache && (cache->w != bmp->w || cache->h != bmp->h))
+    {
+        destroy_lit_projection_cache (cache);
+        cache = NULL;
+    }
+    if (!cache) cache = create_lit_projection_cache (bmp->w, bmp->h);
+    lit_projection_update (bmp, map, itofix (128) - frame * ftofix (0.1),
+        itofix (-20), cache, rects, 64);
+}
+
+/*
+   The _big kernels draw from a map 8 times as large as earth.bmp, the
+   _mip kernels from the level of its mipmap that suits the radius.
+   data is the mipmap, level 0 is the large map.
+*/
+void bench_mapped_sphere_big (BITMAP *bmp, int frame, void *mip)
+{
+    mapped_sphere (bmp, bmp->w / 2, bmp->h / 2, bench_radius (bmp),
+        ((MIPMAP *)mip)->levels[0]);
+}
+
+void bench_mapped_sphere_mip (BITMAP *bmp, int frame, void *mip)
+{
+    mapped_sphere (bmp, bmp->w / 2, bmp->h / 2, bench_radius (bmp),
+        get_mipmap_level (mip, bench_radius (bmp)));
+}
+
+void bench_mapped_sphere_ex_big (BITMAP *bmp, int frame, void *mip)
+{
+    bench_mapped_sphere_ex (bmp, frame, ((MIPMAP *)mip)->levels[0]);
+}
+
+void bench_mapped_sphere_ex_mip (BITMAP *bmp, int frame, void *mip)
+{
+    bench_mapped_sphere_ex (bmp, frame,
+        get_mipmap_level (mip, bench_radius (bmp)));
+}
+
+void bench_mapped_lit_sphere_big (BITMAP *bmp, int frame, void *mip)
+{
+    bench_mapped_lit_sphere (bmp, frame, ((MIPMAP *)mip)->levels[0]);
+}
+
+void bench_mapped_lit_sphere_mip (BITMAP *bmp, int frame, void *mip)
+{
+    bench_mapped_lit_sphere (bmp, frame,
+        get_mipmap_level (mip, bench_radius (bmp)));
+}
+
+/*
+   A star map: one large planet in the middle and NUM_PLANETS small ones
+   scattered around it, drawn with draw_planets() by a single thread or
+   by a pool of 4.
+*/
+#define NUM_PLANETS 300
+
+typedef struct STAR_MAP
+{
+    PLANET planets[NUM_PLANETS];
+    BITMAP *map;
+    WORKER_POOL *pool;
+} STAR_MAP;
+
+void setup_star_map (STAR_MAP *s, BITMAP *bmp, int frame)
+{
+    int i;
+    // the same planets every time
+    srand (1);
+    for (i = 0; i < NUM_PLANETS; i++)
+    {
+        PLANET *planet = &s->planets[i];
+        if (i == 0)
+        {
+            planet->cx = bmp->w / 2;
+            planet->cy = bmp->h / 2;
+            planet->r = bench_radius (bmp) / 2;
+        }
+        else
+        {
+            planet->cx = rand () % bmp->w;
+            planet->cy = rand () % bmp->h;
+            planet->r = 4 + rand () % 20;
+        }
+        planet->map = s->map;
+        get_planet_rotation_matrix (&planet->rotmat,
+            itofix (frame + i * 7), itofix (16), 0);
+        planet->longitude = itofix (64 + i);
+        planet->latitude = itofix (32);
+    }
+}
+
+void bench_planets (BITMAP *bmp, int frame, void *data)
+{
+    STAR_MAP *s = data;
+    setup_star_map (s, bmp, frame);
+    draw_planets (bmp, s->planets, NUM_PLANETS, NULL);
+}
+
+void bench_planets_threaded (BITMAP *bmp, int frame, void *data)
+{
+    STAR_MAP *s = data;
+    setup_star_map (s, bmp, frame);
+    draw_planets (bmp, s->planets, NUM_PLANETS, s->pool);
+}
+
+int main(int argc, char *argv[])
+{
+    PALETTE pal;
+    BITMAP *map, *big, *smooth;
+    MIPMAP *mip;
+    STAR_MAP stars;
+    int x, y;
+
+    if (bench_init (argc, argv) != 0)
+    {
+        allegro_message ("Error: Could not initialize the benchmark");
+        return -1;
+    }
+    map = load_bitmap ("earth.bmp", pal);
+    if (!map)
+    {
+        allegro_message ("Error: Could not load earth.bmp");
+        return -1;
+    }
+
+    // earth.bmp blown up 8 times, to see what a large map costs
+    big = create_bitmap (map->w * 8, map->h * 8);
+    for (y = 0; y < big->h; y++)
+        for (x = 0; x < big->w; x++)
+            putpixel (big, x, y, getpixel (map, x / 8, y / 8));
+    mip = create_mipmap (big);
+
+    // a map that changes by 2 from one pixel to the next, also across
+    // the left and right edge. On it the error of a check is twice the
+    // number of pixels that a kernel is off on the map.
+    smooth = create_bitmap (256, 128);
+    for (y = 0; y < smooth->h; y++)
+        for (x = 0; x < smooth->w; x++)
+            putpixel (smooth, x, y, makecol (MIN (ABS (x - 128) * 2, 255), y * 2, 0));
+
+    bench_kernel ("mapped_cylinder", bench_mapped_cylinder, map);
+    bench_kernel ("mapped_sphere", bench_mapped_sphere, map);
+    bench_kernel ("mapped_sphere_cached", bench_mapped_sphere_cached, map);
+    bench_kernel ("mapped_sphere_ex", bench_mapped_sphere_ex, map);
+    bench_kernel ("mapped_sphere_vec", bench_mapped_sphere_vec, map);
+    bench_kernel ("mapped_sphere_vec_c", bench_mapped_sphere_vec_c, map);
+    bench_kernel ("planet_grid_ex", bench_planet_grid_ex, map);
+    bench_kernel ("planet_grid_ex_fast", bench_planet_grid_ex_fast, map);
+    bench_kernel ("lit_sphere", bench_lit_sphere, map);
+    bench_kernel ("lit_sphere_span", bench_lit_sphere_span, map);
+    bench_kernel ("mapped_lit_sphere_lit_color",
+        bench_mapped_lit_sphere_lit_color, map);
+    bench_kernel ("mapped_lit_sphere", bench_mapped_lit_sphere, map);
+    bench_kernel ("lit_projection", bench_lit_projection, map);
+    bench_kernel ("lit_projection_ramp", bench_lit_projection_ramp, map);
+    bench_kernel ("lit_projection_cached", bench_lit_projection_cached, map);
+    bench_kernel ("lit_projection_clock", bench_lit_projection_clock, map);
+    bench_kernel ("mapped_sphere_big", bench_mapped_sphere_big, mip);
+    bench_kernel ("mapped_sphere_mip", bench_mapped_sphere_mip, mip);
+    bench_kernel ("mapped_sphere_ex_big", bench_mapped_sphere_ex_big, mip);
+    bench_kernel ("mapped_sphere_ex_mip", bench_mapped_sphere_ex_mip, mip);
+    bench_kernel ("mapped_lit_sphere_big", bench_mapped_lit_sphere_big, mip);
+    bench_kernel ("mapped_lit_sphere_mip", bench_mapped_lit_sphere_mip, mip);
+    stars.map = map;
+    stars.pool = create_worker_pool (4);
+    bench_kernel ("planets", bench_planets, &stars);
+    bench_kernel ("planets_threaded", bench_planets_threaded, &stars);
+    destroy_worker_pool (stars.pool);
+
+    // tests for make check. mapped_sphere_vec may take a pixel from the
+    // column or line next to the one mapped_sphere_ex takes, not further.
+    bench_check ("mapped_sphere_vec", bench_mapped_sphere_vec,
+        "mapped_sphere_ex", bench_mapped_sphere_ex, smooth, 2);
+    bench_check ("mapped_sphere_vec_c", bench_mapped_sphere_vec_c,
+        "mapped_sphere_ex", bench_mapped_sphere_ex, smooth, 2);
+
+    // mapped_sphere_ex_fast takes the spinning planets from a SPHERE_TABLE,
+    // which rounds in other places than mapped_sphere_ex does. It may take a
+    // pixel up to two columns or lines away from the one mapped_sphere_ex
+    // takes.
+    bench_check ("planet_grid_ex_fast", bench_planet_grid_ex_fast,
+        "planet_grid_ex", bench_planet_grid_ex, smooth, 4);
+
+    // light_colors() gives exactly the same colors as lit_color()
+    bench_check ("mapped_lit_sphere", bench_mapped_lit_sphere,
+        "mapped_lit_sphere_lit_color", bench_mapped_lit_sphere_lit_color,
+        map, 0);
+
+    // lit_sphere_span calculates the light in floats, and lit_sphere in
+    // fixed point with a truncated normal, so they may be one light
+    // level apart. In 15 and 16 bit that can make a channel one step
+    // darker or lighter, which is 8 out of 255.
+    bench_check ("lit_sphere_span", bench_lit_sphere_span,
+        "lit_sphere", bench_lit_sphere, NULL,
+        bitmap_color_depth (screen) <= 16 ? 8 : 1);
+
+    destroy_bitmap (smooth);
+    destroy_mipmap (mip);
+    destroy_bitmap (big);
+    destroy_bitmap (map);
+    return bench_exit ();
+
+} END_OF_MAIN();
@@ -0,0 +1,127 @@
+/*
+   SPHEREREAL.C
+   written by Martijn van Iersel (Amarillion)
+
+   mapped_sphere_ex (SPHERE 3) and mapped_lit_sphere (SPHERE 5) written
+   with the macros of real.h, so they can be compiled for fixed, float
+   or double numbers. The makefile compiles this file once for each:
+   with -DREAL_FLOAT it gives spherereal_float.o, which has
+   mapped_sphere_ex_float and mapped_lit_sphere_float. The fixed
+   versions draw exactly the same as the originals. See spherereal.h.
+*/
+
+#include "../common/real.h"
+#include "lightramp.h"
+#include "spherereal.h"
+
+/*
+   apply the rotation matrix m to (x, y, z), like apply_matrix() does
+   for fixed numbers
+*/
+#define REAL_APPLY_MATRIX(m, x, y, z, nx, ny, nz) \
+    nx = rmul (x, ftor ((m)->v[0][0])) + rmul (y, ftor ((m)->v[0][1])) + \
+         rmul (z, ftor ((m)->v[0][2])) + ftor ((m)->t[0]); \
+    ny = rmul (x, ftor ((m)->v[1][0])) + rmul (y, ftor ((m)->v[1][1])) + \
+         rmul (z, ftor ((m)->v[1][2])) + ftor ((m)->t[1]); \
+    nz = rmul (x, ftor ((m)->v[2][0])) + rmul (y, ftor ((m)->v[2][1])) + \
+         rmul (z, ftor ((m)->v[2][2])) + ftor ((m)->t[2])
+
+void REAL_NAME (mapped_sphere_ex) (BITMAP *target, int cx, int cy, int r,
+    BITMAP *map, MATRIX *rotmat)
+{
+    int x, y; // coordinates on the target bitmap
+    int p, q; // coordinates on the source bitmap
+
+    // see sphere3.c for the explanation
+    for (y = -r; y < r; y++)
+    {
+        REAL q_cos = rmuli (rcos (- rasin (rdivi (itor (y), r))), r);
+        for (x = - rtoi (q_cos) + 1; x < rtoi (q_cos) - 1; x++)
+        {
+             REAL newq_cos, temp_p, temp_q;
+             REAL newx, newy, newz;
+             REAL z;
+
+             z = rsqrt (rmuli (itor (r), r) -
+                 rmuli (itor (x), x) - rmuli (itor (y), y));
+
+             REAL_APPLY_MATRIX (rotmat, itor (x), itor (y), z,
+                 newx, newy, newz);
+
+             temp_q = rasin (rdivi (newy, r));
+             q = rtoi (temp_q + itor (64)) * (map->h-1) / 128;
+
+             newq_cos = rmuli (rcos (temp_q), r);
+             if (newq_cos != 0)
+                 temp_p = ratan2 (rdiv (newx, newq_cos), rdiv (newz, newq_cos));
+             else
+                 temp_p = 0;
+             temp_p = rwrap (temp_p);
+
+             p = rtoi (temp_p) * (map->w-1) / 256;
+
+             putpixel (target, x + cx, y + cy,
+                 getpixel (map, p, q)
+                 );
+        }
+    }
+}
+
+/*
+   The light is applied with light_colors() (see lightramp.h), which
+   gives the same colors as lit_color() in sphere5.c when target has
+   the color depth of the screen.
+*/
+void REAL_NAME (mapped_lit_sphere) (BITMAP *target, int cx, int cy, int r,
+    BITMAP *map, MATRIX *rotmat, fixed longitude, fixed latitude)
+{
+    int x, y; // coordinates on target bitmap
+    int p, q; // coordinates on source bitmap
+    int depth = bitmap_color_depth (target);
+    REAL lon = ftor (longitude), lat = ftor (latitude);
+
+    // calculate the light vector
+    REAL lightx, lighty, lightz;
+    lightx = rmul (rsin (lon), rcos (lat));
+    lighty = rsin (lat);
+    lightz = rmul (rcos (lon), rcos (lat));
+
+    // see sphere5.c for the explanation
+    for (y = -r; y < r; y++)
+    {
+        REAL q_cos = rmuli (rcos (- rasin (rdivi (itor (y), r))), r);
+        for (x = - rtoi (q_cos) + 1; x < rtoi (q_cos) - 1; x++)
+        {
+             REAL light;
+             int lighti, color;
+             REAL temp_p, temp_q;
+             REAL newx, newy, newz;
+             REAL z = rsqrti (r * r - x * x - y * y);
+
+             REAL_APPLY_MATRIX (rotmat, itor (x), itor (y), z,
+                 newx, newy, newz);
+
+             temp_q = - rasin (rdivi (newy, r));
+             if (temp_q != 0)
+                 temp_p = ratan2 (newx, newz);
+             else
+                 temp_p = 0;
+             temp_p = rwrap (temp_p);
+
+             q = rtoi (-temp_q + itor (64)) * (map->h-1) >> 7;
+             p = rtoi (temp_p) * (map->w-1) >> 8;
+
+             light = rmul (rdivi (itor (x), r), lightx) +
+                 rmul (rdivi (itor (y), r), lighty) +
+                 rmul (rdivi (z, r), lightz);
+             if (light < 0) light = 0;
+
+             lighti = rtoi (rmuli (light, 255));
+             color = getpixel (map, p, q);
+             light_colors (depth, &color, &lighti, 1);
+             putpixel (target, x + cx, y + cy, color);
+        }
+    }
+}
+
+#undef REAL_APPLY_MATRIX
@@ -0,0 +1,36 @@
+/*
+   SPHEREREAL.H
+   written by Martijn van Iersel (Amarillion)
+
+   spherereal.c is compiled three times (see the makefile): as it is,
+   with -DREAL_FLOAT and with -DREAL_DOUBLE. Each object file has one
+   version of mapped_sphere_ex (SPHERE 3) and mapped_lit_sphere
+   (SPHERE 5), for fixed, float or double numbers. A program only
+   links the objects with the versions it needs.
+*/
+
+#ifndef SPHEREREAL_H
+#define SPHEREREAL_H
+
+#include <allegro.h>
+
+/* spherereal_fixed.o: the fixed versions, which draw exactly the same
+   as mapped_sphere_ex() and mapped_lit_sphere() */
+void mapped_sphere_ex_fixed (BITMAP *target, int cx, int cy, int r,
+    BITMAP *map, MATRIX *rotmat);
+void mapped_lit_sphere_fixed (BITMAP *target, int cx, int cy, int r,
+    BITMAP *map, MATRIX *rotmat, fixed longitude, fixed latitude);
+
+/* spherereal_float.o */
+void mapped_sphere_ex_float (BITMAP *target, int cx, int cy, int r,
+    BITMAP *map, MATRIX *rotmat);
+void mapped_lit_sphere_float (BITMAP *target, int cx, int cy, int r,
+    BITMAP *map, MATRIX *rotmat, fixed longitude, fixed latitude);
+
+/* spherereal_double.o */
+void mapped_sphere_ex_double (BITMAP *target, int cx, int cy, int r,
+    BITMAP *map, MATRIX *rotmat);
+void mapped_lit_sphere_double (BITMAP *target, int cx, int cy, int r,
+    BITMAP *map, MATRIX *rotmat, fixed longitude, fixed latitude);
+
+#endif
@@ -0,0 +1,299 @@
+/*
+   SPHERETAB.C
+   written by Martijn van Iersel (Amarillion)
+
+   See spheretab.h
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <allegro.h>
+#include "spheretab.h"
+
+static SPHERE_TABLE *newest = NULL, *oldest = NULL;
+static int cache_size = 0;
+static int cache_budget = 32 << 20;
+
+// take a table out of the list
+static void unlink_table (SPHERE_TABLE *table)
+{
+    if (table->prev) table->prev->next = table->next;
+    else newest = table->next;
+    if (table->next) table->next->prev = table->prev;
+    else oldest = table->prev;
+    table->prev = table->next = NULL;
+}
+
+// put a table at the front of the list
+static void link_table (SPHERE_TABLE *table)
+{
+    table->prev = NULL;
+    table->next = newest;
+    if (newest) newest->prev = table;
+    else oldest = table;
+    newest = table;
+}
+
+static void destroy_sphere_table (SPHERE_TABLE *table)
+{
+    free (table->rows);
+    free (table);
+}
+
+// throw away the oldest tables until the cache fits in the budget again
+static void shrink_cache ()
+{
+    while (cache_size > cache_budget && oldest != newest)
+    {
+        SPHERE_TABLE *table = oldest;
+        unlink_table (table);
+        cache_size -= table->size;
+        destroy_sphere_table (table);
+    }
+}
+
+/*
+    create_sphere_table() calculates a new table. These are exactly the
+    same calculations as in mapped_sphere(), see sphere2.c for the
+    explanation. The rows and the p values of all rows are allocated as
+    a single block.
+*/
+static SPHERE_TABLE *create_sphere_table (int r, int map_w, int map_h)
+{
+    SPHERE_TABLE *table;
+    int x, y, total = 0;
+    int *p;
+
+    // first count the pixels, so we know how much memory we need
+    for (y = -r; y < r; y++)
+    {
+        fixed q_cos = fixcos (fixasin (itofix (y) / r)) * r;
+        int count = 2 * fixtoi (q_cos) - 2;
+        if (count > 0) total += count;
+    }
+
+    table = malloc (sizeof (SPHERE_TABLE));
+    if (!table) return NULL;
+    table->rows = malloc (2 * r * sizeof (SPHERE_ROW) + total * sizeof (int));
+    if (!table->rows)
+    {
+        free (table);
+        return NULL;
+    }
+    table->r = r;
+    table->map_w = map_w;
+    table->map_h = map_h;
+    table->size = sizeof (SPHERE_TABLE) + 2 * r * sizeof (SPHERE_ROW)
+        + total * sizeof (int);
+    table->prev = table->next = NULL;
+
+    p = (int *)(table->rows + 2 * r);
+    for (y = -r; y < r; y++)
+    {
+        SPHERE_ROW *row = &table->rows[y + r];
+        fixed temp_p, temp_q = fixasin (itofix (y) / r);
+        fixed q_cos = fixcos (temp_q) * r;
+
+        row->q = fixtoi (temp_q + itofix (64)) * (map_h - 1) / 128;
+        row->x1 = - fixtoi (q_cos) + 1;
+        row->count = 0;
+        row->p = p;
+        for (x = row->x1; x < fixtoi (q_cos) - 1; x++)
+        {
+            if (q_cos != 0)
+                temp_p = fixasin (fixdiv (itofix (x), q_cos));
+            else
+                temp_p = 0;
+            temp_p &= 0xFFFFFF;
+            p[row->count++] = fixtoi (temp_p) * (map_w - 1) / 256;
+        }
+        p += row->count;
+    }
+    return table;
+}
+
+SPHERE_TABLE *get_sphere_table (int r, int map_w, int map_h)
+{
+    SPHERE_TABLE *table;
+
+    if (r <= 0) return NULL;
+
+    for (table = newest; table; table = table->next)
+    {
+        if (table->r == r && table->map_w == map_w && table->map_h == map_h)
+        {
+            // it has just been used, so it moves to the front
+            unlink_table (table);
+            link_table (table);
+            return table;
+        }
+    }
+
+    table = create_sphere_table (r, map_w, map_h);
+    if (!table) return NULL;
+    link_table (table);
+    cache_size += table->size;
+    shrink_cache ();
+    return table;
+}
+
+/*
+    The table maps the angles 0..256 around the axis to the columns
+    0..map_w - 1, so turning the planet by angle moves each pixel
+    angle * (map_w - 1) / 256 columns further. We calculate that with
+    all 16 fraction bits of angle, so slow rotations are smooth too.
+*/
+int sphere_spin_offset (fixed angle, int map_w)
+{
+    return ((int64_t)(angle & 0xFFFFFF) * (map_w - 1)) >> 24;
+}
+
+/*
+    copy_columns() copies count pixels from line q of the map to line y
+    of the target, starting at x. p holds the column of each pixel.
+    direct tells if we can use line[] instead of putpixel and getpixel.
+*/
+static void copy_columns (BITMAP *target, int x, int y, BITMAP *map, int q,
+    const int *p, int count, int direct)
+{
+    int i;
+
+    if (!direct)
+    {
+        for (i = 0; i < count; i++)
+            putpixel (target, x + i, y, getpixel (map, p[i], q));
+        return;
+    }
+
+    switch (bitmap_color_depth (target))
+    {
+        case 8:
+        {
+            unsigned char *d = target->line[y] + x;
+            unsigned char *s = map->line[q];
+            for (i = 0; i < count; i++)
+                d[i] = s[p[i]];
+            break;
+        }
+        case 15:
+        case 16:
+        {
+            uint16_t *d = (uint16_t *)target->line[y] + x;
+            uint16_t *s = (uint16_t *)map->line[q];
+            for (i = 0; i < count; i++)
+                d[i] = s[p[i]];
+            break;
+        }
+        case 24:
+        {
+            // 24 bit pixels are 3 bytes, there is no type for that
+            unsigned char *d = target->line[y] + x * 3;
+            unsigned char *s = map->line[q];
+            for (i = 0; i < count; i++)
+            {
+                d[0] = s[p[i] * 3];
+                d[1] = s[p[i] * 3 + 1];
+                d[2] = s[p[i] * 3 + 2];
+                d += 3;
+            }
+            break;
+        }
+        case 32:
+        {
+            uint32_t *d = (uint32_t *)target->line[y] + x;
+            uint32_t *s = (uint32_t *)map->line[q];
+            for (i = 0; i < count; i++)
+                d[i] = s[p[i]];
+            break;
+        }
+    }
+}
+
+void draw_sphere_table (BITMAP *target, int cx, int cy,
+    SPHERE_TABLE *table, BITMAP *map, int offset)
+{
+    // direct access to line[] only works on memory bitmaps
+    // of the same color depth
+    int direct = is_memory_bitmap (target) && is_memory_bitmap (map) &&
+        bitmap_color_depth (target) == bitmap_color_depth (map);
+    // columns wrap around after period columns
+    int period = table->map_w - 1;
+    // the columns of a piece of a line, with the offset added
+    int moved[256];
+    int i, n, y;
+
+    // make sure that 0 <= offset < period
+    if (period > 0)
+    {
+        offset %= period;
+        if (offset < 0) offset += period;
+    }
+    else
+        offset = 0;
+
+    for (y = -table->r; y < table->r; y++)
+    {
+        SPHERE_ROW *row = &table->rows[y + table->r];
+        int *p = row->p;
+        int x = cx + row->x1;
+        int count = row->count;
+
+        // putpixel doesn't draw outside the clipping rectangle,
+        // so neither do we
+        if (target->clip)
+        {
+            if (y + cy < target->ct || y + cy >= target->cb) continue;
+            if (x < target->cl)
+            {
+                p += target->cl - x;
+                count -= target->cl - x;
+                x = target->cl;
+            }
+            if (x + count > target->cr) count = target->cr - x;
+        }
+        if (count <= 0) continue;
+
+        if (offset == 0)
+        {
+            copy_columns (target, x, y + cy, map, row->q, p, count, direct);
+            continue;
+        }
+
+        // add the offset to a piece of the line at a time
+        while (count > 0)
+        {
+            n = count < 256 ? count : 256;
+            for (i = 0; i < n; i++)
+            {
+                moved[i] = p[i] + offset;
+                if (moved[i] > period) moved[i] -= period;
+            }
+            copy_columns (target, x, y + cy, map, row->q, moved, n, direct);
+            x += n;
+            p += n;
+            count -= n;
+        }
+    }
+}
+
+void set_sphere_cache_budget (int bytes)
+{
+    cache_budget = bytes;
+    shrink_cache ();
+}
+
+int get_sphere_cache_budget ()
+{
+    return cache_budget;
+}
+
+void clear_sphere_cache ()
+{
+    while (newest)
+    {
+        SPHERE_TABLE *table = newest;
+        unlink_table (table);
+        destroy_sphere_table (table);
+    }
+    cache_size = 0;
+}
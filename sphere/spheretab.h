@@ -0,0 +1,72 @@
+/*
+   SPHERETAB.H
+   written by Martijn van Iersel (Amarillion)
+
+   mapped_sphere() (SPHERE 2) calculates two arcsines and a division for
+   every pixel, just to find out which pixel of the map goes there.
+   But for a given radius and map size, the answer is always the same.
+   A SPHERE_TABLE remembers the map position of every pixel of the
+   sphere, so drawing it again only means copying pixels.
+
+   Tables are kept in a cache, so a program that draws spheres of a
+   couple of different sizes only calculates each table once. When the
+   cache grows over its memory budget, the tables that were used least
+   recently are thrown away.
+*/
+
+#ifndef SPHERETAB_H
+#define SPHERETAB_H
+
+#include <allegro.h>
+
+// a single line of a sphere
+typedef struct SPHERE_ROW
+{
+    int x1, count; // the line starts at cx + x1 and is count pixels long
+    int q; // the line of the map these pixels come from
+    int *p; // for each pixel, the column of the map
+} SPHERE_ROW;
+
+typedef struct SPHERE_TABLE
+{
+    // what the table was calculated for
+    int r, map_w, map_h;
+    // 2 * r lines, the first one is at cy - r
+    SPHERE_ROW *rows;
+    int size; // memory used, in bytes
+
+    // the cache keeps the tables in a list, most recently used first
+    struct SPHERE_TABLE *prev, *next;
+} SPHERE_TABLE;
+
+/* get_sphere_table() returns the table for a sphere of radius r and a map
+   of map_w x map_h pixels, from the cache if possible. The table stays
+   valid until the next call to get_sphere_table() or clear_sphere_cache().
+   returns NULL if r <= 0 or if there is not enough memory. */
+SPHERE_TABLE *get_sphere_table (int r, int map_w, int map_h);
+
+/* draw_sphere_table() draws the sphere of the table with its center at
+   (cx, cy). With offset 0 the result is exactly the same as that of
+   mapped_sphere(). map must have the size the table was made for.
+
+   offset is added to every column of the map, and wraps around after
+   map_w - 1 columns. That turns the planet around its axis, like
+   sphere_spin_offset() below. */
+void draw_sphere_table (BITMAP *target, int cx, int cy,
+    SPHERE_TABLE *table, BITMAP *map, int offset);
+
+/* sphere_spin_offset() returns the offset for draw_sphere_table() that
+   turns a planet with a map of map_w columns by angle around its axis.
+   angle is in the same units as fixsin() uses, 256 is a full circle. */
+int sphere_spin_offset (fixed angle, int map_w);
+
+/* The memory budget of the cache in bytes, 32 MB by default.
+   A table that is larger than the budget on its own is still kept,
+   but then it is the only one. */
+void set_sphere_cache_budget (int bytes);
+int get_sphere_cache_budget ();
+
+// throws away all tables
+void clear_sphere_cache ();
+
+#endif
@@ -0,0 +1,319 @@
+/*
+   SPHEREVEC.C
+   written by Martijn van Iersel (Amarillion)
+
+   See spherevec.h
+*/
+
+#include <stdint.h>
+#include <math.h>
+#include <allegro.h>
+#include "spherevec.h"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define SPHERE_VEC_X86
+#include <immintrin.h>
+#endif
+
+#define PI_F 3.14159265f
+
+// the number of pixels we work out at a time
+#define CHUNK 256
+
+// FALSE if set_sphere_vec_simd (FALSE) was called
+static int use_simd = TRUE;
+
+/*
+    The rotation and the sizes for a single sphere, as floats.
+    u_scale and v_scale turn an angle into a map column or line.
+*/
+typedef struct SPHERE_VEC
+{
+    float m[3][3];
+    float r, r2;
+    float u_scale, v_scale;
+    int max_p, max_q;
+} SPHERE_VEC;
+
+/*
+    atan_poly() is a polynomial that is close to atan (t) for t from 0
+    to 1, with an error of at most 0.00001 (Abramowitz and Stegun 4.4.49).
+    atan2_poly() and asin_poly() are built on top of it.
+    The SIMD version below does exactly the same steps.
+*/
+static float atan_poly (float t)
+{
+    float s = t * t;
+    return t * (0.9998660f + s * (-0.3302995f + s * (0.1801410f +
+        s * (-0.0851330f + s * 0.0208351f))));
+}
+
+static float atan2_poly (float y, float x)
+{
+    float ax = fabsf (x), ay = fabsf (y);
+    float big = ax > ay ? ax : ay;
+    float small = ax > ay ? ay : ax;
+    float a = atan_poly (big > 0 ? small / big : 0);
+    if (ay > ax) a = PI_F / 2 - a;
+    if (x < 0) a = PI_F - a;
+    if (y < 0) a = -a;
+    return a;
+}
+
+// asin (v) is the angle of a point at height v on a circle of radius 1
+static float asin_poly (float v)
+{
+    float c = 1 - v * v;
+    return atan2_poly (v, c > 0 ? sqrtf (c) : 0);
+}
+
+/*
+    sphere_pixel() works out the map position of pixel (x, y) of the
+    sphere. It is the float version of the inner loop of mapped_sphere_ex():
+    rotate the point on the sphere surface, then p comes from the angle
+    around the axis and q from the angle above the equator.
+*/
+static void sphere_pixel (const SPHERE_VEC *s, float x, float y, int *p, int *q)
+{
+    float z2 = s->r2 - x * x - y * y;
+    float z = z2 > 0 ? sqrtf (z2) : 0;
+    float newx = s->m[0][0] * x + s->m[0][1] * y + s->m[0][2] * z;
+    float newy = s->m[1][0] * x + s->m[1][1] * y + s->m[1][2] * z;
+    float newz = s->m[2][0] * x + s->m[2][1] * y + s->m[2][2] * z;
+    float v = newy / s->r;
+    float u = atan2_poly (newx, newz);
+
+    // the angle around the axis goes from -PI to PI, but the map
+    // starts at 0, so the negative half moves one turn ahead
+    if (u < 0) u += 2 * PI_F;
+    if (v > 1) v = 1;
+    if (v < -1) v = -1;
+    *p = (int)(u * s->u_scale + 0.5f);
+    *q = (int)((asin_poly (v) + PI_F / 2) * s->v_scale + 0.5f);
+    if (*p > s->max_p) *p = s->max_p;
+    if (*q > s->max_q) *q = s->max_q;
+}
+
+#ifdef SPHERE_VEC_X86
+
+__attribute__((target("avx2,fma")))
+static __m256 atan_poly8 (__m256 t)
+{
+    __m256 s = _mm256_mul_ps (t, t);
+    __m256 a = _mm256_set1_ps (0.0208351f);
+    a = _mm256_fmadd_ps (a, s, _mm256_set1_ps (-0.0851330f));
+    a = _mm256_fmadd_ps (a, s, _mm256_set1_ps (0.1801410f));
+    a = _mm256_fmadd_ps (a, s, _mm256_set1_ps (-0.3302995f));
+    a = _mm256_fmadd_ps (a, s, _mm256_set1_ps (0.9998660f));
+    return _mm256_mul_ps (a, t);
+}
+
+__attribute__((target("avx2,fma")))
+static __m256 atan2_poly8 (__m256 y, __m256 x)
+{
+    __m256 sign = _mm256_set1_ps (-0.0f);
+    __m256 zero = _mm256_setzero_ps ();
+    __m256 ax = _mm256_andnot_ps (sign, x), ay = _mm256_andnot_ps (sign, y);
+    __m256 big = _mm256_max_ps (ax, ay);
+    __m256 small = _mm256_min_ps (ax, ay);
+    __m256 t = _mm256_and_ps (_mm256_div_ps (small, big),
+        _mm256_cmp_ps (big, zero, _CMP_GT_OQ));
+    __m256 a = atan_poly8 (t);
+    a = _mm256_blendv_ps (a, _mm256_sub_ps (_mm256_set1_ps (PI_F / 2), a),
+        _mm256_cmp_ps (ay, ax, _CMP_GT_OQ));
+    a = _mm256_blendv_ps (a, _mm256_sub_ps (_mm256_set1_ps (PI_F), a),
+        _mm256_cmp_ps (x, zero, _CMP_LT_OQ));
+    a = _mm256_blendv_ps (a, _mm256_sub_ps (zero, a),
+        _mm256_cmp_ps (y, zero, _CMP_LT_OQ));
+    return a;
+}
+
+/*
+    sphere_pixels_avx2() does what sphere_pixel() does, for count pixels
+    of line y starting at x. It returns how many pixels it has done,
+    a multiple of 8; the rest is left to sphere_pixel().
+*/
+__attribute__((target("avx2,fma")))
+static int sphere_pixels_avx2 (const SPHERE_VEC *s, int x, int y, int count,
+    int *p, int *q)
+{
+    __m256 vx = _mm256_add_ps (_mm256_set1_ps ((float)x),
+        _mm256_setr_ps (0, 1, 2, 3, 4, 5, 6, 7));
+    __m256 vy = _mm256_set1_ps ((float)y);
+    __m256 eight = _mm256_set1_ps (8);
+    __m256 zero = _mm256_setzero_ps ();
+    __m256 one = _mm256_set1_ps (1);
+    __m256 half = _mm256_set1_ps (0.5f);
+    __m256 r2_y2 = _mm256_set1_ps (s->r2 - (float)y * y);
+    __m256 inv_r = _mm256_set1_ps (1 / s->r);
+    __m256i max_p = _mm256_set1_epi32 (s->max_p);
+    __m256i max_q = _mm256_set1_epi32 (s->max_q);
+    int i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        __m256 z2 = _mm256_fnmadd_ps (vx, vx, r2_y2);
+        __m256 z = _mm256_sqrt_ps (_mm256_max_ps (z2, zero));
+        __m256 newx = _mm256_fmadd_ps (_mm256_set1_ps (s->m[0][2]), z,
+            _mm256_fmadd_ps (_mm256_set1_ps (s->m[0][1]), vy,
+            _mm256_mul_ps (_mm256_set1_ps (s->m[0][0]), vx)));
+        __m256 newy = _mm256_fmadd_ps (_mm256_set1_ps (s->m[1][2]), z,
+            _mm256_fmadd_ps (_mm256_set1_ps (s->m[1][1]), vy,
+            _mm256_mul_ps (_mm256_set1_ps (s->m[1][0]), vx)));
+        __m256 newz = _mm256_fmadd_ps (_mm256_set1_ps (s->m[2][2]), z,
+            _mm256_fmadd_ps (_mm256_set1_ps (s->m[2][1]), vy,
+            _mm256_mul_ps (_mm256_set1_ps (s->m[2][0]), vx)));
+        __m256 v = _mm256_mul_ps (newy, inv_r);
+        __m256 u = atan2_poly8 (newx, newz);
+        __m256 c;
+        __m256i vp, vq;
+
+        u = _mm256_add_ps (u, _mm256_and_ps (_mm256_set1_ps (2 * PI_F),
+            _mm256_cmp_ps (u, zero, _CMP_LT_OQ)));
+        v = _mm256_min_ps (_mm256_max_ps (v, _mm256_set1_ps (-1)), one);
+        c = _mm256_fnmadd_ps (v, v, one);
+        v = atan2_poly8 (v, _mm256_sqrt_ps (_mm256_max_ps (c, zero)));
+
+        vp = _mm256_cvttps_epi32 (_mm256_fmadd_ps (u,
+            _mm256_set1_ps (s->u_scale), half));
+        vq = _mm256_cvttps_epi32 (_mm256_fmadd_ps (
+            _mm256_add_ps (v, _mm256_set1_ps (PI_F / 2)),
+            _mm256_set1_ps (s->v_scale), half));
+        _mm256_storeu_si256 ((__m256i *)(p + i), _mm256_min_epi32 (vp, max_p));
+        _mm256_storeu_si256 ((__m256i *)(q + i), _mm256_min_epi32 (vq, max_q));
+
+        vx = _mm256_add_ps (vx, eight);
+    }
+    return i;
+}
+
+#endif
+
+int sphere_vec_simd_supported ()
+{
+#ifdef SPHERE_VEC_X86
+    return __builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma");
+#else
+    return FALSE;
+#endif
+}
+
+void set_sphere_vec_simd (int enable)
+{
+    use_simd = enable;
+}
+
+/*
+    copy_texels() copies count pixels from the map to line y of the
+    target, starting at x. Pixel i comes from (p[i], q[i]).
+*/
+static void copy_texels (BITMAP *target, int x, int y, BITMAP *map,
+    const int *p, const int *q, int count, int direct)
+{
+    int i;
+
+    if (!direct)
+    {
+        for (i = 0; i < count; i++)
+            putpixel (target, x + i, y, getpixel (map, p[i], q[i]));
+        return;
+    }
+
+    switch (bitmap_color_depth (target))
+    {
+        case 8:
+        {
+            unsigned char *d = target->line[y] + x;
+            for (i = 0; i < count; i++)
+                d[i] = map->line[q[i]][p[i]];
+            break;
+        }
+        case 15:
+        case 16:
+        {
+            uint16_t *d = (uint16_t *)target->line[y] + x;
+            for (i = 0; i < count; i++)
+                d[i] = ((uint16_t *)map->line[q[i]])[p[i]];
+            break;
+        }
+        case 24:
+        {
+            // 24 bit pixels are 3 bytes, there is no type for that
+            unsigned char *d = target->line[y] + x * 3;
+            unsigned char *s;
+            for (i = 0; i < count; i++)
+            {
+                s = map->line[q[i]] + p[i] * 3;
+                d[0] = s[0];
+                d[1] = s[1];
+                d[2] = s[2];
+                d += 3;
+            }
+            break;
+        }
+        case 32:
+        {
+            uint32_t *d = (uint32_t *)target->line[y] + x;
+            for (i = 0; i < count; i++)
+                d[i] = ((uint32_t *)map->line[q[i]])[p[i]];
+            break;
+        }
+    }
+}
+
+void mapped_sphere_vec (BITMAP *target, int cx, int cy, int r, BITMAP *map,
+    MATRIX *rotmat)
+{
+    // direct access to line[] only works on memory bitmaps
+    // of the same color depth
+    int direct = is_memory_bitmap (target) && is_memory_bitmap (map) &&
+        bitmap_color_depth (target) == bitmap_color_depth (map);
+    int simd = use_simd && sphere_vec_simd_supported ();
+    int p[CHUNK], q[CHUNK];
+    SPHERE_VEC s;
+    int i, j, n, x, y, x1, x2;
+
+    if (r <= 0) return;
+
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 3; j++)
+            s.m[i][j] = fixtof (rotmat->v[i][j]);
+    s.r = r;
+    s.r2 = (float)r * r;
+    // the same scale as in mapped_sphere_ex: a full turn is map->w - 1
+    // columns, and from pole to pole is map->h - 1 lines
+    s.u_scale = (map->w - 1) / (2 * PI_F);
+    s.v_scale = (map->h - 1) / PI_F;
+    s.max_p = map->w - 1;
+    s.max_q = map->h - 1;
+
+    for (y = -r; y < r; y++)
+    {
+        // the same lines as mapped_sphere_ex draws
+        fixed q_cos = fixcos (- fixasin (itofix (y) / r)) * r;
+        x1 = - fixtoi (q_cos) + 1;
+        x2 = fixtoi (q_cos) - 1;
+
+        // putpixel doesn't draw outside the clipping rectangle,
+        // so neither do we
+        if (target->clip)
+        {
+            if (y + cy < target->ct || y + cy >= target->cb) continue;
+            if (x1 + cx < target->cl) x1 = target->cl - cx;
+            if (x2 + cx > target->cr) x2 = target->cr - cx;
+        }
+
+        for (x = x1; x < x2; x += n)
+        {
+            n = x2 - x < CHUNK ? x2 - x : CHUNK;
+            i = 0;
+#ifdef SPHERE_VEC_X86
+            if (simd)
+                i = sphere_pixels_avx2 (&s, x, y, n, p, q);
+#endif
+            for (; i < n; i++)
+                sphere_pixel (&s, x + i, y, &p[i], &q[i]);
+            copy_texels (target, x + cx, y + cy, map, p, q, n, direct);
+        }
+    }
+}
@@ -0,0 +1,45 @@
+/*
+   SPHEREVEC.H
+   written by Martijn van Iersel (Amarillion)
+
+   mapped_sphere_ex() (SPHERE 3) works out a square root, a matrix,
+   an arctangent, an arcsine and two divisions in fixed point math for
+   every pixel, one pixel at a time. mapped_sphere_vec() does the same
+   work with floats, on 8 pixels at once when the processor has AVX2.
+
+   Instead of the library functions it uses polynomial approximations
+   of atan2 and asin, which are easy to do on 8 floats at a time.
+   Square roots are cheap on floats, so those are exact.
+   The angles are off by less than 0.0001 radians, far less than the
+   size of a pixel on the map, but the result is not exactly the same as
+   that of mapped_sphere_ex(): some pixels come from the column or line
+   next to it.
+
+   Floats also don't overflow: in mapped_sphere_ex() r * r has to fit in
+   a fixed, so it can't draw spheres with a radius over 181.
+*/
+
+#ifndef SPHEREVEC_H
+#define SPHEREVEC_H
+
+#include <allegro.h>
+
+/* mapped_sphere_vec() maps a bitmap onto a rotated sphere, just like
+   mapped_sphere_ex().
+
+   BITMAP *target = bitmap to display onto
+   int cx, cy = center of the sphere
+   int r = radius of the sphere
+   BITMAP *map = bitmap to map onto the sphere
+   MATRIX *rotmat = rotation matrix
+*/
+void mapped_sphere_vec (BITMAP *target, int cx, int cy, int r, BITMAP *map,
+    MATRIX *rotmat);
+
+/* Normally mapped_sphere_vec() uses AVX2 if the processor has it.
+   set_sphere_vec_simd (FALSE) makes it use plain C instead, for example
+   to compare them. Apart from rounding, both give the same result. */
+int sphere_vec_simd_supported ();
+void set_sphere_vec_simd (int enable);
+
+#endif
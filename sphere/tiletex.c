@@ -0,0 +1,445 @@
+/*
+   TILETEX.C
+   written by Martijn van Iersel (Amarillion)
+
+   See tiletex.h
+*/
+
+// maps can be larger than 2 GB, so we need 64 bit file offsets
+#define _FILE_OFFSET_BITS 64
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <allegro.h>
+#include "tiletex.h"
+
+#if defined(_WIN32)
+    #include <winalleg.h>
+    #define MAP_WIN32
+#elif defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #define MAP_POSIX
+#endif
+// anything else (DOS) reads the tiles with fread() instead
+
+#if defined(_WIN32)
+    #define fseek64 _fseeki64
+#elif defined(MAP_POSIX)
+    #define fseek64 fseeko
+#else
+    #define fseek64 fseek
+#endif
+
+#define HEADER_SIZE 4096
+#define PAGE_SIZE 4096
+#define RELEASE_SIZE 65536
+
+static void put32 (unsigned char *buf, int value)
+{
+    buf[0] = value & 0xFF;
+    buf[1] = (value >> 8) & 0xFF;
+    buf[2] = (value >> 16) & 0xFF;
+    buf[3] = (value >> 24) & 0xFF;
+}
+
+static int get32 (const unsigned char *buf)
+{
+    return (int)(buf[0] | (buf[1] << 8) | (buf[2] << 16) |
+        ((unsigned int)buf[3] << 24));
+}
+
+static int get16 (const unsigned char *buf)
+{
+    return buf[0] | (buf[1] << 8);
+}
+
+// returns log2 of tile_size, or -1 if it is not a power of two
+static int get_tile_shift (int tile_size)
+{
+    int shift = 0;
+    if (tile_size <= 0 || (tile_size & (tile_size - 1))) return -1;
+    while ((1 << shift) < tile_size) shift++;
+    return shift;
+}
+
+static int get_tile_bytes (int tile_size)
+{
+    int bytes = tile_size * tile_size * 3;
+    return (bytes + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+}
+
+static long long tile_offset (int index, int tile_bytes)
+{
+    return HEADER_SIZE + (long long)index * tile_bytes;
+}
+
+static int write_header (FILE *f, int w, int h, int tile_size)
+{
+    unsigned char header[HEADER_SIZE];
+    memset (header, 0, HEADER_SIZE);
+    memcpy (header, "TTEX", 4);
+    put32 (header + 4, 1);
+    put32 (header + 8, w);
+    put32 (header + 12, h);
+    put32 (header + 16, tile_size);
+    put32 (header + 20, get_tile_bytes (tile_size));
+    return fwrite (header, HEADER_SIZE, 1, f) == 1 ? 0 : -1;
+}
+
+/*
+    write_tile_row() writes one row of tiles. band holds tile_size lines
+    of tiles_w * tile_size pixels, 3 bytes each.
+*/
+static int write_tile_row (FILE *f, const unsigned char *band, int tiles_w,
+    int tile_size)
+{
+    int tile_bytes = get_tile_bytes (tile_size);
+    int line = tiles_w * tile_size * 3;
+    unsigned char *tile = calloc (tile_bytes, 1);
+    int tx, y, result = 0;
+
+    if (!tile) return -1;
+    for (tx = 0; tx < tiles_w && result == 0; tx++)
+    {
+        for (y = 0; y < tile_size; y++)
+            memcpy (tile + y * tile_size * 3,
+                band + y * line + tx * tile_size * 3, tile_size * 3);
+        if (fwrite (tile, tile_bytes, 1, f) != 1) result = -1;
+    }
+    free (tile);
+    return result;
+}
+
+int convert_bmp_to_tiled (const char *bmp_name, const char *tex_name,
+    int tile_size)
+{
+    unsigned char header[54];
+    unsigned char *band = NULL, *line = NULL;
+    FILE *in, *out = NULL;
+    int w, h, bpp, top_down, stride, data_start;
+    int tiles_w, band_line;
+    int i, x, row, result = -1;
+
+    if (get_tile_shift (tile_size) < 0) return -1;
+    in = fopen (bmp_name, "rb");
+    if (!in) return -1;
+    if (fread (header, 54, 1, in) != 1 || header[0] != 'B' || header[1] != 'M')
+        goto done;
+
+    data_start = get32 (header + 10);
+    w = get32 (header + 18);
+    h = get32 (header + 22);
+    bpp = get16 (header + 28);
+    // only uncompressed bitmaps, or 32 bit ones with the usual bit fields
+    if (!(get32 (header + 30) == 0 || (get32 (header + 30) == 3 && bpp == 32)))
+        goto done;
+    if (bpp != 24 && bpp != 32) goto done;
+    // a negative height means the lines are stored from the top down
+    top_down = h < 0;
+    if (top_down) h = -h;
+    if (w <= 0 || h <= 0) goto done;
+    stride = ((w * bpp / 8) + 3) & ~3;
+
+    tiles_w = (w + tile_size - 1) / tile_size;
+    band_line = tiles_w * tile_size * 3;
+    band = malloc ((size_t)band_line * tile_size);
+    line = malloc (stride);
+    out = fopen (tex_name, "wb");
+    if (!band || !line || !out) goto done;
+    if (write_header (out, w, h, tile_size) != 0) goto done;
+    if (fseek64 (in, data_start, SEEK_SET) != 0) goto done;
+
+    // the lines come in the order they are in the file. Each time a band
+    // of tile_size lines is complete, that row of tiles is written.
+    memset (band, 0, (size_t)band_line * tile_size);
+    for (i = 0; i < h; i++)
+    {
+        unsigned char *dest;
+        int ty;
+        row = top_down ? i : h - 1 - i;
+        if (fread (line, stride, 1, in) != 1) goto done;
+        dest = band + (row % tile_size) * band_line;
+        // BMP stores blue, green, red
+        for (x = 0; x < w; x++)
+        {
+            dest[x * 3] = line[x * bpp / 8 + 2];
+            dest[x * 3 + 1] = line[x * bpp / 8 + 1];
+            dest[x * 3 + 2] = line[x * bpp / 8];
+        }
+
+        // is this the last line of its band?
+        ty = row / tile_size;
+        if (top_down ? (row % tile_size == tile_size - 1 || row == h - 1)
+                     : (row % tile_size == 0))
+        {
+            if (fseek64 (out, tile_offset (ty * tiles_w,
+                get_tile_bytes (tile_size)), SEEK_SET) != 0)
+                goto done;
+            if (write_tile_row (out, band, tiles_w, tile_size) != 0)
+                goto done;
+            memset (band, 0, (size_t)band_line * tile_size);
+        }
+    }
+    result = 0;
+
+done:
+    if (out && fclose (out) != 0) result = -1;
+    fclose (in);
+    free (band);
+    free (line);
+    return result;
+}
+
+int save_tiled_texture (const char *tex_name, BITMAP *bmp, int tile_size)
+{
+    FILE *out;
+    unsigned char *band;
+    int tiles_w, tiles_h, band_line;
+    int depth = bitmap_color_depth (bmp);
+    int x, y, ty, result = 0;
+
+    if (get_tile_shift (tile_size) < 0) return -1;
+    tiles_w = (bmp->w + tile_size - 1) / tile_size;
+    tiles_h = (bmp->h + tile_size - 1) / tile_size;
+    band_line = tiles_w * tile_size * 3;
+    band = malloc ((size_t)band_line * tile_size);
+    out = fopen (tex_name, "wb");
+    if (!band || !out || write_header (out, bmp->w, bmp->h, tile_size) != 0)
+        result = -1;
+
+    for (ty = 0; ty < tiles_h && result == 0; ty++)
+    {
+        memset (band, 0, (size_t)band_line * tile_size);
+        for (y = 0; y < tile_size && ty * tile_size + y < bmp->h; y++)
+        {
+            unsigned char *dest = band + y * band_line;
+            for (x = 0; x < bmp->w; x++)
+            {
+                int color = getpixel (bmp, x, ty * tile_size + y);
+                dest[x * 3] = getr_depth (depth, color);
+                dest[x * 3 + 1] = getg_depth (depth, color);
+                dest[x * 3 + 2] = getb_depth (depth, color);
+            }
+        }
+        result = write_tile_row (out, band, tiles_w, tile_size);
+    }
+
+    if (out && fclose (out) != 0) result = -1;
+    free (band);
+    return result;
+}
+
+/*
+    map_file() maps the whole file into memory, or opens it for reading
+    if this platform can't do that. returns 0 on success.
+*/
+static int map_file (TILED_TEXTURE *tex, const char *tex_name)
+{
+#if defined(MAP_WIN32)
+    HANDLE file, mapping;
+    LARGE_INTEGER size;
+    file = CreateFile (tex_name, GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return -1;
+    if (!GetFileSizeEx (file, &size) ||
+        !(mapping = CreateFileMapping (file, NULL, PAGE_READONLY, 0, 0, NULL)))
+    {
+        CloseHandle (file);
+        return -1;
+    }
+    // the view keeps the file open, so the handles are not needed anymore
+    tex->data = MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle (mapping);
+    CloseHandle (file);
+    if (!tex->data) return -1;
+    tex->data_size = size.QuadPart;
+    return 0;
+#elif defined(MAP_POSIX)
+    struct stat st;
+    void *data;
+    int fd = open (tex_name, O_RDONLY);
+    if (fd < 0) return -1;
+    if (fstat (fd, &st) != 0)
+    {
+        close (fd);
+        return -1;
+    }
+    data = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping keeps the file open
+    close (fd);
+    if (data == MAP_FAILED) return -1;
+    // we jump around in the file, reading ahead would only fill our memory
+    madvise (data, st.st_size, MADV_RANDOM);
+    tex->data = data;
+    tex->data_size = st.st_size;
+    return 0;
+#else
+    FILE *f = fopen (tex_name, "rb");
+    if (!f) return -1;
+    fseek64 (f, 0, SEEK_END);
+    tex->data_size = ftell (f);
+    tex->file = f;
+    tex->data = NULL;
+    return 0;
+#endif
+}
+
+static void unmap_file (TILED_TEXTURE *tex)
+{
+#if defined(MAP_WIN32)
+    UnmapViewOfFile ((void *)tex->data);
+#elif defined(MAP_POSIX)
+    munmap ((void *)tex->data, tex->data_size);
+#else
+    fclose (tex->file);
+#endif
+}
+
+/*
+    read_bytes() returns a pointer to size bytes at offset in the file.
+    Without a memory mapping they are read into buffer.
+*/
+static const unsigned char *read_bytes (TILED_TEXTURE *tex, long long offset,
+    int size, unsigned char *buffer)
+{
+#if defined(MAP_WIN32) || defined(MAP_POSIX)
+    return tex->data + offset;
+#else
+    if (fseek64 (tex->file, offset, SEEK_SET) != 0 ||
+        fread (buffer, size, 1, tex->file) != 1)
+        memset (buffer, 0, size);
+    return buffer;
+#endif
+}
+
+/*
+    release_bytes() tells the operating system we're done with these bytes.
+    The pages are dropped from our memory, the converted tile is in the
+    cache now. Otherwise every page we ever looked at would stay mapped.
+*/
+static void release_bytes (TILED_TEXTURE *tex, long long offset, int size)
+{
+#if defined(MAP_POSIX)
+    // Linux also maps in the pages around the one we asked for, up to
+    // 64 KB, so those have to go too
+    long long start = offset & ~(long long)(RELEASE_SIZE - 1);
+    long long end = (offset + size + RELEASE_SIZE - 1) & ~(long long)(RELEASE_SIZE - 1);
+    if (end > tex->data_size) end = tex->data_size;
+    madvise ((void *)(tex->data + start), end - start, MADV_DONTNEED);
+#endif
+}
+
+TILED_TEXTURE *open_tiled_texture (const char *tex_name, int depth,
+    int cache_tiles)
+{
+    TILED_TEXTURE *tex = calloc (1, sizeof (TILED_TEXTURE));
+    unsigned char buffer[24];
+    const unsigned char *header;
+    int i;
+
+    if (!tex) return NULL;
+    if (map_file (tex, tex_name) != 0)
+    {
+        free (tex);
+        return NULL;
+    }
+    if (tex->data_size < HEADER_SIZE) goto fail;
+    header = read_bytes (tex, 0, 24, buffer);
+    if (memcmp (header, "TTEX", 4) != 0 || get32 (header + 4) != 1) goto fail;
+    tex->w = get32 (header + 8);
+    tex->h = get32 (header + 12);
+    tex->tile_size = get32 (header + 16);
+    tex->tile_bytes = get32 (header + 20);
+    tex->tile_shift = get_tile_shift (tex->tile_size);
+    if (tex->w <= 0 || tex->h <= 0 || tex->tile_shift < 0 ||
+        tex->tile_bytes < tex->tile_size * tex->tile_size * 3)
+        goto fail;
+    tex->tiles_w = (tex->w + tex->tile_size - 1) / tex->tile_size;
+    tex->tiles_h = (tex->h + tex->tile_size - 1) / tex->tile_size;
+    // is the file complete?
+    if (tex->data_size < tile_offset (tex->tiles_w * tex->tiles_h, tex->tile_bytes))
+        goto fail;
+
+    tex->depth = depth;
+    tex->num_slots = cache_tiles > 0 ? cache_tiles : 1;
+    tex->slots = calloc (tex->num_slots, sizeof (TEXTURE_TILE));
+    if (!tex->slots) goto fail;
+    for (i = 0; i < tex->num_slots; i++)
+    {
+        tex->slots[i].index = -1;
+        tex->slots[i].pixels = malloc (tex->tile_size * tex->tile_size * sizeof (int));
+        if (!tex->slots[i].pixels) goto fail;
+    }
+    tex->last = &tex->slots[0];
+    return tex;
+
+fail:
+    close_tiled_texture (tex);
+    return NULL;
+}
+
+void close_tiled_texture (TILED_TEXTURE *tex)
+{
+    int i;
+    if (tex->slots)
+    {
+        for (i = 0; i < tex->num_slots; i++)
+            free (tex->slots[i].pixels);
+        free (tex->slots);
+    }
+    unmap_file (tex);
+    free (tex);
+}
+
+/*
+    load_tile() converts tile index from the file to the color depth of
+    the texture and puts it in the cache.
+*/
+static TEXTURE_TILE *load_tile (TILED_TEXTURE *tex, int index)
+{
+    // neighbouring tiles get different slots
+    TEXTURE_TILE *tile = &tex->slots[(unsigned int)index * 2654435761u
+        % (unsigned int)tex->num_slots];
+    long long offset;
+    unsigned char *buffer = NULL;
+    const unsigned char *src;
+    int i, count;
+
+    if (tile->index == index)
+    {
+        tex->hits++;
+        return tile;
+    }
+    tex->misses++;
+
+    offset = tile_offset (index, tex->tile_bytes);
+#if !defined(MAP_WIN32) && !defined(MAP_POSIX)
+    buffer = malloc (tex->tile_bytes);
+#endif
+    src = read_bytes (tex, offset, tex->tile_bytes, buffer);
+    count = tex->tile_size * tex->tile_size;
+    for (i = 0; i < count; i++)
+        tile->pixels[i] = makecol_depth (tex->depth,
+            src[i * 3], src[i * 3 + 1], src[i * 3 + 2]);
+    release_bytes (tex, offset, tex->tile_bytes);
+    free (buffer);
+    tile->index = index;
+    return tile;
+}
+
+int tiled_getpixel (TILED_TEXTURE *tex, int x, int y)
+{
+    int index, mask = tex->tile_size - 1;
+    TEXTURE_TILE *tile;
+
+    if (x < 0 || y < 0 || x >= tex->w || y >= tex->h) return -1;
+    index = (y >> tex->tile_shift) * tex->tiles_w + (x >> tex->tile_shift);
+    tile = tex->last;
+    if (tile->index != index)
+        tex->last = tile = load_tile (tex, index);
+    return tile->pixels[((y & mask) << tex->tile_shift) + (x & mask)];
+}
@@ -0,0 +1,95 @@
+/*
+   TILETEX.H
+   written by Martijn van Iersel (Amarillion)
+
+   load_bitmap() reads the whole map into memory before we can draw a
+   single pixel. That's fine for earth.bmp, but a planet map of
+   64k x 32k pixels takes 6 GB as a 24 bit bitmap.
+
+   A tiled texture keeps the map on disk, cut up in square tiles. The
+   file is mapped into memory, so the operating system only reads the
+   parts we actually look at. The tiles we used most recently are
+   kept in a small cache, already converted to the color depth we
+   draw in. Opening a texture and drawing from it then takes the same
+   time and memory, no matter how large the map is.
+
+   The file starts with a header of 4096 bytes:
+       "TTEX"            magic
+       int version       1
+       int w, h          size of the map in pixels
+       int tile_size     width and height of a tile, a power of two
+       int tile_bytes    space used by each tile in the file
+   followed by the tiles, from left to right and top to bottom. Each
+   tile holds tile_size lines of tile_size pixels, 3 bytes per pixel
+   in the order red, green, blue. Tiles on the right and bottom edge
+   are padded with black. tile_bytes is rounded up to 4096, so every
+   tile starts on a new page. All ints are 32 bit, little endian.
+
+   Note that mapped_lit_sphere_tiled() (SPHERE 5) looks the map up with
+   whole angles, so it only ever uses 256 x 128 pixels of it, however
+   large it is (see litsphere.h). What a large texture saves there is
+   the time and memory to load it, not detail on the screen.
+*/
+
+#ifndef TILETEX_H
+#define TILETEX_H
+
+#include <allegro.h>
+
+// a tile of the cache, converted to the color depth of the texture
+typedef struct TEXTURE_TILE
+{
+    int index; // which tile of the map this is, -1 if none
+    int *pixels; // tile_size * tile_size colors
+} TEXTURE_TILE;
+
+typedef struct TILED_TEXTURE
+{
+    int w, h; // size of the map, like BITMAP
+    int depth; // color depth of the colors tiled_getpixel() returns
+    int tile_size, tile_shift; // tile_size == 1 << tile_shift
+    int tiles_w, tiles_h; // number of tiles across and down
+    int tile_bytes;
+
+    // the file, mapped into memory
+    const unsigned char *data;
+    long long data_size;
+    void *file; // used by the platform specific code
+
+    // the cache. A tile can only go in one slot, chosen by its position
+    TEXTURE_TILE *slots;
+    int num_slots;
+    // the last tile we used, most pixels come from the same tile
+    TEXTURE_TILE *last;
+
+    // statistics
+    int hits, misses;
+} TILED_TEXTURE;
+
+/* convert_bmp_to_tiled() converts an uncompressed 24 or 32 bit BMP file
+   to a tiled texture with tiles of tile_size x tile_size pixels.
+   tile_size must be a power of two, 64 is a good choice.
+   The BMP is read a row of tiles at a time, so the bitmap is never
+   in memory as a whole.
+   returns 0 on success. */
+int convert_bmp_to_tiled (const char *bmp_name, const char *tex_name,
+    int tile_size);
+
+/* save_tiled_texture() does the same for a bitmap that is already
+   in memory. returns 0 on success. */
+int save_tiled_texture (const char *tex_name, BITMAP *bmp, int tile_size);
+
+/* open_tiled_texture() opens a tiled texture. tiled_getpixel() will
+   return colors of the given color depth. The cache holds cache_tiles
+   tiles, about 16 KB each if tile_size is 64.
+   returns NULL if the file can't be opened or is not a tiled texture. */
+TILED_TEXTURE *open_tiled_texture (const char *tex_name, int depth,
+    int cache_tiles);
+void close_tiled_texture (TILED_TEXTURE *tex);
+
+/* tiled_getpixel() works like getpixel() on the map: it returns the
+   color of pixel (x, y), or -1 if that is outside the map.
+   A texture must only be used by one thread at a time. */
+int tiled_getpixel (TILED_TEXTURE *tex, int x, int y);
+
+#endif